@@ -1,18 +1,47 @@
-# -------------------------------------------------
-# Project created by QtCreator 2010-09-12T16:03:46
-# -------------------------------------------------
-QT += xml
-QT -= gui
-TARGET = JapaneseDB
-TEMPLATE = lib
-CONFIG += staticlib
-SOURCES += kanji.cpp \
-    kanjidb.cpp \
-    readingmeaninggroup.cpp \
-    radicals.cpp
-HEADERS += kanji.h \
-    kanjidb.h \
-    readingmeaninggroup.h \
-    radicals.h
-OTHER_FILES += README
-FORMS += 
+# -------------------------------------------------
+# Project created by QtCreator 2010-09-12T16:03:46
+# -------------------------------------------------
+QT += xml
+QT -= gui
+TARGET = JapaneseDB
+TEMPLATE = lib
+CONFIG += staticlib
+SOURCES += kanji.cpp \
+    kanjidb.cpp \
+    readingmeaninggroup.cpp \
+    radicals.cpp \
+    wordstore.cpp \
+    edictdb.cpp \
+    enamdictdb.cpp \
+    querystatistics.cpp \
+    tracer.cpp \
+    querycache.cpp \
+    workstealingpool.cpp \
+    romaji.cpp \
+    readingindex.cpp \
+    rangeindex.cpp \
+    kanjiidset.cpp \
+    textannotator.cpp \
+    corpusstatistics.cpp \
+    querysession.cpp
+HEADERS += kanji.h \
+    kanjidb.h \
+    readingmeaninggroup.h \
+    radicals.h \
+    wordstore.h \
+    edictdb.h \
+    enamdictdb.h \
+    memoryusage.h \
+    querystatistics.h \
+    tracer.h \
+    querycache.h \
+    workstealingpool.h \
+    romaji.h \
+    readingindex.h \
+    rangeindex.h \
+    kanjiidset.h \
+    textannotator.h \
+    corpusstatistics.h \
+    querysession.h
+OTHER_FILES += README
+FORMS += 
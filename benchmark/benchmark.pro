@@ -0,0 +1,16 @@
+# -------------------------------------------------
+# KanjiDB benchmarks on synthetic dictionaries
+# build the library in the parent directory first
+# -------------------------------------------------
+QT += xml testlib
+QT -= gui
+TARGET = kanjidbbenchmark
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+INCLUDEPATH += ..
+LIBS += -L.. -lJapaneseDB
+PRE_TARGETDEPS += ../libJapaneseDB.a
+SOURCES += kanjidbbenchmark.cpp \
+    syntheticdictionary.cpp
+HEADERS += syntheticdictionary.h
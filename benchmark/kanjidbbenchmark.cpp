@@ -0,0 +1,495 @@
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTextStream>
+#include "kanjidb.h"
+#include "workstealingpool.h"
+#include "textannotator.h"
+#include "querysession.h"
+#include "syntheticdictionary.h"
+
+// one measured row, written to the JSON report at the end of the run
+struct BenchmarkResult
+{
+    QString test;
+    QString tag;
+    unsigned int scale;
+    unsigned int kanjiCount;
+    qint64 iterations;
+    double nsPerIteration;
+};
+
+// Measures the KanjiDB load and query paths on synthetic dictionaries at 1x, 10x and 100x.
+// Besides the usual QTest output, every row is appended to a JSON report,
+// kanjidb-benchmark.json or the file named by KANJIDB_BENCHMARK_JSON.
+class KanjiDBBenchmark : public QObject
+{
+    Q_OBJECT
+
+public:
+    KanjiDBBenchmark();
+    ~KanjiDBBenchmark();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void coldXmlLoad_data();
+    void coldXmlLoad();
+    void indexWrite_data();
+    void indexWrite();
+    void indexRead_data();
+    void indexRead();
+    void clear_data();
+    void clear();
+    void search_data();
+    void search();
+    void searchIds_data();
+    void searchIds();
+    void searchBatch_data();
+    void searchBatch();
+    void annotate_data();
+    void annotate();
+    void typing_data();
+    void typing();
+
+private:
+    void addScaleRows();
+    const SyntheticDictionary &dictionary(unsigned int scale);
+    KanjiDB &database(unsigned int scale);
+    const QByteArray &index(unsigned int scale);
+    void loadXml(KanjiDB &, const SyntheticDictionary &);
+    void record(unsigned int scale, qint64 iterations, qint64 nsecs);
+    static QString jsonString(const QString &);
+
+    QMap<unsigned int, SyntheticDictionary *> dictionaries;
+    QMap<unsigned int, KanjiDB *> databases;
+    QMap<unsigned int, QByteArray> indexes;
+    QList<BenchmarkResult> results;
+};
+
+static const unsigned int scales[] = {1, 10, 100};
+static const int scaleCount = sizeof(scales) / sizeof(unsigned int);
+
+KanjiDBBenchmark::KanjiDBBenchmark()
+{
+}
+
+KanjiDBBenchmark::~KanjiDBBenchmark()
+{
+    qDeleteAll(databases);
+    qDeleteAll(dictionaries);
+}
+
+const SyntheticDictionary &KanjiDBBenchmark::dictionary(unsigned int scale)
+{
+    if(!dictionaries.contains(scale))
+        dictionaries.insert(scale, new SyntheticDictionary(scale));
+    return *dictionaries.value(scale);
+}
+
+void KanjiDBBenchmark::loadXml(KanjiDB &db, const SyntheticDictionary &d)
+{
+    QBuffer kanjiDic(const_cast<QByteArray *>(&d.getKanjiDic2()));
+    kanjiDic.open(QIODevice::ReadOnly);
+    QVERIFY2(db.readKanjiDic(&kanjiDic), qPrintable(db.errorString()));
+    QBuffer radK(const_cast<QByteArray *>(&d.getRadKFileX()));
+    radK.open(QIODevice::ReadOnly | QIODevice::Text);
+    QVERIFY2(db.readRadK(&radK), qPrintable(db.errorString()));
+}
+
+KanjiDB &KanjiDBBenchmark::database(unsigned int scale)
+{
+    if(!databases.contains(scale))
+    {
+        KanjiDB *db = new KanjiDB;
+        // uncached, the search rows measure the evaluation itself
+        db->setQueryCacheSize(0);
+        loadXml(*db, dictionary(scale));
+        databases.insert(scale, db);
+    }
+    return *databases.value(scale);
+}
+
+const QByteArray &KanjiDBBenchmark::index(unsigned int scale)
+{
+    if(!indexes.contains(scale))
+    {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        database(scale).writeIndex(&buffer);
+        indexes.insert(scale, data);
+    }
+    return indexes[scale];
+}
+
+void KanjiDBBenchmark::record(unsigned int scale, qint64 iterations, qint64 nsecs)
+{
+    BenchmarkResult result;
+    result.test = QTest::currentTestFunction();
+    result.tag = QString::fromUtf8(QTest::currentDataTag());
+    result.scale = scale;
+    result.kanjiCount = dictionary(scale).getCharacterCount();
+    result.iterations = iterations;
+    result.nsPerIteration = iterations > 0 ? (double) nsecs / iterations : 0;
+    results.append(result);
+}
+
+QString KanjiDBBenchmark::jsonString(const QString &s)
+{
+    QString escaped;
+    foreach(QChar c, s)
+    {
+        if(c == '"' || c == '\\')
+            escaped.append('\\').append(c);
+        else if(c.unicode() < 0x20)
+            escaped.append(QString("\\u%1").arg(c.unicode(), 4, 16, QChar('0')));
+        else
+            escaped.append(c);
+    }
+    return "\"" + escaped + "\"";
+}
+
+void KanjiDBBenchmark::initTestCase()
+{
+    // generating the 100x data takes a while, do it before any measurement
+    for(int i = 0; i < scaleCount; ++i)
+        dictionary(scales[i]);
+}
+
+void KanjiDBBenchmark::cleanupTestCase()
+{
+    QString fileName = QString::fromLocal8Bit(qgetenv("KANJIDB_BENCHMARK_JSON"));
+    if(fileName.isEmpty())
+        fileName = "kanjidb-benchmark.json";
+    QFile file(fileName);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Text))
+    {
+        QWARN(qPrintable(QString("Cannot write %1").arg(fileName)));
+        return;
+    }
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    out << "{\n  \"suite\": \"KanjiDBBenchmark\",\n";
+    out << "  \"qtVersion\": " << jsonString(qVersion()) << ",\n";
+    out << "  \"indexVersion\": " << KanjiDB::version << ",\n";
+    out << "  \"results\": [";
+    for(int i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult &r = results.at(i);
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\"test\": " << jsonString(r.test)
+            << ", \"tag\": " << jsonString(r.tag)
+            << ", \"scale\": " << r.scale
+            << ", \"kanji\": " << r.kanjiCount
+            << ", \"iterations\": " << r.iterations
+            << ", \"nsPerIteration\": " << QString::number(r.nsPerIteration, 'f', 1) << "}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void KanjiDBBenchmark::addScaleRows()
+{
+    QTest::addColumn<unsigned int>("scale");
+    for(int i = 0; i < scaleCount; ++i)
+        QTest::newRow(qPrintable(QString("x%1").arg(scales[i]))) << scales[i];
+}
+
+void KanjiDBBenchmark::coldXmlLoad_data()
+{
+    addScaleRows();
+}
+
+void KanjiDBBenchmark::coldXmlLoad()
+{
+    QFETCH(unsigned int, scale);
+    const SyntheticDictionary &d = dictionary(scale);
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        KanjiDB db;
+        loadXml(db, d);
+        ++iterations;
+    }
+    record(scale, iterations, timer.nsecsElapsed());
+}
+
+void KanjiDBBenchmark::indexWrite_data()
+{
+    addScaleRows();
+}
+
+void KanjiDBBenchmark::indexWrite()
+{
+    QFETCH(unsigned int, scale);
+    KanjiDB &db = database(scale);
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        QVERIFY(db.writeIndex(&buffer));
+        ++iterations;
+    }
+    record(scale, iterations, timer.nsecsElapsed());
+}
+
+void KanjiDBBenchmark::indexRead_data()
+{
+    QTest::addColumn<unsigned int>("scale");
+    QTest::addColumn<int>("profile");
+    for(int i = 0; i < scaleCount; ++i)
+    {
+        QString prefix = QString("x%1 ").arg(scales[i]);
+        QTest::newRow(qPrintable(prefix + "attributes")) << scales[i] << (int) KanjiDB::attributesProfile;
+        QTest::newRow(qPrintable(prefix + "readings")) << scales[i] << (int) KanjiDB::readingsProfile;
+        QTest::newRow(qPrintable(prefix + "full")) << scales[i] << (int) KanjiDB::fullProfile;
+    }
+}
+
+void KanjiDBBenchmark::indexRead()
+{
+    QFETCH(unsigned int, scale);
+    QFETCH(int, profile);
+    QByteArray data = index(scale);
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        KanjiDB db;
+        db.setLoadProfile((KanjiDB::LoadProfile) profile);
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::ReadOnly);
+        QVERIFY2(db.readIndex(&buffer), qPrintable(db.errorString()));
+        ++iterations;
+    }
+    record(scale, iterations, timer.nsecsElapsed());
+}
+
+void KanjiDBBenchmark::clear_data()
+{
+    addScaleRows();
+}
+
+void KanjiDBBenchmark::clear()
+{
+    QFETCH(unsigned int, scale);
+    QByteArray data = index(scale);
+    KanjiDB db;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::ReadOnly);
+    QVERIFY2(db.readIndex(&buffer), qPrintable(db.errorString()));
+    // clear empties the database, it can only be measured once per load
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        db.clear();
+    }
+    record(scale, 1, timer.nsecsElapsed());
+}
+
+void KanjiDBBenchmark::search_data()
+{
+    QTest::addColumn<unsigned int>("scale");
+    QTest::addColumn<QString>("query");
+    for(int i = 0; i < scaleCount; ++i)
+    {
+        const SyntheticDictionary &d = dictionary(scales[i]);
+        QString prefix = QString("x%1 ").arg(scales[i]);
+        // one row per search key so that new keys show up as soon as they get a sample value
+        for(int k = 0; k < KanjiDB::keyCount; ++k)
+        {
+            const QString &key = KanjiDB::allKeys[k];
+            QString value = d.sampleValue(key);
+            if(value.isEmpty())
+            {
+                qWarning("No sample value for search key %s", qPrintable(key));
+                continue;
+            }
+            QTest::newRow(qPrintable(prefix + key + value)) << scales[i] << key + value;
+        }
+        // representative combinations of unions and intersections
+        QString jlpt = KanjiDB::jlptKey + d.sampleValue(KanjiDB::jlptKey);
+        QString grade = KanjiDB::gradeKey + d.sampleValue(KanjiDB::gradeKey);
+        QString strokes = KanjiDB::strokesKey + d.sampleValue(KanjiDB::strokesKey);
+        QString component = KanjiDB::componentKey + d.sampleValue(KanjiDB::componentKey);
+        QTest::newRow(qPrintable(prefix + "jlpt&grade")) << scales[i] << jlpt + "&" + grade;
+        QTest::newRow(qPrintable(prefix + "jlpt,grade")) << scales[i] << jlpt + "," + grade;
+        QTest::newRow(qPrintable(prefix + "component&strokes")) << scales[i] << component + "&" + strokes;
+        QTest::newRow(qPrintable(prefix + "strokes<&jlpt")) << scales[i]
+                << KanjiDB::strokesLessKey + d.sampleValue(KanjiDB::strokesLessKey) + "&" + jlpt;
+        QTest::newRow(qPrintable(prefix + "strokes range&jlpt")) << scales[i]
+                << KanjiDB::strokesKey + "8..12&" + jlpt;
+        QTest::newRow(qPrintable(prefix + "skip wildcard")) << scales[i] << KanjiDB::skipKey + "1-4-*";
+        QTest::newRow(qPrintable(prefix + "skip ranges")) << scales[i] << KanjiDB::skipKey + "2-1..3-*";
+        QTest::newRow(qPrintable(prefix + "literal text")) << scales[i] << d.sampleText(64);
+    }
+}
+
+void KanjiDBBenchmark::search()
+{
+    QFETCH(unsigned int, scale);
+    QFETCH(QString, query);
+    const KanjiDB &db = database(scale);
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        KanjiSet result;
+        db.search(query, result);
+        ++iterations;
+    }
+    record(scale, iterations, timer.nsecsElapsed());
+}
+
+void KanjiDBBenchmark::searchIds_data()
+{
+    search_data();
+}
+
+// the same queries with id results, no KanjiSet is built
+void KanjiDBBenchmark::searchIds()
+{
+    QFETCH(unsigned int, scale);
+    QFETCH(QString, query);
+    const KanjiDB &db = database(scale);
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        KanjiIdSet result;
+        db.search(query, result);
+        ++iterations;
+    }
+    record(scale, iterations, timer.nsecsElapsed());
+}
+
+void KanjiDBBenchmark::searchBatch_data()
+{
+    QTest::addColumn<unsigned int>("scale");
+    QTest::addColumn<bool>("batch");
+    for(int i = 0; i < scaleCount; ++i)
+    {
+        QString prefix = QString("x%1 ").arg(scales[i]);
+        QTest::newRow(qPrintable(prefix + "search loop")) << scales[i] << false;
+        QTest::newRow(qPrintable(prefix + "searchBatch")) << scales[i] << true;
+    }
+}
+
+void KanjiDBBenchmark::searchBatch()
+{
+    QFETCH(unsigned int, scale);
+    QFETCH(bool, batch);
+    const KanjiDB &db = database(scale);
+    // 1000 distinct queries drawing on a few dozen key groups, as offline jobs do
+    QStringList queries;
+    for(int j = 0; j < 1000; ++j)
+        queries << KanjiDB::jlptKey + QString::number(1 + j % 5) + "&"
+                   + KanjiDB::strokesKey + QString::number(1 + j % 20) + ","
+                   + KanjiDB::gradeKey + QString::number(1 + j % 10);
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        QList<KanjiSet> results;
+        if(batch)
+            db.searchBatch(queries, results);
+        else
+            foreach(const QString &query, queries)
+            {
+                KanjiSet result;
+                db.search(query, result);
+                results << result;
+            }
+        ++iterations;
+    }
+    record(scale, iterations, timer.nsecsElapsed());
+}
+
+void KanjiDBBenchmark::annotate_data()
+{
+    QTest::addColumn<unsigned int>("scale");
+    QTest::addColumn<bool>("utf16");
+    QTest::addColumn<bool>("parallel");
+    for(int i = 0; i < scaleCount; ++i)
+    {
+        QString prefix = QString("x%1 ").arg(scales[i]);
+        QTest::newRow(qPrintable(prefix + "utf8")) << scales[i] << false << false;
+        QTest::newRow(qPrintable(prefix + "utf16")) << scales[i] << true << false;
+        QTest::newRow(qPrintable(prefix + "utf8 parallel")) << scales[i] << false << true;
+    }
+}
+
+// 4M characters of mostly ASCII prose with a kanji every few words, as documents are
+void KanjiDBBenchmark::annotate()
+{
+    QFETCH(unsigned int, scale);
+    QFETCH(bool, utf16);
+    QFETCH(bool, parallel);
+    const KanjiDB &db = database(scale);
+    QString kanjis = dictionary(scale).sampleText(4096);
+    QString text;
+    for(int i = 0; text.size() < (4 << 20); ++i)
+        text += QString("lorem ipsum dolor sit amet ") + kanjis.at(i % kanjis.size()) + ", ";
+    QByteArray data = utf16 ? QByteArray((const char *) text.utf16(), 2 * text.size()) : text.toUtf8();
+    TextAnnotator::Encoding encoding = utf16 ? TextAnnotator::utf16 : TextAnnotator::utf8;
+    TextAnnotator annotator(db);
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        QVector<Annotation> annotations;
+        if(parallel)
+            annotator.annotateParallel(data.constData(), data.size(), encoding, annotations);
+        else
+            annotator.annotate(data.constData(), data.size(), encoding, annotations);
+        ++iterations;
+    }
+    record(scale, iterations, timer.nsecsElapsed());
+}
+
+void KanjiDBBenchmark::typing_data()
+{
+    QTest::addColumn<unsigned int>("scale");
+    QTest::addColumn<bool>("session");
+    for(int i = 0; i < scaleCount; ++i)
+    {
+        QString prefix = QString("x%1 ").arg(scales[i]);
+        QTest::newRow(qPrintable(prefix + "search")) << scales[i] << false;
+        QTest::newRow(qPrintable(prefix + "session")) << scales[i] << true;
+    }
+}
+
+// one search per keystroke of a query, as a search box does
+void KanjiDBBenchmark::typing()
+{
+    QFETCH(unsigned int, scale);
+    QFETCH(bool, session);
+    const KanjiDB &db = database(scale);
+    QString query = KanjiDB::jlptKey + "2&" + KanjiDB::gradeKey + "3&" + KanjiDB::strokesMoreKey + "8";
+    qint64 iterations = 0;
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK {
+        QuerySession typed(db);
+        for(int i = 1; i <= query.size(); ++i)
+        {
+            KanjiIdSet result;
+            if(session)
+                typed.search(query.left(i), result);
+            else
+                db.search(query.left(i), result);
+        }
+        ++iterations;
+    }
+    record(scale, iterations, timer.nsecsElapsed());
+}
+
+QTEST_MAIN(KanjiDBBenchmark)
+
+#include "kanjidbbenchmark.moc"
@@ -0,0 +1,311 @@
+#include "syntheticdictionary.h"
+#include "kanjidb.h"
+#include "radicals.h"
+#include <QTextStream>
+#include <QVector>
+
+static const char *englishWords[] = {
+    "water", "fire", "tree", "mountain", "river", "person", "hand", "eye", "sun", "moon",
+    "gold", "earth", "sky", "rain", "stone", "field", "heart", "power", "king", "jewel"
+};
+static const int englishWordCount = sizeof(englishWords) / sizeof(char *);
+
+static const char *frenchWords[] = {
+    "eau", "feu", "arbre", "montagne", "riviere", "personne", "main", "oeil", "soleil", "lune"
+};
+static const int frenchWordCount = sizeof(frenchWords) / sizeof(char *);
+
+SyntheticDictionary::SyntheticDictionary(unsigned int s, quint32 seed)
+    : scale(s), characterCount(s * baseCharacterCount), state(seed ? seed : 1)
+{
+    generate();
+}
+
+unsigned int SyntheticDictionary::getScale() const
+{
+    return scale;
+}
+
+unsigned int SyntheticDictionary::getCharacterCount() const
+{
+    return characterCount;
+}
+
+const QByteArray &SyntheticDictionary::getKanjiDic2() const
+{
+    return kanjiDic2;
+}
+
+const QByteArray &SyntheticDictionary::getRadKFileX() const
+{
+    return radKFileX;
+}
+
+QString SyntheticDictionary::sampleValue(const QString &key) const
+{
+    return samples.value(key);
+}
+
+QString SyntheticDictionary::sampleText(int length) const
+{
+    QString text;
+    // fixed stride so the text is the same for every run
+    for(int i = 0; i < length; ++i)
+        text.append(QChar(firstCharacter + (i * 7919) % characterCount));
+    return text;
+}
+
+// xorshift32
+quint32 SyntheticDictionary::next()
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+unsigned int SyntheticDictionary::next(unsigned int bound)
+{
+    return next() % bound;
+}
+
+QString SyntheticDictionary::syllables(int count, bool katakana, QString *romaji)
+{
+    // a subset of the gojuuon rows: a, ka, sa, ta, na, ma
+    static const ushort hiragana[] = {
+        0x3042, 0x3044, 0x3046, 0x3048, 0x304A,
+        0x304B, 0x304D, 0x304F, 0x3051, 0x3053,
+        0x3055, 0x3057, 0x3059, 0x305B, 0x305D,
+        0x305F, 0x3061, 0x3064, 0x3066, 0x3068,
+        0x306A, 0x306B, 0x306C, 0x306D, 0x306E,
+        0x307E, 0x307F, 0x3080, 0x3081, 0x3082
+    };
+    static const char *hepburn[] = {
+        "a", "i", "u", "e", "o",
+        "ka", "ki", "ku", "ke", "ko",
+        "sa", "shi", "su", "se", "so",
+        "ta", "chi", "tsu", "te", "to",
+        "na", "ni", "nu", "ne", "no",
+        "ma", "mi", "mu", "me", "mo"
+    };
+    QString s;
+    for(int i = 0; i < count; ++i)
+    {
+        unsigned int syllable = next(sizeof(hiragana) / sizeof(ushort));
+        s.append(QChar(hiragana[syllable] + (katakana ? 0x60 : 0)));
+        if(romaji)
+            romaji->append(hepburn[syllable]);
+    }
+    return s;
+}
+
+void SyntheticDictionary::generate()
+{
+    samples.clear();
+
+    // which components each kanji contains, for the radkfilex side
+    QVector<QList<unsigned int> > kanjiByComponent(componentCount);
+
+    QString xml;
+    QTextStream out(&xml);
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    out << "<kanjidic2>\n";
+    out << "<header>\n<file_version>4</file_version>\n<database_version>synthetic-" << scale << "</database_version>\n"
+        << "<date_of_creation>2010-09-12</date_of_creation>\n</header>\n";
+
+    unsigned int frequency = 0;
+    for(unsigned int i = 0; i < characterCount; ++i)
+    {
+        Unicode ucs = firstCharacter + i;
+        QString literal(QChar((ushort) ucs));
+        out << "<!-- Entry for Kanji: " << literal << " -->\n";
+        out << "<character>\n<literal>" << literal << "</literal>\n";
+
+        out << "<codepoint>\n";
+        out << "<cp_value cp_type=\"ucs\">" << QString::number(ucs, 16) << "</cp_value>\n";
+        if(i == 0)
+            samples.insert(KanjiDB::ucsKey, QString::number(ucs, 16));
+        QString jis = QString("%1-%2").arg(16 + (i / 3) / 94).arg(1 + (i / 3) % 94, 2, 10, QChar('0'));
+        if(i % 3 == 0)
+        {
+            out << "<cp_value cp_type=\"jis208\">" << jis << "</cp_value>\n";
+            if(!samples.contains(KanjiDB::jis208Key))
+                samples.insert(KanjiDB::jis208Key, jis);
+        } else if(i % 3 == 1)
+        {
+            out << "<cp_value cp_type=\"jis212\">" << jis << "</cp_value>\n";
+            if(!samples.contains(KanjiDB::jis212Key))
+                samples.insert(KanjiDB::jis212Key, jis);
+        } else
+        {
+            out << "<cp_value cp_type=\"jis213\">1-" << jis << "</cp_value>\n";
+            if(!samples.contains(KanjiDB::jis213Key))
+                samples.insert(KanjiDB::jis213Key, "1-" + jis);
+        }
+        out << "</codepoint>\n";
+
+        unsigned int radical = 1 + next(Radicals::radicalsSize);
+        out << "<radical>\n<rad_value rad_type=\"classical\">" << radical << "</rad_value>\n";
+        if(next(4) == 0)
+            out << "<rad_value rad_type=\"nelson_c\">" << 1 + next(Radicals::radicalsSize) << "</rad_value>\n";
+        out << "</radical>\n";
+        if(i == 0)
+        {
+            samples.insert(KanjiDB::radicalKey, QString::number(radical));
+            samples.insert(KanjiDB::nelsonKey, QString::number(radical));
+        }
+
+        out << "<misc>\n";
+        if(next(3) != 0)
+        {
+            // grades 1 to 6 are kyouiku kanji, 8 is the rest of the jouyou
+            unsigned int grade = next(4) == 0 ? 8 : 1 + next(6);
+            out << "<grade>" << grade << "</grade>\n";
+            if(!samples.contains(KanjiDB::gradeKey))
+            {
+                samples.insert(KanjiDB::gradeKey, QString::number(grade));
+                samples.insert(KanjiDB::gradeLessKey, QString::number(grade + 1));
+                samples.insert(KanjiDB::gradeMoreKey, QString::number(grade - 1));
+                samples.insert(KanjiDB::gradeLessEqualKey, QString::number(grade));
+                samples.insert(KanjiDB::gradeMoreEqualKey, QString::number(grade));
+            }
+        }
+        // stroke counts concentrate around 10 like in the real dictionary
+        unsigned int strokes = 1 + next(8) + next(8) + next(8);
+        out << "<stroke_count>" << strokes << "</stroke_count>\n";
+        if(i == 0)
+        {
+            samples.insert(KanjiDB::strokesKey, QString::number(strokes));
+            samples.insert(KanjiDB::strokesLessKey, QString::number(strokes + 1));
+            samples.insert(KanjiDB::strokesMoreKey, QString::number(strokes > 1 ? strokes - 1 : 1));
+            samples.insert(KanjiDB::strokesLessEqualKey, QString::number(strokes));
+            samples.insert(KanjiDB::strokesMoreEqualKey, QString::number(strokes));
+            samples.insert(KanjiDB::strokesAroundKey, QString::number(strokes));
+        }
+        if(i > 0 && i % 17 == 0)
+            out << "<variant var_type=\"ucs\">" << QString::number(ucs - 1, 16) << "</variant>\n";
+        if(i > 2 && i % 23 == 0)
+            out << "<variant var_type=\"jis208\">" << QString("%1-%2").arg(16 + ((i - 3) / 3) / 94).arg(1 + ((i - 3) / 3) % 94, 2, 10, QChar('0')) << "</variant>\n";
+        // about a fifth of the kanji are ranked, as the 2500 most frequent ones are in kanjidic2
+        if(next(5) == 0)
+        {
+            out << "<freq>" << ++frequency << "</freq>\n";
+            if(frequency == 1)
+            {
+                samples.insert(KanjiDB::frequencyKey, "1.." + QString::number(10 * scale));
+                samples.insert(KanjiDB::frequencyLessKey, QString::number(10 * scale));
+                samples.insert(KanjiDB::frequencyMoreKey, QString::number(10 * scale));
+                samples.insert(KanjiDB::frequencyLessEqualKey, QString::number(10 * scale));
+                samples.insert(KanjiDB::frequencyMoreEqualKey, QString::number(10 * scale));
+            }
+        }
+        if(next(10) == 0)
+        {
+            QString name = syllables(3, false);
+            out << "<rad_name>" << name << "</rad_name>\n";
+            if(!samples.contains(KanjiDB::radicalNameKey))
+                samples.insert(KanjiDB::radicalNameKey, name);
+        }
+        if(next(2) == 0)
+        {
+            unsigned int jlpt = 1 + next(4);
+            out << "<jlpt>" << jlpt << "</jlpt>\n";
+            if(!samples.contains(KanjiDB::jlptKey))
+            {
+                samples.insert(KanjiDB::jlptKey, QString::number(jlpt));
+                samples.insert(KanjiDB::jlptLessKey, QString::number(jlpt + 1));
+                samples.insert(KanjiDB::jlptMoreKey, QString::number(jlpt - 1));
+                samples.insert(KanjiDB::jlptLessEqualKey, QString::number(jlpt));
+                samples.insert(KanjiDB::jlptMoreEqualKey, QString::number(jlpt));
+            }
+        }
+        out << "</misc>\n";
+
+        out << "<dic_number>\n";
+        out << "<dic_ref dr_type=\"nelson_c\">" << 1 + i << "</dic_ref>\n";
+        out << "<dic_ref dr_type=\"heisig\">" << 1 + (i * 3) % characterCount << "</dic_ref>\n";
+        out << "</dic_number>\n";
+        if(i == 0)
+            samples.insert(KanjiDB::referenceKey, "heisig=1..500");
+
+        out << "<query_code>\n";
+        // operands of a << chain are evaluated in unspecified order, draw them first
+        unsigned int skip[3];
+        skip[0] = 1 + next(4);
+        skip[1] = 1 + next(9);
+        skip[2] = 1 + next(12);
+        out << "<q_code qc_type=\"skip\">" << skip[0] << "-" << skip[1] << "-" << skip[2] << "</q_code>\n";
+        unsigned int fourCorner = next(10000);
+        unsigned int fifthCorner = next(10);
+        out << "<q_code qc_type=\"four_corner\">" << QString("%1").arg(fourCorner, 4, 10, QChar('0')) << "." << fifthCorner << "</q_code>\n";
+        // no draw left for De Roo, it follows the four corners
+        unsigned int deRoo = 1 + (fourCorner % 30) * 100 + fifthCorner;
+        out << "<q_code qc_type=\"deroo\">" << deRoo << "</q_code>\n";
+        if(i == 0)
+        {
+            samples.insert(KanjiDB::skipKey, QString("%1-%2-%3").arg(skip[0]).arg(skip[1]).arg(skip[2]));
+            samples.insert(KanjiDB::fourCornerKey, QString("%1.x").arg(fourCorner, 4, 10, QChar('0')));
+            samples.insert(KanjiDB::deRooKey, QString::number(deRoo));
+        }
+        out << "</query_code>\n";
+
+        out << "<reading_meaning>\n<rmgroup>\n";
+        unsigned int onCount = 1 + next(2);
+        for(unsigned int j = 0; j < onCount; ++j)
+        {
+            QString romaji;
+            out << "<reading r_type=\"ja_on\">" << syllables(1 + next(2), true, &romaji) << "</reading>\n";
+            if(i == 0 && j == 0)
+                samples.insert(KanjiDB::romajiKey, romaji);
+        }
+        unsigned int kunCount = next(3);
+        for(unsigned int j = 0; j < kunCount; ++j)
+            out << "<reading r_type=\"ja_kun\">" << syllables(1 + next(2), false) << "." << syllables(1, false) << "</reading>\n";
+        unsigned int meaningCount = 1 + next(3);
+        for(unsigned int j = 0; j < meaningCount; ++j)
+            out << "<meaning>" << englishWords[next(englishWordCount)] << "</meaning>\n";
+        out << "<meaning m_lang=\"fr\">" << frenchWords[next(frenchWordCount)] << "</meaning>\n";
+        out << "</rmgroup>\n";
+        if(next(4) == 0)
+            out << "<nanori>" << syllables(2, false) << "</nanori>\n";
+        out << "</reading_meaning>\n";
+        out << "</character>\n";
+
+        unsigned int components = 1 + next(4);
+        for(unsigned int j = 0; j < components; ++j)
+        {
+            QList<unsigned int> &list = kanjiByComponent[next(componentCount)];
+            if(list.isEmpty() || list.last() != i)
+                list.append(i);
+        }
+    }
+    out << "</kanjidic2>\n";
+    out.flush();
+    kanjiDic2 = xml.toUtf8();
+
+    QString radk;
+    QTextStream radkOut(&radk);
+    radkOut << "# synthetic RADKFILEX, scale " << scale << "\n";
+    for(unsigned int c = 0; c < componentCount; ++c)
+    {
+        QChar component((ushort) (firstComponent + c));
+        radkOut << "$ " << component << " " << 1 + c % 17 << "\n";
+        QString line;
+        foreach(unsigned int i, kanjiByComponent.at(c))
+        {
+            line.append(QChar((ushort) (firstCharacter + i)));
+            // radkfilex wraps its kanji lists
+            if(line.size() == 36)
+            {
+                radkOut << line << "\n";
+                line.clear();
+            }
+        }
+        if(!line.isEmpty())
+            radkOut << line << "\n";
+        if(!samples.contains(KanjiDB::componentKey) && !kanjiByComponent.at(c).isEmpty())
+            samples.insert(KanjiDB::componentKey, QString(component));
+    }
+    radkOut.flush();
+    radKFileX = radk.toUtf8();
+}
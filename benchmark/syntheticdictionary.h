@@ -0,0 +1,50 @@
+#ifndef SYNTHETICDICTIONARY_H
+#define SYNTHETICDICTIONARY_H
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include "kanji.h"
+
+// Deterministic kanjidic2 and radkfilex shaped data.
+// The same scale and seed always produce the same bytes, so benchmark
+// runs can be compared without shipping the real dictionaries.
+class SyntheticDictionary
+{
+public:
+    SyntheticDictionary(unsigned int scale, quint32 seed = 0x5AD5AD15);
+
+    unsigned int getScale() const;
+    unsigned int getCharacterCount() const;
+    const QByteArray &getKanjiDic2() const;
+    const QByteArray &getRadKFileX() const;
+    // value of a KanjiDB search key that matches some generated kanji, empty if the key is unknown
+    QString sampleValue(const QString &key) const;
+    // literal text made of generated kanji
+    QString sampleText(int length) const;
+
+    // characters at scale 1, the unified ideographs block fits scale 100
+    static const unsigned int baseCharacterCount = 200;
+    static const unsigned int componentCount = 214;
+    static const Unicode firstCharacter = 0x4E00;
+    // components are taken from the Kangxi radicals block so they never collide with kanji
+    static const Unicode firstComponent = 0x2F00;
+
+private:
+    quint32 next();
+    unsigned int next(unsigned int bound);
+    // the Hepburn spelling is appended to romaji when given
+    QString syllables(int count, bool katakana, QString *romaji = 0);
+    void generate();
+
+    unsigned int scale;
+    unsigned int characterCount;
+    quint32 state;
+    QByteArray kanjiDic2;
+    QByteArray radKFileX;
+    // search key values taken from the first generated kanji having the attribute
+    QMap<QString, QString> samples;
+};
+
+#endif // SYNTHETICDICTIONARY_H
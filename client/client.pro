@@ -0,0 +1,14 @@
+# -------------------------------------------------
+# KanjiDBClient, thin client of the kanjidbd daemon
+# build the library in the parent directory first
+# -------------------------------------------------
+QT += network
+QT -= gui
+TARGET = JapaneseDBClient
+TEMPLATE = lib
+CONFIG += staticlib
+INCLUDEPATH += ..
+LIBS += -L.. -lJapaneseDB
+SOURCES += kanjidbclient.cpp
+HEADERS += kanjidbclient.h \
+    kanjidbprotocol.h
@@ -0,0 +1,267 @@
+#include "kanjidbclient.h"
+#include <QLocalSocket>
+#include <QDataStream>
+
+using namespace KanjiDBProtocol;
+
+KanjiDBClient::KanjiDBClient()
+    : socket(new QLocalSocket), timeout(30000), nextId(1)
+{
+}
+
+KanjiDBClient::~KanjiDBClient()
+{
+    disconnectFromServer();
+    delete socket;
+    qDeleteAll(kanjis);
+}
+
+bool KanjiDBClient::connectToServer(const QString &name)
+{
+    disconnectFromServer();
+    socket->connectToServer(name);
+    if(!socket->waitForConnected(timeout))
+    {
+        error = socket->errorString();
+        return false;
+    }
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_0);
+    out << magic << version;
+    QList<KanjiSet> none;
+    quint32 id = send(helloRequest, payload);
+    if(id == 0 || !receive(id, none))
+    {
+        socket->abort();
+        return false;
+    }
+    return true;
+}
+
+void KanjiDBClient::disconnectFromServer()
+{
+    if(socket->state() != QLocalSocket::UnconnectedState)
+    {
+        socket->disconnectFromServer();
+        if(socket->state() != QLocalSocket::UnconnectedState)
+            socket->waitForDisconnected(timeout);
+    }
+    buffer.clear();
+    received.clear();
+    failures.clear();
+}
+
+bool KanjiDBClient::isConnected() const
+{
+    return socket->state() == QLocalSocket::ConnectedState;
+}
+
+void KanjiDBClient::setTimeout(int msecs)
+{
+    timeout = msecs;
+}
+
+const Kanji *KanjiDBClient::getByUnicode(Unicode unicode) const
+{
+    // kanjis already received are not asked again
+    Kanji *k = kanjis.value(unicode, 0);
+    if(k)
+        return k;
+
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_0);
+    out << unicode;
+    QList<KanjiSet> sets;
+    quint32 id = send(getByUnicodeRequest, payload);
+    if(id == 0 || !receive(id, sets) || sets.isEmpty() || sets.first().isEmpty())
+        return 0;
+    return sets.first().begin().value();
+}
+
+void KanjiDBClient::search(const QString &query, KanjiSet &set) const
+{
+    receiveSearch(sendSearch(query), set);
+}
+
+void KanjiDBClient::searchBatch(const QStringList &queries, QList<KanjiSet> &sets) const
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_0);
+    out << queries;
+    QList<KanjiSet> results;
+    quint32 id = send(searchBatchRequest, payload);
+    if(id != 0 && receive(id, results))
+        sets = results;
+    // a failed batch still gives one set per query
+    while(sets.size() < queries.size())
+        sets << KanjiSet();
+}
+
+void KanjiDBClient::findVariants(const Kanji *k, KanjiSet &setToFill) const
+{
+    if(!k)
+        return;
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_0);
+    out << k->getUnicode();
+    QList<KanjiSet> sets;
+    quint32 id = send(findVariantsRequest, payload);
+    if(id != 0 && receive(id, sets) && !sets.isEmpty())
+        setToFill.unite(sets.first());
+}
+
+quint32 KanjiDBClient::sendSearch(const QString &query) const
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_0);
+    out << query;
+    return send(searchRequest, payload);
+}
+
+bool KanjiDBClient::receiveSearch(quint32 id, KanjiSet &set) const
+{
+    QList<KanjiSet> sets;
+    if(id == 0 || !receive(id, sets) || sets.isEmpty())
+        return false;
+    set.unite(sets.first());
+    return true;
+}
+
+const QString KanjiDBClient::errorString() const
+{
+    return error;
+}
+
+quint32 KanjiDBClient::send(quint8 opcode, const QByteArray &payload) const
+{
+    if(!isConnected())
+    {
+        error = "Not connected";
+        return 0;
+    }
+    quint32 id = nextId++;
+    // 0 means a failed send
+    if(nextId == 0)
+        nextId = 1;
+
+    QByteArray frame;
+    QDataStream out(&frame, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_0);
+    out << (quint32) (frameHeaderSize + payload.size()) << id << opcode;
+    frame.append(payload);
+    if(socket->write(frame) != frame.size())
+    {
+        error = socket->errorString();
+        return 0;
+    }
+    // the request goes out now, its response is read later
+    socket->flush();
+    return id;
+}
+
+bool KanjiDBClient::receive(quint32 id, QList<KanjiSet> &sets) const
+{
+    while(!received.contains(id))
+    {
+        if(!readFrame())
+            return false;
+    }
+    sets = received.take(id);
+    return !failures.remove(id);
+}
+
+bool KanjiDBClient::readFrame() const
+{
+    quint32 length = 0;
+    while(true)
+    {
+        if(buffer.size() >= (int) sizeof(quint32))
+        {
+            QDataStream header(buffer);
+            header.setVersion(QDataStream::Qt_4_0);
+            header >> length;
+            if(length < (quint32) frameHeaderSize || length > maxFrameSize)
+            {
+                error = "Invalid frame received";
+                socket->abort();
+                return false;
+            }
+            if((quint32) buffer.size() >= sizeof(quint32) + length)
+                break;
+        }
+        if(!socket->waitForReadyRead(timeout))
+        {
+            error = socket->errorString();
+            return false;
+        }
+        buffer.append(socket->readAll());
+    }
+
+    QByteArray frame = buffer.mid(sizeof(quint32), length);
+    buffer.remove(0, sizeof(quint32) + length);
+
+    QDataStream in(frame);
+    in.setVersion(QDataStream::Qt_4_0);
+    quint32 id;
+    quint8 status;
+    quint32 count;
+    in >> id >> status >> count;
+    // the records come in response order, sets are decoded as soon as read
+    QList<KanjiSet> sets;
+    for(quint32 i = 0; i < count; i++)
+    {
+        KanjiSet set;
+        if(!readKanjiSet(in, set))
+        {
+            error = "Invalid frame received";
+            socket->abort();
+            return false;
+        }
+        sets << set;
+    }
+    if(status != ok)
+    {
+        QString message;
+        in >> message;
+        error = message;
+        failures << id;
+    }
+    received.insert(id, sets);
+    return true;
+}
+
+bool KanjiDBClient::readKanjiSet(QDataStream &in, KanjiSet &set) const
+{
+    quint32 count;
+    in >> count;
+    for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; i++)
+    {
+        Unicode key, unicode;
+        quint8 hasRecord;
+        in >> key >> unicode >> hasRecord;
+        Kanji *k = kanjis.value(unicode, 0);
+        if(hasRecord)
+        {
+            // a reconnection sends the records again, the first copy is kept
+            Kanji *record = new Kanji;
+            in >> *record;
+            if(k)
+                delete record;
+            else
+            {
+                k = record;
+                kanjis.insert(unicode, k);
+            }
+        }
+        if(!k)
+            return false;
+        set.insert(key, k);
+    }
+    return in.status() == QDataStream::Ok;
+}
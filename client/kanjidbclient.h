@@ -0,0 +1,61 @@
+#ifndef KANJIDBCLIENT_H
+#define KANJIDBCLIENT_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QList>
+#include "kanji.h"
+#include "kanjidbprotocol.h"
+
+class QLocalSocket;
+class QDataStream;
+
+// Thin blocking client of kanjidbd, with the query API of KanjiDB.
+// Kanjis are received once per connection and stay owned by the client,
+// the pointers it hands out are valid until it is destroyed.
+// Requests can be pipelined: send them all, then collect their results by id.
+class KanjiDBClient
+{
+public:
+    KanjiDBClient();
+    ~KanjiDBClient();
+
+    bool connectToServer(const QString &name = KanjiDBProtocol::defaultServerName());
+    void disconnectFromServer();
+    bool isConnected() const;
+    // for every wait on the socket, 30 seconds by default
+    void setTimeout(int msecs);
+
+    const Kanji *getByUnicode(Unicode) const;
+    void search(const QString &, KanjiSet &) const;
+    void searchBatch(const QStringList &, QList<KanjiSet> &) const;
+    void findVariants(const Kanji *k, KanjiSet &setToFill) const;
+
+    // pipelining, 0 is returned when the request could not be sent
+    quint32 sendSearch(const QString &) const;
+    bool receiveSearch(quint32 id, KanjiSet &) const;
+
+    const QString errorString() const;
+
+private:
+    quint32 send(quint8 opcode, const QByteArray &payload) const;
+    // reads frames until the one of id, the ones read before are kept for later
+    bool receive(quint32 id, QList<KanjiSet> &sets) const;
+    bool readFrame() const;
+    bool readKanjiSet(QDataStream &, KanjiSet &) const;
+
+    QLocalSocket *socket;
+    int timeout;
+    mutable quint32 nextId;
+    mutable QByteArray buffer;
+    mutable QMap<quint32, QList<KanjiSet> > received;
+    mutable QSet<quint32> failures;
+    mutable QHash<Unicode, Kanji *> kanjis;
+    mutable QString error;
+};
+
+#endif // KANJIDBCLIENT_H
@@ -0,0 +1,51 @@
+#ifndef KANJIDBPROTOCOL_H
+#define KANJIDBPROTOCOL_H
+
+#include <QtGlobal>
+#include <QString>
+
+// Binary protocol between kanjidbd and KanjiDBClient, over a local socket.
+//
+// Every message is a frame: quint32 length of what follows, quint32 request id,
+// quint8 opcode (request) or status (response), then a QDataStream (Qt_4_0) payload.
+// A client may send any number of requests before reading the responses, which
+// come back in request order with the id of their request.
+//
+// A kanji is sent in full the first time a connection sees it, later
+// responses only carry its code point; the client keeps the records it got.
+namespace KanjiDBProtocol
+{
+    const quint32 magic = 0x5AD5DB0C;
+    const quint32 version = 2;
+
+    // every response payload is a quint32 count of kanji sets, then the sets
+    // a kanji set is a quint32 count, then per kanji its key, its Unicode,
+    // a quint8 telling whether the full record follows, and the record
+
+    // hello: quint32 magic, quint32 version -> no set
+    const quint8 helloRequest = 0;
+    // search: QString query -> one set
+    const quint8 searchRequest = 1;
+    // search batch: QStringList queries -> one set per query
+    const quint8 searchBatchRequest = 2;
+    // get by unicode: Unicode -> one set of 0 or 1 kanji
+    const quint8 getByUnicodeRequest = 3;
+    // find variants: Unicode of the kanji -> one set
+    const quint8 findVariantsRequest = 4;
+
+    const quint8 ok = 0;
+    // no set, followed by a QString message
+    const quint8 badRequest = 1;
+
+    // request id and opcode or status, counted in the frame length
+    const int frameHeaderSize = sizeof(quint32) + sizeof(quint8);
+    // frames above this size are refused
+    const quint32 maxFrameSize = 64 * 1024 * 1024;
+
+    inline QString defaultServerName()
+    {
+        return QString("kanjidb");
+    }
+}
+
+#endif // KANJIDBPROTOCOL_H
@@ -0,0 +1,229 @@
+#include "corpusstatistics.h"
+#include "workstealingpool.h"
+#include "tracer.h"
+#include <QFile>
+#include <QAtomicInt>
+#include <algorithm>
+
+const int CorpusStatistics::pieceSize;
+
+// one per pool thread, counts the next file not taken yet until there is none left
+class CountingTask : public WorkStealingTask
+{
+public:
+    CountingTask(const TextAnnotator *a, const QStringList *p, QAtomicInt *n, TextAnnotator::Encoding e, int kanjiCount)
+        : annotator(a), paths(p), next(n), encoding(e), counts(kanjiCount, 0) {}
+    void run()
+    {
+        int i;
+        while((i = next->fetchAndAddRelaxed(1)) < paths->size())
+            count(paths->at(i));
+    }
+
+    const TextAnnotator *annotator;
+    const QStringList *paths;
+    QAtomicInt *next;
+    TextAnnotator::Encoding encoding;
+    QVector<quint64> counts;
+    QHash<Unicode, quint64> unknown;
+    QStringList failed;
+
+private:
+    void count(const QString &path)
+    {
+        TraceSpan span("corpus file");
+        span.setDetail(path);
+        QFile file(path);
+        if(!file.open(QIODevice::ReadOnly))
+        {
+            failed << path;
+            return;
+        }
+        QVector<Annotation> annotations;
+        QVector<Unicode> ideographs;
+        // a code point cut by the end of the previous piece
+        QByteArray carry;
+        while(!file.atEnd())
+        {
+            QByteArray piece = file.read(CorpusStatistics::pieceSize);
+            if(piece.isEmpty())
+            {
+                failed << path;
+                return;
+            }
+            piece.prepend(carry);
+            int used = annotator->scan((const uchar *) piece.constData(), piece.size(), encoding, 0,
+                                       annotations, &ideographs);
+            carry = piece.mid(used);
+            foreach(const Annotation &annotation, annotations)
+                ++counts[annotation.id];
+            foreach(Unicode unicode, ideographs)
+                ++unknown[unicode];
+            annotations.clear();
+            ideographs.clear();
+        }
+    }
+};
+
+CorpusStatistics::CorpusStatistics(const KanjiDB &database)
+    : db(database), annotator(database), counts(database.getKanjiCount(), 0)
+{
+}
+
+bool CorpusStatistics::addFiles(const QStringList &paths, TextAnnotator::Encoding encoding, WorkStealingPool *pool)
+{
+    TraceSpan span("corpus statistics");
+    if(pool == 0)
+        pool = WorkStealingPool::globalInstance();
+    QAtomicInt next(0);
+    QList<CountingTask *> counters;
+    QList<WorkStealingTask *> tasks;
+    int threads = qMin(pool->getThreadCount(), paths.size());
+    for(int i = 0; i < threads; ++i)
+    {
+        CountingTask *counter = new CountingTask(&annotator, &paths, &next, encoding, counts.size());
+        counters << counter;
+        tasks << counter;
+    }
+    pool->run(tasks);
+
+    QStringList failed;
+    foreach(CountingTask *counter, counters)
+    {
+        for(int id = 0; id < counts.size(); ++id)
+            counts[id] += counter->counts.at(id);
+        QHashIterator<Unicode, quint64> u(counter->unknown);
+        while(u.hasNext())
+        {
+            u.next();
+            unknown[u.key()] += u.value();
+        }
+        failed += counter->failed;
+    }
+    qDeleteAll(counters);
+    if(!failed.isEmpty())
+    {
+        error = QString("Cannot read %1").arg(failed.join(", "));
+        return false;
+    }
+    error = QString();
+    return true;
+}
+
+void CorpusStatistics::addText(const QString &text)
+{
+    QVector<Annotation> annotations;
+    QVector<Unicode> ideographs;
+    annotator.scan((const uchar *) text.utf16(), 2 * text.size(), TextAnnotator::utf16, 0, annotations, &ideographs);
+    foreach(const Annotation &annotation, annotations)
+        ++counts[annotation.id];
+    foreach(Unicode unicode, ideographs)
+        ++unknown[unicode];
+}
+
+void CorpusStatistics::clear()
+{
+    counts.fill(0);
+    unknown.clear();
+    error = QString();
+}
+
+quint64 CorpusStatistics::getKanjiOccurrences() const
+{
+    quint64 occurrences = 0;
+    foreach(quint64 count, counts)
+        occurrences += count;
+    return occurrences;
+}
+
+quint64 CorpusStatistics::getUnknownOccurrences() const
+{
+    quint64 occurrences = 0;
+    foreach(quint64 count, unknown)
+        occurrences += count;
+    return occurrences;
+}
+
+quint64 CorpusStatistics::getOccurrences(KanjiId id) const
+{
+    return id < counts.size() ? counts.at(id) : 0;
+}
+
+static bool moreOccurrences(const KanjiCount &a, const KanjiCount &b)
+{
+    if(a.occurrences != b.occurrences)
+        return a.occurrences > b.occurrences;
+    return a.id < b.id;
+}
+
+QList<KanjiCount> CorpusStatistics::getHistogram() const
+{
+    QVector<KanjiCount> histogram;
+    for(int id = 0; id < counts.size(); ++id)
+    {
+        if(counts.at(id) == 0)
+            continue;
+        KanjiCount count = {(KanjiId) id, counts.at(id)};
+        histogram.append(count);
+    }
+    std::sort(histogram.begin(), histogram.end(), moreOccurrences);
+    return histogram.toList();
+}
+
+QMap<unsigned int, Coverage> CorpusStatistics::getJLPTCoverage() const
+{
+    return coverage(db.getKanjisByJLPT());
+}
+
+QMap<unsigned int, Coverage> CorpusStatistics::getGradeCoverage() const
+{
+    return coverage(db.getKanjisByGrade());
+}
+
+QMap<unsigned int, Coverage> CorpusStatistics::coverage(const QMap<unsigned int, PostingList> &levels) const
+{
+    QMap<unsigned int, Coverage> coverages;
+    QVector<bool> leveled(counts.size(), false);
+    QMapIterator<unsigned int, PostingList> i(levels);
+    while(i.hasNext())
+    {
+        i.next();
+        Coverage level = {i.value().size(), 0, 0};
+        foreach(KanjiId id, i.value())
+        {
+            if(id >= counts.size())
+                continue;
+            leveled[id] = true;
+            if(counts.at(id) > 0)
+            {
+                ++level.seen;
+                level.occurrences += counts.at(id);
+            }
+        }
+        coverages.insert(i.key(), level);
+    }
+    Coverage none = {0, 0, 0};
+    for(int id = 0; id < counts.size(); ++id)
+    {
+        if(leveled.at(id))
+            continue;
+        ++none.kanjis;
+        if(counts.at(id) > 0)
+        {
+            ++none.seen;
+            none.occurrences += counts.at(id);
+        }
+    }
+    coverages.insert(0, none);
+    return coverages;
+}
+
+const QHash<Unicode, quint64> &CorpusStatistics::getUnknownIdeographs() const
+{
+    return unknown;
+}
+
+const QString CorpusStatistics::errorString() const
+{
+    return error;
+}
@@ -0,0 +1,74 @@
+#ifndef CORPUSSTATISTICS_H
+#define CORPUSSTATISTICS_H
+
+#include <QVector>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include "kanjidb.h"
+#include "textannotator.h"
+
+class WorkStealingPool;
+
+// occurrences of one kanji in a corpus
+struct KanjiCount
+{
+    KanjiId id;
+    quint64 occurrences;
+};
+
+// how much of a JLPT level or school grade a corpus uses
+struct Coverage
+{
+    // kanjis of the level, those met in the corpus, and their occurrences
+    int kanjis;
+    int seen;
+    quint64 occurrences;
+};
+
+// Kanji counts of a text corpus, with their coverage by JLPT level and school grade.
+// Files are counted in parallel: one task per pool thread takes the files one after the
+// other into its own histogram by kanji id, the histograms are summed at the end.
+// The counts refer to the kanjis by id, they are valid as long as the database is not read again.
+class CorpusStatistics
+{
+public:
+    explicit CorpusStatistics(const KanjiDB &);
+
+    // adds the counts of the files, on the pool, the global one by default
+    // false if a file could not be read, the others are still counted
+    bool addFiles(const QStringList &paths, TextAnnotator::Encoding = TextAnnotator::utf8, WorkStealingPool *pool = 0);
+    void addText(const QString &);
+    void clear();
+
+    // occurrences of the kanjis of the database, of the other ideographs
+    quint64 getKanjiOccurrences() const;
+    quint64 getUnknownOccurrences() const;
+    quint64 getOccurrences(KanjiId) const;
+    // the kanjis met, most frequent first
+    QList<KanjiCount> getHistogram() const;
+    // by JLPT level or grade, 0 gathers the kanjis that have none
+    QMap<unsigned int, Coverage> getJLPTCoverage() const;
+    QMap<unsigned int, Coverage> getGradeCoverage() const;
+    // ideographs without a kanji in the database, and their occurrences
+    const QHash<Unicode, quint64> &getUnknownIdeographs() const;
+
+    const QString errorString() const;
+
+    // bytes read from a file at a time
+    static const int pieceSize = 4 << 20;
+
+private:
+    QMap<unsigned int, Coverage> coverage(const QMap<unsigned int, PostingList> &levels) const;
+
+    const KanjiDB &db;
+    TextAnnotator annotator;
+    // by kanji id
+    QVector<quint64> counts;
+    QHash<Unicode, quint64> unknown;
+    QString error;
+};
+
+#endif // CORPUSSTATISTICS_H
@@ -0,0 +1,14 @@
+# -------------------------------------------------
+# corpusstats, kanji counts and JLPT/grade coverage of text files
+# build the library in the parent directory first
+# -------------------------------------------------
+QT += xml
+QT -= gui
+TARGET = corpusstats
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+INCLUDEPATH += ..
+LIBS += -L.. -lJapaneseDB
+PRE_TARGETDEPS += ../libJapaneseDB.a
+SOURCES += main.cpp
@@ -0,0 +1,110 @@
+#include <QCoreApplication>
+#include <QStringList>
+#include <QTextStream>
+#include <QDir>
+#include <iostream>
+#include "kanjidb.h"
+#include "corpusstatistics.h"
+
+static QString percent(quint64 part, quint64 whole)
+{
+    return whole == 0 ? QString("-") : QString::number(100.0 * part / whole, 'f', 1) + "%";
+}
+
+static void printCoverage(QTextStream &out, const QString &title, const QMap<unsigned int, Coverage> &coverages,
+                          quint64 occurrences)
+{
+    out << title << "\tkanjis\tseen\tcovered\toccurrences\tshare\n";
+    QMapIterator<unsigned int, Coverage> i(coverages);
+    while(i.hasNext())
+    {
+        i.next();
+        const Coverage &c = i.value();
+        out << (i.key() == 0 ? QString("none") : QString::number(i.key())) << "\t" << c.kanjis << "\t" << c.seen
+            << "\t" << percent(c.seen, c.kanjis) << "\t" << c.occurrences << "\t" << percent(c.occurrences, occurrences) << "\n";
+    }
+    out << "\n";
+}
+
+// corpusstats [-d <dictionary directory>] [-utf16] [-n <kanjis listed>] <file>...
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QString directory = QDir::currentPath();
+    TextAnnotator::Encoding encoding = TextAnnotator::utf8;
+    int listed = 50;
+    QStringList files;
+    QStringList arguments = app.arguments();
+    for(int i = 1; i < arguments.size(); i++)
+    {
+        bool ok = true;
+        if(arguments.at(i) == "-d" && i + 1 < arguments.size())
+            directory = arguments.at(++i);
+        else if(arguments.at(i) == "-utf16")
+            encoding = TextAnnotator::utf16;
+        else if(arguments.at(i) == "-n" && i + 1 < arguments.size())
+            listed = arguments.at(++i).toInt(&ok);
+        else if(!arguments.at(i).startsWith("-"))
+            files << arguments.at(i);
+        else
+            ok = false;
+        if(!ok)
+        {
+            files.clear();
+            break;
+        }
+    }
+    if(files.isEmpty())
+    {
+        std::cerr << "usage: corpusstats [-d <dictionary directory>] [-utf16] [-n <kanjis listed>] <file>..." << std::endl;
+        return 1;
+    }
+
+    KanjiDB db;
+    // the levels, grades and literals are all that is needed
+    db.setLoadProfile(KanjiDB::attributesProfile);
+    if(db.readResources(QDir(directory)) == KanjiDB::noDataRead)
+    {
+        std::cerr << db.errorString().toLocal8Bit().constData() << std::endl;
+        return 1;
+    }
+
+    CorpusStatistics statistics(db);
+    bool read = statistics.addFiles(files, encoding);
+    if(!read)
+        std::cerr << statistics.errorString().toLocal8Bit().constData() << std::endl;
+
+    QTextStream out(stdout);
+    out.setCodec("UTF-8");
+    quint64 occurrences = statistics.getKanjiOccurrences();
+    QList<KanjiCount> histogram = statistics.getHistogram();
+    const QHash<Unicode, quint64> &unknown = statistics.getUnknownIdeographs();
+    out << "files\t" << files.size() << "\n";
+    out << "kanjis\t" << occurrences << " occurrences\t" << histogram.size() << " distinct\n";
+    out << "unknown ideographs\t" << statistics.getUnknownOccurrences() << " occurrences\t"
+        << unknown.size() << " distinct\n\n";
+
+    printCoverage(out, "JLPT", statistics.getJLPTCoverage(), occurrences);
+    printCoverage(out, "grade", statistics.getGradeCoverage(), occurrences);
+
+    out << "kanji\toccurrences\tshare\n";
+    for(int i = 0; i < histogram.size() && i < listed; ++i)
+    {
+        const Kanji *k = db.getById(histogram.at(i).id);
+        out << k->getLiteral() << "\t" << histogram.at(i).occurrences << "\t"
+            << percent(histogram.at(i).occurrences, occurrences) << "\n";
+    }
+    if(!unknown.isEmpty())
+    {
+        out << "\nunknown\toccurrences\n";
+        QHashIterator<Unicode, quint64> u(unknown);
+        while(u.hasNext())
+        {
+            u.next();
+            QString ucs = QString("U+%1").arg(u.key(), 4, 16, QChar('0')).toUpper();
+            out << ucs << "\t" << u.value() << "\n";
+        }
+    }
+    return read ? 0 : 2;
+}
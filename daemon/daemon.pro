@@ -0,0 +1,18 @@
+# -------------------------------------------------
+# kanjidbd, serves KanjiDB queries on a local socket
+# build the library in the parent directory first
+# -------------------------------------------------
+QT += xml network
+QT -= gui
+TARGET = kanjidbd
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+INCLUDEPATH += .. \
+    ../client
+LIBS += -L.. -lJapaneseDB
+PRE_TARGETDEPS += ../libJapaneseDB.a
+SOURCES += main.cpp \
+    kanjidbserver.cpp
+HEADERS += kanjidbserver.h \
+    ../client/kanjidbprotocol.h
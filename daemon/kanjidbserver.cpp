@@ -0,0 +1,275 @@
+#include "kanjidbserver.h"
+#include "kanjidbprotocol.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QDataStream>
+#include <QStringList>
+
+using namespace KanjiDBProtocol;
+
+KanjiDBServer::KanjiDBServer(const KanjiDB &db, QObject *parent)
+    : QObject(parent), db(db), server(new QLocalServer(this))
+{
+    connect(server, SIGNAL(newConnection()), this, SLOT(newConnection()));
+}
+
+bool KanjiDBServer::listen(const QString &name)
+{
+    // a daemon answering on the name keeps it
+    QLocalSocket probe;
+    probe.connectToServer(name);
+    if(probe.waitForConnected(probeTimeout))
+    {
+        probe.disconnectFromServer();
+        error = QString("A server is already running on %1").arg(name);
+        return false;
+    }
+    // nobody answers, the socket was left by a daemon that did not stop cleanly
+    QLocalServer::removeServer(name);
+    if(!server->listen(name))
+    {
+        error = server->errorString();
+        return false;
+    }
+    error = QString();
+    return true;
+}
+
+const QString KanjiDBServer::errorString() const
+{
+    return error;
+}
+
+void KanjiDBServer::newConnection()
+{
+    while(server->hasPendingConnections())
+    {
+        QLocalSocket *socket = server->nextPendingConnection();
+        connections.insert(socket, Connection());
+        connect(socket, SIGNAL(readyRead()), this, SLOT(readRequests()));
+        connect(socket, SIGNAL(disconnected()), this, SLOT(removeConnection()));
+    }
+}
+
+void KanjiDBServer::readRequests()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if(!socket || !connections.contains(socket))
+        return;
+    Connection &connection = connections[socket];
+    connection.buffer.append(socket->readAll());
+
+    QList<Request> requests;
+    bool valid = takeRequests(connection, requests);
+    QByteArray out;
+    answer(requests, connection, out);
+    if(!out.isEmpty())
+        socket->write(out);
+    if(!valid)
+    {
+        // nothing after a bad length can be framed again
+        socket->disconnectFromServer();
+    }
+}
+
+void KanjiDBServer::removeConnection()
+{
+    QLocalSocket *socket = qobject_cast<QLocalSocket *>(sender());
+    if(!socket)
+        return;
+    connections.remove(socket);
+    socket->deleteLater();
+}
+
+bool KanjiDBServer::takeRequests(Connection &connection, QList<Request> &requests) const
+{
+    int position = 0;
+    QByteArray &buffer = connection.buffer;
+    bool valid = true;
+    while(buffer.size() - position >= (int) sizeof(quint32))
+    {
+        QDataStream header(buffer.mid(position, sizeof(quint32)));
+        header.setVersion(QDataStream::Qt_4_0);
+        quint32 length;
+        header >> length;
+        if(length < (quint32) frameHeaderSize || length > maxFrameSize)
+        {
+            valid = false;
+            position = buffer.size();
+            break;
+        }
+        if((quint32) (buffer.size() - position) < sizeof(quint32) + length)
+            break;
+
+        QDataStream in(buffer.mid(position + sizeof(quint32), frameHeaderSize));
+        in.setVersion(QDataStream::Qt_4_0);
+        Request request;
+        in >> request.id >> request.opcode;
+        request.payload = buffer.mid(position + sizeof(quint32) + frameHeaderSize,
+                                     length - frameHeaderSize);
+        requests << request;
+        position += sizeof(quint32) + length;
+    }
+    buffer.remove(0, position);
+    return valid;
+}
+
+void KanjiDBServer::answer(const QList<Request> &requests, Connection &connection, QByteArray &out) const
+{
+    int i = 0;
+    while(i < requests.size())
+    {
+        const Request &request = requests.at(i);
+        QDataStream in(request.payload);
+        in.setVersion(QDataStream::Qt_4_0);
+        QList<KanjiSet> sets;
+
+        if(request.opcode == searchRequest)
+        {
+            // the searches pipelined one after the other run as one batch
+            QStringList queries;
+            QList<bool> malformed;
+            int end = i;
+            for(; end < requests.size() && requests.at(end).opcode == searchRequest; end++)
+            {
+                QDataStream query(requests.at(end).payload);
+                query.setVersion(QDataStream::Qt_4_0);
+                QString q;
+                query >> q;
+                // a truncated query stays out of the batch
+                malformed << (query.status() != QDataStream::Ok);
+                if(!malformed.last())
+                    queries << q;
+            }
+            if(queries.size() == 1)
+            {
+                KanjiSet set;
+                db.search(queries.first(), set);
+                sets << set;
+            }
+            else if(queries.size() > 1)
+                db.searchBatch(queries, sets);
+            int next = 0;
+            for(int j = i; j < end; j++)
+            {
+                if(malformed.at(j - i))
+                {
+                    writeError(out, requests.at(j).id, "Malformed request");
+                    continue;
+                }
+                QList<KanjiSet> one;
+                one << sets.at(next++);
+                writeResponse(out, requests.at(j).id, one, connection);
+            }
+            i = end;
+            continue;
+        }
+
+        if(request.opcode == helloRequest)
+        {
+            quint32 clientMagic, clientVersion;
+            in >> clientMagic >> clientVersion;
+            if(in.status() != QDataStream::Ok || clientMagic != magic)
+                writeError(out, request.id, "Not a KanjiDB client");
+            else if(clientVersion != version)
+                writeError(out, request.id, QString("Protocol version %1 expected, got %2")
+                                            .arg(version).arg(clientVersion));
+            else
+                writeResponse(out, request.id, sets, connection);
+        } else if(request.opcode == searchBatchRequest)
+        {
+            QStringList queries;
+            in >> queries;
+            if(in.status() != QDataStream::Ok)
+            {
+                writeError(out, request.id, "Malformed request");
+                i++;
+                continue;
+            }
+            db.searchBatch(queries, sets);
+            writeResponse(out, request.id, sets, connection);
+        } else if(request.opcode == getByUnicodeRequest)
+        {
+            Unicode unicode;
+            in >> unicode;
+            if(in.status() != QDataStream::Ok)
+            {
+                writeError(out, request.id, "Malformed request");
+                i++;
+                continue;
+            }
+            KanjiSet set;
+            const Kanji *k = db.getByUnicode(unicode);
+            if(k)
+                set.insert(unicode, const_cast<Kanji *>(k));
+            sets << set;
+            writeResponse(out, request.id, sets, connection);
+        } else if(request.opcode == findVariantsRequest)
+        {
+            Unicode unicode;
+            in >> unicode;
+            if(in.status() != QDataStream::Ok)
+            {
+                writeError(out, request.id, "Malformed request");
+                i++;
+                continue;
+            }
+            KanjiSet set;
+            // a radical variant without a kanji of its own still has variants
+            const Kanji *k = db.getByUnicode(unicode);
+            if(k == 0)
+                k = db.getRadicalVariant(unicode);
+            db.findVariants(k, set);
+            sets << set;
+            writeResponse(out, request.id, sets, connection);
+        } else
+            writeError(out, request.id, QString("Unknown opcode %1").arg(request.opcode));
+        i++;
+    }
+}
+
+void KanjiDBServer::writeResponse(QByteArray &out, quint32 id, const QList<KanjiSet> &sets, Connection &connection) const
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_0);
+    stream << id << ok << (quint32) sets.size();
+    foreach(const KanjiSet &set, sets)
+        writeKanjiSet(stream, set, connection);
+    appendFrame(out, payload);
+}
+
+void KanjiDBServer::writeError(QByteArray &out, quint32 id, const QString &message) const
+{
+    QByteArray payload;
+    QDataStream stream(&payload, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_0);
+    stream << id << badRequest << (quint32) 0 << message;
+    appendFrame(out, payload);
+}
+
+void KanjiDBServer::appendFrame(QByteArray &out, const QByteArray &payload) const
+{
+    QByteArray length;
+    QDataStream stream(&length, QIODevice::WriteOnly);
+    stream.setVersion(QDataStream::Qt_4_0);
+    stream << (quint32) payload.size();
+    out.append(length).append(payload);
+}
+
+void KanjiDBServer::writeKanjiSet(QDataStream &stream, const KanjiSet &set, Connection &connection) const
+{
+    stream << (quint32) set.size();
+    KanjiSet::const_iterator it = set.constBegin();
+    for(; it != set.constEnd(); ++it)
+    {
+        Unicode unicode = it.value()->getUnicode();
+        bool hasRecord = !connection.sent.contains(unicode);
+        stream << it.key() << unicode << (quint8) hasRecord;
+        if(hasRecord)
+        {
+            stream << *it.value();
+            connection.sent << unicode;
+        }
+    }
+}
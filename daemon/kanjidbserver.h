@@ -0,0 +1,66 @@
+#ifndef KANJIDBSERVER_H
+#define KANJIDBSERVER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QHash>
+#include <QSet>
+#include <QList>
+#include "kanjidb.h"
+
+class QLocalServer;
+class QLocalSocket;
+class QDataStream;
+
+// Serves a loaded KanjiDB on a local socket, see kanjidbprotocol.h.
+// The requests a client pipelined are answered together: consecutive searches
+// run as one searchBatch, and all the responses go out in a single write.
+class KanjiDBServer : public QObject
+{
+    Q_OBJECT
+public:
+    KanjiDBServer(const KanjiDB &db, QObject *parent = 0);
+
+    // false if another server already listens on the name
+    bool listen(const QString &name);
+    const QString errorString() const;
+
+    // milliseconds a running server has to accept the connection listen() tries first
+    static const int probeTimeout = 1000;
+
+private slots:
+    void newConnection();
+    void readRequests();
+    void removeConnection();
+
+private:
+    struct Request
+    {
+        quint32 id;
+        quint8 opcode;
+        QByteArray payload;
+    };
+
+    struct Connection
+    {
+        QByteArray buffer;
+        // kanjis this client already has the record of
+        QSet<Unicode> sent;
+    };
+
+    // false if the buffer holds a malformed frame
+    bool takeRequests(Connection &, QList<Request> &) const;
+    void answer(const QList<Request> &, Connection &, QByteArray &out) const;
+    void writeResponse(QByteArray &out, quint32 id, const QList<KanjiSet> &, Connection &) const;
+    void writeError(QByteArray &out, quint32 id, const QString &message) const;
+    // the length prefix, then the payload
+    void appendFrame(QByteArray &out, const QByteArray &payload) const;
+    void writeKanjiSet(QDataStream &, const KanjiSet &, Connection &) const;
+
+    const KanjiDB &db;
+    QLocalServer *server;
+    QHash<QLocalSocket *, Connection> connections;
+    QString error;
+};
+
+#endif // KANJIDBSERVER_H
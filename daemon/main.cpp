@@ -0,0 +1,79 @@
+#include <QCoreApplication>
+#include <QStringList>
+#include <QDir>
+#include <iostream>
+#include "kanjidb.h"
+#include "kanjidbserver.h"
+#include "kanjidbprotocol.h"
+#include "readingmeaninggroup.h"
+
+// kanjidbd [-d <dictionary directory>] [-n <socket name>] [-l <meaning languages, en,fr>]
+//          [-p <load profile, attributes|readings|full>]
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QString directory = QDir::currentPath();
+    QString name = KanjiDBProtocol::defaultServerName();
+    quint32 languages = ReadingMeaningGroup::allLanguages;
+    KanjiDB::LoadProfile profile = KanjiDB::fullProfile;
+    QStringList arguments = app.arguments();
+    for(int i = 1; i < arguments.size(); i++)
+    {
+        if(arguments.at(i) == "-d" && i + 1 < arguments.size())
+            directory = arguments.at(++i);
+        else if(arguments.at(i) == "-n" && i + 1 < arguments.size())
+            name = arguments.at(++i);
+        else if(arguments.at(i) == "-l" && i + 1 < arguments.size())
+        {
+            languages = 0;
+            foreach(const QString &code, arguments.at(++i).split(','))
+            {
+                int language = ReadingMeaningGroup::languageOf(code);
+                if(language == -1)
+                {
+                    std::cerr << "unknown language " << code.toLocal8Bit().constData() << std::endl;
+                    return 1;
+                }
+                languages |= 1 << language;
+            }
+        }
+        else if(arguments.at(i) == "-p" && i + 1 < arguments.size() && arguments.at(i + 1) == "attributes")
+        {
+            profile = KanjiDB::attributesProfile;
+            ++i;
+        }
+        else if(arguments.at(i) == "-p" && i + 1 < arguments.size() && arguments.at(i + 1) == "readings")
+        {
+            profile = KanjiDB::readingsProfile;
+            ++i;
+        }
+        else if(arguments.at(i) == "-p" && i + 1 < arguments.size() && arguments.at(i + 1) == "full")
+        {
+            profile = KanjiDB::fullProfile;
+            ++i;
+        }
+        else
+        {
+            std::cerr << "usage: kanjidbd [-d <dictionary directory>] [-n <socket name>] [-l <languages>] [-p <profile>]" << std::endl;
+            return 1;
+        }
+    }
+
+    KanjiDB db;
+    db.setLanguages(languages);
+    db.setLoadProfile(profile);
+    if(db.readResources(QDir(directory)) == KanjiDB::noDataRead)
+    {
+        std::cerr << db.errorString().toLocal8Bit().constData() << std::endl;
+        return 1;
+    }
+
+    KanjiDBServer server(db);
+    if(!server.listen(name))
+    {
+        std::cerr << server.errorString().toLocal8Bit().constData() << std::endl;
+        return 1;
+    }
+    return app.exec();
+}
@@ -0,0 +1,351 @@
+#include "edictdb.h"
+#include "kanjidb.h"
+#include <QTextStream>
+#include <QTextCodec>
+#include <QRegExp>
+#include <QFile>
+#include "tracer.h"
+
+const QString EdictDB::edictIndexFilename("edict.index");
+const QString EdictDB::defaultEdictFilename("edict2");
+
+// same separators as KanjiDB::search, spelled out here since the initialization
+// order of KanjiDB's static strings is undefined from this translation unit
+static const QString unionSeps(" ,;");
+static const QString seps("[&\\+ ,;]");
+static const QString notSeps("[^&\\+ ,;]");
+
+const QString EdictDB::wordKey("word=");
+const QString EdictDB::readingKey("reading=");
+const QString EdictDB::kanjiKey("kanji=");
+const QString EdictDB::allKeys[keyCount] = {wordKey, readingKey, kanjiKey};
+const QString EdictDB::regexp(KanjiDB::keysRegexp(allKeys, keyCount));
+const QRegExp EdictDB::searchRegexp("(("+regexp+")"+notSeps+"+)("+seps+"("+regexp+")"+notSeps+"+)*");
+const QChar EdictDB::prefixWildcard('*');
+
+EdictEntry::EdictEntry() : store(0), index(0)
+{
+}
+
+EdictEntry::EdictEntry(const WordStore *s, quint32 i) : store(s), index(i)
+{
+}
+
+bool EdictEntry::isNull() const
+{
+    return store == 0;
+}
+
+quint32 EdictEntry::getIndex() const
+{
+    return index;
+}
+
+quint32 EdictEntry::getSequence() const
+{
+    return store ? store->entry(index).sequence : 0;
+}
+
+bool EdictEntry::isCommon() const
+{
+    return store && (store->entry(index).flags & WordStore::commonFlag);
+}
+
+quint16 EdictEntry::getFlags() const
+{
+    return store ? store->entry(index).flags : 0;
+}
+
+QStringList EdictEntry::getHeadwords() const
+{
+    QStringList l;
+    if(store)
+    {
+        const WordEntryRecord &record = store->entry(index);
+        for(quint32 i = 0; i < record.headwordCount; ++i)
+            l << store->string(record.firstString + i);
+    }
+    return l;
+}
+
+QStringList EdictEntry::getReadings() const
+{
+    QStringList l;
+    if(store)
+    {
+        const WordEntryRecord &record = store->entry(index);
+        quint32 first = record.firstString + record.headwordCount;
+        for(quint32 i = 0; i < record.readingCount; ++i)
+            l << store->string(first + i);
+    }
+    return l;
+}
+
+QStringList EdictEntry::getGlosses() const
+{
+    QStringList l;
+    if(store)
+    {
+        const WordEntryRecord &record = store->entry(index);
+        quint32 first = record.firstString + record.headwordCount + record.readingCount;
+        for(quint32 i = 0; i < record.glossCount; ++i)
+            l << store->string(first + i);
+    }
+    return l;
+}
+
+EdictDB::EdictDB()
+{
+}
+
+EdictDB::~EdictDB()
+{
+    clear();
+}
+
+void EdictDB::clear()
+{
+    store.clear();
+}
+
+quint32 EdictDB::size() const
+{
+    return store.entryCount();
+}
+
+EdictEntry EdictDB::getEntry(quint32 index) const
+{
+    if(index >= store.entryCount())
+        return EdictEntry();
+    return EdictEntry(&store, index);
+}
+
+int EdictDB::readResources(const QDir &basedir)
+{
+    error = QString();
+
+    QString indexPath = basedir.absolutePath().append("/").append(edictIndexFilename);
+    if(mapIndex(indexPath))
+        return KanjiDB::allDataReadAndSaved;
+
+    QFile edictFile(basedir.absolutePath().append("/").append(defaultEdictFilename));
+    if (!edictFile.open(QIODevice::ReadOnly)) {
+        error = QString("Cannot open edict file %1.")
+                          .arg(defaultEdictFilename);
+        return KanjiDB::noDataRead;
+    }
+    if(!readEdict(&edictFile))
+    {
+        error = QString("Cannot read edict file %1:\n%2.")
+                          .arg(defaultEdictFilename)
+                          .arg(error);
+        return KanjiDB::noDataRead;
+    }
+    edictFile.close();
+
+    QFile index(indexPath);
+    if(!index.open(QIODevice::WriteOnly))
+    {
+        error = QString("Cannot open index file %1 for writing.")
+                          .arg(edictIndexFilename);
+        return KanjiDB::allDataReadButNotSaved;
+    }
+    bool saved = writeIndex(&index);
+    index.close();
+    if(!saved)
+    {
+        error = QString("Cannot write index file %1.")
+                          .arg(edictIndexFilename);
+        return KanjiDB::allDataReadButNotSaved;
+    }
+    // switch to the mapped file so the parsed copy is released, it is kept if the mapping fails
+    if(!mapIndex(indexPath))
+    {
+        error = QString("Cannot map index file %1:\n%2.")
+                          .arg(edictIndexFilename)
+                          .arg(error);
+        return KanjiDB::allDataReadButNotSaved;
+    }
+    return KanjiDB::allDataReadAndSaved;
+}
+
+bool EdictDB::readIndex(QIODevice *device)
+{
+    if(!store.read(device))
+    {
+        error = store.errorString();
+        return false;
+    }
+    error = QString();
+    return true;
+}
+
+bool EdictDB::mapIndex(const QString &fileName)
+{
+    // the current store stays in use until the file is mapped
+    WordStore mapped;
+    if(!mapped.map(fileName))
+    {
+        error = mapped.errorString();
+        return false;
+    }
+    store.swap(mapped);
+    error = QString();
+    return true;
+}
+
+bool EdictDB::writeIndex(QIODevice *device) const
+{
+    if(!store.write(device))
+    {
+        error = store.errorString();
+        return false;
+    }
+    error = QString();
+    return true;
+}
+
+bool EdictDB::readEdict(QIODevice *device, const char *codecName)
+{
+    TraceSpan span("edict read");
+    QTextCodec *codec = QTextCodec::codecForName(codecName);
+    if(codec == 0)
+    {
+        error = QString("Unknown codec %1").arg(codecName);
+        return false;
+    }
+    QTextStream ts(device);
+    ts.setAutoDetectUnicode(false);
+    ts.setCodec(codec);
+
+    WordStoreBuilder builder;
+    QStringList headwords, readings, glosses;
+    quint32 sequence;
+    bool common;
+    QString line;
+    // the first line is the file header: '　？？？ /EDICT .../'
+    ts.readLine();
+    while(!(line = ts.readLine()).isNull())
+    {
+        if(WordStoreBuilder::parseEdictLine(line, headwords, readings, glosses, sequence, common))
+            builder.addEntry(sequence, common ? WordStore::commonFlag : 0, headwords, readings, glosses);
+    }
+    if(builder.size() == 0)
+    {
+        error = QString("Not an edict file");
+        return false;
+    }
+    if(!store.attach(builder.build()))
+    {
+        error = store.errorString();
+        return false;
+    }
+    error = QString();
+    return true;
+}
+
+const QString EdictDB::errorString() const
+{
+    return error;
+}
+
+void EdictDB::fillSet(const QVector<quint32> &found, WordSet &setToFill, bool unite) const
+{
+    if(unite)
+        foreach(quint32 i, found)
+            setToFill.insert(i, EdictEntry(&store, i));
+    else
+    {
+        WordSet intersection;
+        foreach(quint32 i, found)
+            if(setToFill.contains(i))
+                intersection.insert(i, setToFill.value(i));
+        setToFill = intersection;
+    }
+}
+
+void EdictDB::searchByHeadword(const QString &headword, WordSet &setToFill, bool unite) const
+{
+    QVector<quint32> found;
+    if(headword.size() > 0)
+        store.findHeadword(headword, found);
+    fillSet(found, setToFill, unite);
+}
+
+void EdictDB::searchByReading(const QString &reading, WordSet &setToFill, bool unite) const
+{
+    QVector<quint32> found;
+    if(reading.endsWith(prefixWildcard))
+    {
+        if(reading.size() > 1)
+            store.findReading(reading.left(reading.size()-1), true, found);
+    } else if(reading.size() > 0)
+        store.findReading(reading, false, found);
+    fillSet(found, setToFill, unite);
+}
+
+void EdictDB::searchByKanji(Unicode unicode, WordSet &setToFill, bool unite) const
+{
+    QVector<quint32> found;
+    if(unicode > 0)
+        store.findKanji(unicode, found);
+    fillSet(found, setToFill, unite);
+}
+
+void EdictDB::search(const QString &s, WordSet &set) const
+{
+    // QRegExp keeps its match state, concurrent searches each use a copy
+    QRegExp regexp(searchRegexp);
+    if(s.size() < 1)
+        set.clear();
+    else if(!regexp.exactMatch(s))
+    {
+        // plain input is looked up as a headword or as a reading
+        searchByHeadword(s, set, true);
+        searchByReading(s, set, true);
+    } else
+    {
+        // same grammar as KanjiDB::search:
+        // ' ,;' unite the next keyword group results, '&+' intersect them
+        bool unite;
+        bool previousUnite = true;
+        QString copy = s;
+        while(!copy.isEmpty())
+        {
+            if(copy.startsWith(wordKey))
+                searchByHeadword(parseKey(copy, wordKey, unite), set, previousUnite);
+            else if(copy.startsWith(readingKey))
+                searchByReading(parseKey(copy, readingKey, unite), set, previousUnite);
+            else if(copy.startsWith(kanjiKey))
+            {
+                QString key = parseKey(copy, kanjiKey, unite);
+                int i = 0;
+                Unicode u = key.isEmpty() ? 0 : Kanji::codePointAt(key, i);
+                searchByKanji(i+1 == key.size() ? u : 0, set, previousUnite);
+            } else
+            {
+                set.clear();
+                copy = QString();
+            }
+            previousUnite = unite;
+        }
+    }
+}
+
+QString EdictDB::parseKey(QString &parsedString, const QString &key, bool &unite)
+{
+    QString result;
+    parsedString = parsedString.mid(key.size(), -1);
+    int index = parsedString.indexOf(QRegExp(seps));
+    if(index == -1)
+    {
+        result = parsedString;
+        parsedString = QString();
+    } else
+    {
+        unite = unionSeps.contains(parsedString.at(index));
+        result = parsedString.mid(0, index);
+        parsedString = parsedString.mid(index+1, -1);
+    }
+    return result;
+}
@@ -0,0 +1,82 @@
+#ifndef EDICTDB_H
+#define EDICTDB_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QDir>
+#include "wordstore.h"
+
+// lightweight handle on an entry of an EdictDB, strings are read from the store on demand
+class EdictEntry
+{
+public:
+    EdictEntry();
+    EdictEntry(const WordStore *, quint32);
+
+    bool isNull() const;
+    quint32 getIndex() const;
+    quint32 getSequence() const;
+    bool isCommon() const;
+    quint16 getFlags() const;
+    // empty for kana only entries
+    QStringList getHeadwords() const;
+    QStringList getReadings() const;
+    QStringList getGlosses() const;
+
+private:
+    const WordStore *store;
+    quint32 index;
+};
+
+typedef QMap<quint32, EdictEntry> WordSet;
+typedef QMapIterator<quint32, EdictEntry> WordSetConstIterator;
+
+class EdictDB
+{
+public:
+    EdictDB();
+    ~EdictDB();
+
+    void clear();
+
+    quint32 size() const;
+    EdictEntry getEntry(quint32) const;
+    void searchByHeadword(const QString &, WordSet &, bool) const;
+    void searchByReading(const QString &, WordSet &, bool) const;
+    void searchByKanji(Unicode, WordSet &, bool) const;
+    void search(const QString &, WordSet &) const;
+
+    int readResources(const QDir &);
+    bool readIndex(QIODevice *);
+    bool mapIndex(const QString &);
+    bool readEdict(QIODevice *, const char *codecName = "EUC-JP");
+    bool writeIndex(QIODevice *) const;
+
+    const QString errorString() const;
+
+    static const QString edictIndexFilename;
+    static const QString defaultEdictFilename;
+
+    static const QString wordKey;
+    static const QString readingKey;
+    static const QString kanjiKey;
+    static const int keyCount = 3;
+    static const QString allKeys[keyCount];
+    static const QString regexp;
+    static const QRegExp searchRegexp;
+    // reading=かん* matches every reading starting with かん
+    static const QChar prefixWildcard;
+
+    // cuts the first keyword group of a query, same grammar as KanjiDB::search
+    static QString parseKey(QString &parsedString, const QString &key, bool &unite);
+
+private:
+    void fillSet(const QVector<quint32> &, WordSet &, bool) const;
+
+    WordStore store;
+
+    mutable QString error;
+};
+
+#endif // EDICTDB_H
@@ -0,0 +1,608 @@
+#include "enamdictdb.h"
+#include "kanjidb.h"
+#include "readingmeaninggroup.h"
+#include "romaji.h"
+#include <QTextStream>
+#include <QTextCodec>
+#include <QRegExp>
+#include <QFile>
+#include "tracer.h"
+#include <QHash>
+#include <QtAlgorithms>
+
+const QString EnamdictDB::enamdictIndexFilename("enamdict.index");
+const QString EnamdictDB::defaultEnamdictFilename("enamdict");
+
+// same separators as KanjiDB::search, spelled out here since the initialization
+// order of KanjiDB's static strings is undefined from this translation unit
+static const QString seps("[&\\+ ,;]");
+static const QString notSeps("[^&\\+ ,;]");
+
+const QString EnamdictDB::nameKey("name=");
+const QString EnamdictDB::readingKey("reading=");
+const QString EnamdictDB::kanjiKey("kanji=");
+const QString EnamdictDB::nanoriKey("nanori=");
+const QString EnamdictDB::allKeys[keyCount] = {nameKey, readingKey, kanjiKey, nanoriKey};
+const QString EnamdictDB::regexp(KanjiDB::keysRegexp(allKeys, keyCount));
+const QRegExp EnamdictDB::searchRegexp("(("+regexp+")"+notSeps+"+)("+seps+"("+regexp+")"+notSeps+"+)*");
+
+NameEntry::NameEntry() : EdictEntry()
+{
+}
+
+NameEntry::NameEntry(const WordStore *s, quint32 i) : EdictEntry(s, i)
+{
+}
+
+quint16 NameEntry::getTypes() const
+{
+    return getFlags() & ~WordStore::commonFlag;
+}
+
+quint16 EnamdictDB::typeFromTag(const QString &tag)
+{
+    if(tag == "s")
+        return surnameType;
+    if(tag == "p")
+        return placeType;
+    if(tag == "u")
+        return personType;
+    if(tag == "g")
+        return givenType;
+    if(tag == "f")
+        return femaleType;
+    if(tag == "m")
+        return maleType;
+    if(tag == "h")
+        return fullNameType;
+    if(tag == "pr")
+        return productType;
+    if(tag == "c")
+        return companyType;
+    if(tag == "o")
+        return organizationType;
+    if(tag == "st")
+        return stationType;
+    if(tag == "wk")
+        return workType;
+    return 0;
+}
+
+// splits name readings between the kanji of the name
+class NameAligner
+{
+public:
+    NameAligner(const KanjiDB &kanjiDB) : db(kanjiDB) {}
+
+    // segments receives (kanji, reading) for each kanji of the surface
+    bool align(const QString &surface, const QString &reading, QList<QPair<Unicode, QString> > &segments);
+
+private:
+    QStringList readingsOf(Unicode);
+    bool align(int i, int j, QList<QPair<Unicode, QString> > &segments);
+
+    const KanjiDB &db;
+    QHash<Unicode, QStringList> cache;
+    QVector<Unicode> chars;
+    QString reading;
+};
+
+static void addWithSoundChanges(const QString &r, QStringList &list)
+{
+    if(r.isEmpty() || list.contains(r))
+        return;
+    list << r;
+    // rendaku: 'かわ' -> 'がわ', 'はし' -> 'ばし' or 'ぱし'
+    ushort first = r.at(0).unicode();
+    bool kst = (first >= 0x304B && first <= 0x3062 && first % 2 == 1)
+            || first == 0x3064 || first == 0x3066 || first == 0x3068;
+    bool h = first >= 0x306F && first <= 0x307B && (first - 0x306F) % 3 == 0;
+    if(kst || h)
+        list << QChar(first + 1) + r.mid(1);
+    if(h)
+        list << QChar(first + 2) + r.mid(1);
+    // gemination: 'いち' -> 'いっ', 'がく' -> 'がっ'
+    ushort last = r.at(r.size()-1).unicode();
+    if(r.size() > 1 && (last == 0x3064 || last == 0x3061 || last == 0x304F || last == 0x304D))
+        list << r.left(r.size()-1) + QChar(0x3063);
+}
+
+QStringList NameAligner::readingsOf(Unicode u)
+{
+    QHash<Unicode, QStringList>::const_iterator it = cache.constFind(u);
+    if(it != cache.constEnd())
+        return it.value();
+
+    QStringList readings;
+    const Kanji *k = db.getByUnicode(u);
+    if(k)
+    {
+        // nanori first, they are the readings specific to names
+        foreach(const QString &r, k->getNanoriReadings())
+            addWithSoundChanges(RomajiAutomaton::toHiragana(r), readings);
+        foreach(ReadingMeaningGroup *rmg, k->getReadingMeaningGroups())
+        {
+            foreach(const QString &r, rmg->getKunReadings())
+            {
+                QString kun = r;
+                kun.remove('-');
+                int dot = kun.indexOf('.');
+                if(dot != -1)
+                    addWithSoundChanges(kun.left(dot), readings);
+                kun.remove('.');
+                addWithSoundChanges(kun, readings);
+            }
+            foreach(const QString &r, rmg->getOnReadings())
+            {
+                QString on = r;
+                on.remove('-');
+                addWithSoundChanges(RomajiAutomaton::toHiragana(on), readings);
+            }
+        }
+    }
+    cache.insert(u, readings);
+    return readings;
+}
+
+bool NameAligner::align(const QString &surface, const QString &r, QList<QPair<Unicode, QString> > &segments)
+{
+    chars.clear();
+    for(int i = 0; i < surface.size(); ++i)
+        chars.append(Kanji::codePointAt(surface, i));
+    reading = RomajiAutomaton::toHiragana(r);
+    segments.clear();
+    return align(0, 0, segments);
+}
+
+bool NameAligner::align(int i, int j, QList<QPair<Unicode, QString> > &segments)
+{
+    if(i == chars.size())
+        return j == reading.size();
+    if(j >= reading.size())
+        return false;
+
+    Unicode c = chars.at(i);
+    // ke of place names is read ka, ga or ke, ie: '霞ヶ関'
+    if(c == 0x30F6 || c == 0x30F5 || c == 0x30B1)
+    {
+        static const ushort ke[] = {0x304B, 0x304C, 0x3051, 0x3052};
+        for(unsigned int n = 0; n < sizeof(ke)/sizeof(ushort); ++n)
+            if(reading.at(j).unicode() == ke[n] && align(i+1, j+1, segments))
+                return true;
+        return false;
+    }
+    // kana of the surface are read as they are
+    if((c >= 0x3041 && c <= 0x3096) || (c >= 0x30A1 && c <= 0x30F4))
+    {
+        ushort h = c >= 0x30A1 ? c - 0x60 : c;
+        return reading.at(j).unicode() == h && align(i+1, j+1, segments);
+    }
+    // iteration mark repeats the previous kanji
+    Unicode u = c;
+    if(c == 0x3005 && i > 0)
+        u = chars.at(i-1);
+    if(!WordStoreBuilder::isIdeograph(u))
+        return false;
+
+    // a copy: recursing may grow the cache
+    QStringList candidates = readingsOf(u);
+    foreach(const QString &candidate, candidates)
+    {
+        if(reading.midRef(j, candidate.size()) == candidate)
+        {
+            segments.append(qMakePair(u, candidate));
+            if(align(i+1, j + candidate.size(), segments))
+                return true;
+            segments.removeLast();
+        }
+    }
+    return false;
+}
+
+struct PostingItem
+{
+    Unicode unicode;
+    QString reading;
+    quint32 entry;
+
+    bool operator<(const PostingItem &other) const
+    {
+        if(unicode != other.unicode)
+            return unicode < other.unicode;
+        if(reading != other.reading)
+            return reading < other.reading;
+        return entry < other.entry;
+    }
+    bool operator==(const PostingItem &other) const
+    {
+        return unicode == other.unicode && reading == other.reading && entry == other.entry;
+    }
+};
+
+EnamdictDB::EnamdictDB() : postings(0), postingsSize(0)
+{
+}
+
+EnamdictDB::~EnamdictDB()
+{
+    clear();
+}
+
+void EnamdictDB::clear()
+{
+    store.clear();
+    postings = 0;
+    postingsSize = 0;
+}
+
+quint32 EnamdictDB::size() const
+{
+    return store.entryCount();
+}
+
+NameEntry EnamdictDB::getEntry(quint32 index) const
+{
+    if(index >= store.entryCount())
+        return NameEntry();
+    return NameEntry(&store, index);
+}
+
+bool EnamdictDB::setupPostings()
+{
+    if(!checkPostings(store))
+    {
+        error = QString("Corrupted name postings");
+        clear();
+        return false;
+    }
+    postings = (const NanoriPosting *) store.auxiliary();
+    postingsSize = store.auxiliarySize() / sizeof(NanoriPosting);
+    return true;
+}
+
+// the postings refer to the readings and entries of the store by index
+bool EnamdictDB::checkPostings(const WordStore &s)
+{
+    const NanoriPosting *p = (const NanoriPosting *) s.auxiliary();
+    quint32 size = s.auxiliarySize() / sizeof(NanoriPosting);
+    for(quint32 i = 0; i < size; ++i)
+        if(p[i].reading >= s.stringCount() || p[i].entry >= s.entryCount())
+            return false;
+    return true;
+}
+
+int EnamdictDB::readResources(const QDir &basedir, const KanjiDB &kanjiDB)
+{
+    error = QString();
+
+    QString indexPath = basedir.absolutePath().append("/").append(enamdictIndexFilename);
+    if(mapIndex(indexPath))
+        return KanjiDB::allDataReadAndSaved;
+
+    QFile enamdictFile(basedir.absolutePath().append("/").append(defaultEnamdictFilename));
+    if (!enamdictFile.open(QIODevice::ReadOnly)) {
+        error = QString("Cannot open enamdict file %1.")
+                          .arg(defaultEnamdictFilename);
+        return KanjiDB::noDataRead;
+    }
+    if(!readEnamdict(&enamdictFile, kanjiDB))
+    {
+        error = QString("Cannot read enamdict file %1:\n%2.")
+                          .arg(defaultEnamdictFilename)
+                          .arg(error);
+        return KanjiDB::noDataRead;
+    }
+    enamdictFile.close();
+
+    QFile index(indexPath);
+    if(!index.open(QIODevice::WriteOnly))
+    {
+        error = QString("Cannot open index file %1 for writing.")
+                          .arg(enamdictIndexFilename);
+        return KanjiDB::allDataReadButNotSaved;
+    }
+    bool saved = writeIndex(&index);
+    index.close();
+    if(!saved)
+    {
+        error = QString("Cannot write index file %1.")
+                          .arg(enamdictIndexFilename);
+        return KanjiDB::allDataReadButNotSaved;
+    }
+    // switch to the mapped file so the parsed copy is released, it is kept if the mapping fails
+    if(!mapIndex(indexPath))
+    {
+        error = QString("Cannot map index file %1:\n%2.")
+                          .arg(enamdictIndexFilename)
+                          .arg(error);
+        return KanjiDB::allDataReadButNotSaved;
+    }
+    return KanjiDB::allDataReadAndSaved;
+}
+
+bool EnamdictDB::readIndex(QIODevice *device)
+{
+    if(!store.read(device))
+    {
+        error = store.errorString();
+        clear();
+        return false;
+    }
+    error = QString();
+    return setupPostings();
+}
+
+bool EnamdictDB::mapIndex(const QString &fileName)
+{
+    // the current store and postings stay in use until the file is mapped
+    WordStore mapped;
+    if(!mapped.map(fileName))
+    {
+        error = mapped.errorString();
+        return false;
+    }
+    if(!checkPostings(mapped))
+    {
+        error = QString("Corrupted name postings");
+        return false;
+    }
+    store.swap(mapped);
+    error = QString();
+    return setupPostings();
+}
+
+bool EnamdictDB::writeIndex(QIODevice *device) const
+{
+    if(!store.write(device))
+    {
+        error = store.errorString();
+        return false;
+    }
+    error = QString();
+    return true;
+}
+
+bool EnamdictDB::readEnamdict(QIODevice *device, const KanjiDB &kanjiDB, const char *codecName)
+{
+    TraceSpan span("enamdict read");
+    QTextCodec *codec = QTextCodec::codecForName(codecName);
+    if(codec == 0)
+    {
+        error = QString("Unknown codec %1").arg(codecName);
+        return false;
+    }
+    QTextStream ts(device);
+    ts.setAutoDetectUnicode(false);
+    ts.setCodec(codec);
+
+    WordStoreBuilder builder;
+    NameAligner aligner(kanjiDB);
+    QList<QPair<Unicode, QString> > segments;
+    QVector<PostingItem> items;
+    QStringList surfaces, readings, glosses;
+    quint32 sequence;
+    bool common;
+    QString line;
+    // the first line is the file header
+    ts.readLine();
+    while(!(line = ts.readLine()).isNull())
+    {
+        if(!WordStoreBuilder::parseEdictLine(line, surfaces, readings, glosses, sequence, common))
+            continue;
+        // '(s,p) Abe': the types prefix the first gloss
+        quint16 flags = common ? WordStore::commonFlag : 0;
+        if(!glosses.isEmpty() && glosses.first().startsWith('('))
+        {
+            int end = glosses.first().indexOf(')');
+            if(end != -1)
+            {
+                foreach(const QString &tag, glosses.first().mid(1, end-1).split(','))
+                    flags |= typeFromTag(tag.trimmed());
+                glosses.first() = glosses.first().mid(end+1).trimmed();
+            }
+        }
+        quint32 entry = builder.addEntry(sequence, flags, surfaces, readings, glosses);
+
+        foreach(const QString &surface, surfaces)
+            foreach(const QString &reading, readings)
+                if(aligner.align(surface, reading, segments))
+                    for(int i = 0; i < segments.size(); ++i)
+                    {
+                        PostingItem item;
+                        item.unicode = segments.at(i).first;
+                        item.reading = segments.at(i).second;
+                        item.entry = entry;
+                        items.append(item);
+                    }
+    }
+    if(builder.size() == 0)
+    {
+        error = QString("Not an enamdict file");
+        return false;
+    }
+
+    qSort(items.begin(), items.end());
+    QHash<QString, quint32> readingStrings;
+    QVector<NanoriPosting> nanoriPostings;
+    nanoriPostings.reserve(items.size());
+    for(int i = 0; i < items.size(); ++i)
+    {
+        const PostingItem &item = items.at(i);
+        if(i > 0 && item == items.at(i-1))
+            continue;
+        QHash<QString, quint32>::const_iterator it = readingStrings.constFind(item.reading);
+        if(it == readingStrings.constEnd())
+            it = readingStrings.insert(item.reading, builder.addString(item.reading));
+        NanoriPosting posting;
+        posting.unicode = item.unicode;
+        posting.reading = it.value();
+        posting.entry = item.entry;
+        nanoriPostings.append(posting);
+    }
+    builder.setAuxiliary(QByteArray((const char *) nanoriPostings.constData(),
+                                    nanoriPostings.size() * sizeof(NanoriPosting)));
+
+    if(!store.attach(builder.build()))
+    {
+        error = store.errorString();
+        clear();
+        return false;
+    }
+    error = QString();
+    return setupPostings();
+}
+
+const QString EnamdictDB::errorString() const
+{
+    return error;
+}
+
+quint32 EnamdictDB::firstPosting(Unicode u) const
+{
+    quint32 first = 0, count = postingsSize;
+    while(count > 0)
+    {
+        quint32 step = count / 2;
+        if(postings[first+step].unicode < u)
+        {
+            first += step + 1;
+            count -= step + 1;
+        } else
+            count = step;
+    }
+    return first;
+}
+
+QMap<QString, int> EnamdictDB::getNameReadings(Unicode u) const
+{
+    QMap<QString, int> readings;
+    // postings of a kanji are grouped by reading
+    quint32 i = firstPosting(u);
+    while(i < postingsSize && postings[i].unicode == u)
+    {
+        quint32 reading = postings[i].reading;
+        int count = 0;
+        for(; i < postingsSize && postings[i].unicode == u && postings[i].reading == reading; ++i)
+            ++count;
+        readings.insert(store.string(reading), count);
+    }
+    return readings;
+}
+
+void EnamdictDB::fillSet(const QVector<quint32> &found, NameSet &setToFill, bool unite) const
+{
+    if(unite)
+        foreach(quint32 i, found)
+            setToFill.insert(i, NameEntry(&store, i));
+    else
+    {
+        NameSet intersection;
+        foreach(quint32 i, found)
+            if(setToFill.contains(i))
+                intersection.insert(i, setToFill.value(i));
+        setToFill = intersection;
+    }
+}
+
+void EnamdictDB::searchBySurface(const QString &surface, NameSet &setToFill, bool unite) const
+{
+    QVector<quint32> found;
+    if(surface.size() > 0)
+        store.findHeadword(surface, found);
+    fillSet(found, setToFill, unite);
+}
+
+void EnamdictDB::searchByReading(const QString &reading, NameSet &setToFill, bool unite) const
+{
+    QVector<quint32> found;
+    if(reading.endsWith(EdictDB::prefixWildcard))
+    {
+        if(reading.size() > 1)
+            store.findReading(reading.left(reading.size()-1), true, found);
+    } else if(reading.size() > 0)
+        store.findReading(reading, false, found);
+    fillSet(found, setToFill, unite);
+}
+
+void EnamdictDB::searchByKanji(Unicode unicode, NameSet &setToFill, bool unite) const
+{
+    QVector<quint32> found;
+    if(unicode > 0)
+        store.findKanji(unicode, found);
+    fillSet(found, setToFill, unite);
+}
+
+void EnamdictDB::searchByKanjiReading(Unicode unicode, const QString &reading, NameSet &setToFill, bool unite) const
+{
+    QVector<quint32> found;
+    QString hiragana = RomajiAutomaton::toHiragana(reading);
+    // readings are sorted within the postings of a kanji
+    quint32 first = firstPosting(unicode);
+    quint32 last = first;
+    while(last < postingsSize && postings[last].unicode == unicode)
+        ++last;
+    quint32 count = last - first;
+    while(count > 0)
+    {
+        quint32 step = count / 2;
+        if(store.string(postings[first+step].reading) < hiragana)
+        {
+            first += step + 1;
+            count -= step + 1;
+        } else
+            count = step;
+    }
+    for(quint32 i = first; i < last && store.string(postings[i].reading) == hiragana; ++i)
+        found.append(postings[i].entry);
+    fillSet(found, setToFill, unite);
+}
+
+void EnamdictDB::search(const QString &s, NameSet &set) const
+{
+    // QRegExp keeps its match state, concurrent searches each use a copy
+    QRegExp regexp(searchRegexp);
+    if(s.size() < 1)
+        set.clear();
+    else if(!regexp.exactMatch(s))
+    {
+        searchBySurface(s, set, true);
+        searchByReading(s, set, true);
+    } else
+    {
+        bool unite;
+        bool previousUnite = true;
+        QString copy = s;
+        while(!copy.isEmpty())
+        {
+            if(copy.startsWith(nameKey))
+                searchBySurface(EdictDB::parseKey(copy, nameKey, unite), set, previousUnite);
+            else if(copy.startsWith(readingKey))
+                searchByReading(EdictDB::parseKey(copy, readingKey, unite), set, previousUnite);
+            else if(copy.startsWith(kanjiKey))
+            {
+                QString key = EdictDB::parseKey(copy, kanjiKey, unite);
+                int i = 0;
+                Unicode u = key.isEmpty() ? 0 : Kanji::codePointAt(key, i);
+                searchByKanji(i+1 == key.size() ? u : 0, set, previousUnite);
+            } else if(copy.startsWith(nanoriKey))
+            {
+                // nanori=正:まさ or nanori=正まさ
+                QString key = EdictDB::parseKey(copy, nanoriKey, unite);
+                int i = 0;
+                Unicode u = key.isEmpty() ? 0 : Kanji::codePointAt(key, i);
+                QString reading = key.mid(i+1);
+                if(reading.startsWith(':'))
+                    reading = reading.mid(1);
+                if(u > 0 && !reading.isEmpty())
+                    searchByKanjiReading(u, reading, set, previousUnite);
+                else if(!previousUnite)
+                    set.clear();
+            } else
+            {
+                set.clear();
+                copy = QString();
+            }
+            previousUnite = unite;
+        }
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef ENAMDICTDB_H
+#define ENAMDICTDB_H
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QDir>
+#include "wordstore.h"
+#include "edictdb.h"
+
+class KanjiDB;
+
+// a name entry is an edict entry whose glosses are romanizations, plus name types
+class NameEntry : public EdictEntry
+{
+public:
+    NameEntry();
+    NameEntry(const WordStore *, quint32);
+
+    quint16 getTypes() const;
+};
+
+typedef QMap<quint32, NameEntry> NameSet;
+typedef QMapIterator<quint32, NameEntry> NameSetConstIterator;
+
+// (kanji, reading it takes in the name, name entry), sorted in this order,
+// the reading is a string of the store pool
+struct NanoriPosting
+{
+    quint32 unicode;
+    quint32 reading;
+    quint32 entry;
+};
+
+class EnamdictDB
+{
+public:
+    EnamdictDB();
+    ~EnamdictDB();
+
+    void clear();
+
+    quint32 size() const;
+    NameEntry getEntry(quint32) const;
+    void searchBySurface(const QString &, NameSet &, bool) const;
+    void searchByReading(const QString &, NameSet &, bool) const;
+    void searchByKanji(Unicode, NameSet &, bool) const;
+    // names containing the kanji read as reading
+    void searchByKanjiReading(Unicode, const QString &reading, NameSet &, bool) const;
+    void search(const QString &, NameSet &) const;
+
+    // readings the kanji takes in names, with the number of names for each
+    QMap<QString, int> getNameReadings(Unicode) const;
+
+    // the kanji database provides the nanori, on and kun readings
+    // used to split each name reading between its kanji
+    int readResources(const QDir &, const KanjiDB &);
+    bool readIndex(QIODevice *);
+    bool mapIndex(const QString &);
+    bool readEnamdict(QIODevice *, const KanjiDB &, const char *codecName = "EUC-JP");
+    bool writeIndex(QIODevice *) const;
+
+    const QString errorString() const;
+
+    static const QString enamdictIndexFilename;
+    static const QString defaultEnamdictFilename;
+
+    static const QString nameKey;
+    static const QString readingKey;
+    static const QString kanjiKey;
+    static const QString nanoriKey;
+    static const int keyCount = 4;
+    static const QString allKeys[keyCount];
+    static const QString regexp;
+    static const QRegExp searchRegexp;
+
+    // name types, stored in the entry flags
+    static const quint16 surnameType = 0x0002;
+    static const quint16 placeType = 0x0004;
+    static const quint16 personType = 0x0008;
+    static const quint16 givenType = 0x0010;
+    static const quint16 femaleType = 0x0020;
+    static const quint16 maleType = 0x0040;
+    static const quint16 fullNameType = 0x0080;
+    static const quint16 productType = 0x0100;
+    static const quint16 companyType = 0x0200;
+    static const quint16 organizationType = 0x0400;
+    static const quint16 stationType = 0x0800;
+    static const quint16 workType = 0x1000;
+    static quint16 typeFromTag(const QString &);
+
+private:
+    bool setupPostings();
+    static bool checkPostings(const WordStore &);
+    void fillSet(const QVector<quint32> &, NameSet &, bool) const;
+    quint32 firstPosting(Unicode) const;
+
+    WordStore store;
+    const NanoriPosting *postings;
+    quint32 postingsSize;
+
+    mutable QString error;
+};
+
+#endif // ENAMDICTDB_H
@@ -1,6 +1,7 @@
 #include "kanji.h"
+#include "memoryusage.h"
 
-Kanji::Kanji() : unicode(0), classicalRadical(0), nelsonRadical(0), grade(0), strokeCount(0), frequency(0), jlpt(0)
+Kanji::Kanji() : unicode(0), id(0), classicalRadical(0), nelsonRadical(0), grade(0), strokeCount(0), frequency(0), jlpt(0)
 {
 }
 
@@ -13,70 +14,125 @@ Kanji::~Kanji()
 
 QDataStream &operator >>(QDataStream &stream, Kanji &k)
 {
-    foreach(ReadingMeaningGroup *rmg, k.rmGroups)
+    k.readAttributes(stream);
+    k.readCodes(stream);
+    k.readReadings(stream);
+    k.readMeanings(stream);
+    return stream;
+}
+
+QDataStream &operator <<(QDataStream &stream, const Kanji &k)
+{
+    k.writeAttributes(stream);
+    k.writeCodes(stream);
+    k.writeReadings(stream);
+    k.writeMeanings(stream);
+    return stream;
+}
+
+void Kanji::readAttributes(QDataStream &stream)
+{
+    components.clear();
+    stream >> literal;
+    stream >> unicode;
+    stream >> (quint8&) classicalRadical;
+    stream >> components;
+    stream >> (quint8&) nelsonRadical;
+    stream >> (quint8&) grade;
+    stream >> (quint8&) strokeCount;
+    stream >> (quint16&) frequency;
+    stream >> (quint8&) jlpt;
+}
+
+void Kanji::writeAttributes(QDataStream &stream) const
+{
+    stream << literal;
+    stream << unicode;
+    stream << (quint8&) classicalRadical;
+    stream << components;
+    stream << (quint8&) nelsonRadical;
+    stream << (quint8&) grade;
+    stream << (quint8&) strokeCount;
+    stream << (quint16&) frequency;
+    stream << (quint8&) jlpt;
+}
+
+void Kanji::readCodes(QDataStream &stream)
+{
+    unicodeVariants.clear();
+    jis208Variants.clear();
+    jis212Variants.clear();
+    jis213Variants.clear();
+    radicalNames.clear();
+    stream >> jis208;
+    stream >> jis212;
+    stream >> jis213;
+    stream >> unicodeVariants;
+    stream >> jis208Variants;
+    stream >> jis212Variants;
+    stream >> jis213Variants;
+    stream >> radicalNames;
+}
+
+void Kanji::writeCodes(QDataStream &stream) const
+{
+    stream << jis208;
+    stream << jis212;
+    stream << jis213;
+    stream << unicodeVariants;
+    stream << jis208Variants;
+    stream << jis212Variants;
+    stream << jis213Variants;
+    stream << radicalNames;
+}
+
+void Kanji::readReadings(QDataStream &stream)
+{
+    foreach(ReadingMeaningGroup *rmg, rmGroups)
         delete rmg;
-    k.rmGroups.clear();
-    k.unicodeVariants.clear();;
-    k.jis208Variants.clear();
-    k.jis212Variants.clear();
-    k.jis213Variants.clear();
-    k.radicalNames.clear();
-    k.nanoriReadings.clear();
-    k.components.clear();
-
-    stream >> k.literal;
-    stream >> k.unicode;
-    stream >> k.jis208;
-    stream >> k.jis212;
-    stream >> k.jis213;
-    stream >> (quint8&) k.classicalRadical;
-    stream >> k.components;
-    stream >> (quint8&) k.nelsonRadical;
-    stream >> (quint8&) k.grade;
-    stream >> (quint8&) k.strokeCount;
-    stream >> k.unicodeVariants;
-    stream >> k.jis208Variants;
-    stream >> k.jis212Variants;
-    stream >> k.jis213Variants;
-    stream >> (quint16&) k.frequency;
-    stream >> k.radicalNames;
-    stream >> (quint8&) k.jlpt;
+    rmGroups.clear();
+    nanoriReadings.clear();
     quint32 rmgSize;
     stream >> rmgSize;
     for(quint32 i = 0; i < rmgSize; ++i)
     {
         ReadingMeaningGroup *rmg = new ReadingMeaningGroup;
-        stream >> *rmg;
-        k.rmGroups.append(rmg);
+        rmg->readReadings(stream);
+        rmGroups.append(rmg);
     }
-    stream >> k.nanoriReadings;
-    return stream;
+    stream >> nanoriReadings;
 }
 
-QDataStream &operator <<(QDataStream &stream, const Kanji &k)
+void Kanji::writeReadings(QDataStream &stream) const
 {
-    stream << k.literal;
-    stream << k.unicode;
-    stream << k.jis208;
-    stream << k.jis212;
-    stream << k.jis213;
-    stream << (quint8&) k.classicalRadical;
-    stream << k.components;
-    stream << (quint8&) k.nelsonRadical;
-    stream << (quint8&) k.grade;
-    stream << (quint8&) k.strokeCount;
-    stream << k.unicodeVariants;
-    stream << k.jis208Variants;
-    stream << k.jis212Variants;
-    stream << k.jis213Variants;
-    stream << (quint16&) k.frequency;
-    stream << k.radicalNames;
-    stream << (quint8&) k.jlpt;
-    stream << k.rmGroups.size();
-    foreach(ReadingMeaningGroup *rmg, k.rmGroups)
-        stream << *rmg;
-    stream << k.nanoriReadings;
-    return stream;
+    stream << rmGroups.size();
+    foreach(ReadingMeaningGroup *rmg, rmGroups)
+        rmg->writeReadings(stream);
+    stream << nanoriReadings;
+}
+
+void Kanji::readMeanings(QDataStream &stream)
+{
+    // one entry per group read with the readings
+    quint32 rmgSize;
+    stream >> rmgSize;
+    for(quint32 i = 0; i < rmgSize; ++i)
+    {
+        if(i < (quint32) rmGroups.size())
+            rmGroups.at(i)->readMeanings(stream);
+        else
+        {
+            ReadingMeaningGroup unused;
+            unused.readMeanings(stream);
+        }
+    }
+}
+
+void Kanji::writeMeanings(QDataStream &stream) const
+{
+    stream << rmGroups.size();
+    foreach(ReadingMeaningGroup *rmg, rmGroups)
+        rmg->writeMeanings(stream);
 }
 
 const QString &Kanji::getLiteral() const
@@ -99,6 +155,40 @@ void Kanji::setUnicode(Unicode u)
     unicode = u;
 }
 
+void Kanji::swap(Kanji &other)
+{
+    qSwap(literal, other.literal);
+    qSwap(unicode, other.unicode);
+    qSwap(id, other.id);
+    qSwap(jis208, other.jis208);
+    qSwap(jis212, other.jis212);
+    qSwap(jis213, other.jis213);
+    qSwap(classicalRadical, other.classicalRadical);
+    qSwap(nelsonRadical, other.nelsonRadical);
+    qSwap(grade, other.grade);
+    qSwap(strokeCount, other.strokeCount);
+    qSwap(unicodeVariants, other.unicodeVariants);
+    qSwap(components, other.components);
+    qSwap(jis208Variants, other.jis208Variants);
+    qSwap(jis212Variants, other.jis212Variants);
+    qSwap(jis213Variants, other.jis213Variants);
+    qSwap(frequency, other.frequency);
+    qSwap(radicalNames, other.radicalNames);
+    qSwap(jlpt, other.jlpt);
+    qSwap(rmGroups, other.rmGroups);
+    qSwap(nanoriReadings, other.nanoriReadings);
+}
+
+KanjiId Kanji::getId() const
+{
+    return id;
+}
+
+void Kanji::setId(KanjiId i)
+{
+    id = i;
+}
+
 const QString &Kanji::getJis208() const
 {
     return jis208;
@@ -269,3 +359,31 @@ const QSet<Unicode> &Kanji::getComponents() const
 {
     return components;
 }
+
+quint64 Kanji::memoryUsage() const
+{
+    return sizeof(Kanji)
+            + MemoryUsage::string(literal)
+            + MemoryUsage::string(jis208)
+            + MemoryUsage::string(jis212)
+            + MemoryUsage::string(jis213)
+            + MemoryUsage::set(unicodeVariants)
+            + MemoryUsage::set(components)
+            + MemoryUsage::set(jis208Variants)
+            + MemoryUsage::set(jis212Variants)
+            + MemoryUsage::set(jis213Variants)
+            + MemoryUsage::set(radicalNames)
+            + MemoryUsage::list(rmGroups)
+            + MemoryUsage::set(nanoriReadings);
+}
+
+Unicode Kanji::codePointAt(const QString &s, int &i)
+{
+    QChar c = s.at(i);
+    if(c.isHighSurrogate() && i + 1 < s.length() && s.at(i + 1).isLowSurrogate())
+    {
+        ++i;
+        return QChar::surrogateToUcs4(c, s.at(i));
+    }
+    return c.unicode();
+}
@@ -8,6 +8,8 @@
 #include "readingmeaninggroup.h"
 
 typedef unsigned int Unicode;
+// position of a kanji in its database, ids are dense and start at 0
+typedef quint16 KanjiId;
 
 class Kanji
 {
@@ -16,6 +18,7 @@ public:
     ~Kanji();
     const QString &getLiteral() const;
     Unicode getUnicode() const;
+    KanjiId getId() const;
     const QString &getJis208() const;
     const QString &getJis212() const;
     const QString &getJis213() const;
@@ -34,12 +37,29 @@ public:
     unsigned char getJLPT() const;
     const QList<ReadingMeaningGroup *> & getReadingMeaningGroups() const;
     const QSet<QString> & getNanoriReadings() const;
+    // estimated bytes held by the kanji, reading meaning groups excluded
+    quint64 memoryUsage() const;
 
     friend QDataStream &operator <<(QDataStream &stream, const Kanji &);
     friend QDataStream &operator >>(QDataStream &stream, Kanji &);
+    // the parts of a record, in stream order, the index keeps each part of all kanjis together
+    // attributes: literal, unicode, radicals, components, grade, strokes, frequency, JLPT
+    void readAttributes(QDataStream &);
+    void writeAttributes(QDataStream &) const;
+    // JIS codes, variants and names as radical
+    void readCodes(QDataStream &);
+    void writeCodes(QDataStream &) const;
+    // reading meaning groups without their meanings, nanori
+    void readReadings(QDataStream &);
+    void writeReadings(QDataStream &) const;
+    // meanings of the groups already read
+    void readMeanings(QDataStream &);
+    void writeMeanings(QDataStream &) const;
 
     void setLiteral(const QString &);
     void setUnicode(Unicode);
+    // given by the database, not streamed
+    void setId(KanjiId);
     void setJis208(const QString &);
     void setJis212(const QString &);
     void setJis213(const QString &);
@@ -57,11 +77,16 @@ public:
     void setJLPT(unsigned char);
     void addReadingMeaningGroup(ReadingMeaningGroup *);
     void addNanoriReading(const QString &);
+    // exchanges the whole content, id included
+    void swap(Kanji &);
 
+    // the code point at i, a surrogate pair is read whole and i is left on its low surrogate
+    static Unicode codePointAt(const QString &, int &i);
 
 private:
     QString literal;
     Unicode unicode;
+    KanjiId id;
     QString jis208;
     QString jis212;
     QString jis213;
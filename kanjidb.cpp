@@ -5,6 +5,16 @@
 #include <QRegExp>
 #include <QTextCodec>
 #include "radicals.h"
+#include "memoryusage.h"
+#include "querystatistics.h"
+#include "tracer.h"
+#include "workstealingpool.h"
+#include "romaji.h"
+#include "rangeindex.h"
+#include "kanjiidset.h"
+#include <QElapsedTimer>
+#include <QHash>
+#include <algorithm>
 
 #include <iostream>
 
@@ -15,7 +25,12 @@ const QString KanjiDB::defaultKRad2Filename("kradfile2");
 const QString KanjiDB::defaultRadKXFilename("radkfilexUTF8");
 
 const quint32 KanjiDB::magic = 0x5AD5AD15;
-const quint32 KanjiDB::version = 153;
+const quint32 KanjiDB::version = 161;
+const quint32 KanjiDB::noCluster;
+
+const double KanjiDB::componentWeight = 0.7;
+const double KanjiDB::radicalWeight = 0.2;
+const double KanjiDB::strokesWeight = 0.1;
 
 const QString KanjiDB::interSeps("&\\+");
 const QString KanjiDB::unionSeps(" ,;");
@@ -32,194 +47,252 @@ const QString KanjiDB::jis212Key("jis212=");
 const QString KanjiDB::jis213Key("jis213=");
 const QString KanjiDB::radicalKey("radical=");
 const QString KanjiDB::componentKey("component=");
-const QString KanjiDB::allKeys[keyCount] = {gradeKey, jlptKey, jis208Key, jis212Key, jis213Key, componentKey, radicalKey, strokesKey, strokesLessKey, strokesMoreKey, ucsKey};
-const QString KanjiDB::regexp(fromArray(allKeys, keyCount).join("|"));
+const QString KanjiDB::romajiKey("romaji=");
+const QString KanjiDB::nelsonKey("nelson=");
+const QString KanjiDB::radicalNameKey("radname=");
+const QString KanjiDB::strokesLessEqualKey("strokes<=");
+const QString KanjiDB::strokesMoreEqualKey("strokes>=");
+const QString KanjiDB::strokesAroundKey("strokes~");
+const QString KanjiDB::frequencyKey("freq=");
+const QString KanjiDB::frequencyLessKey("freq<");
+const QString KanjiDB::frequencyMoreKey("freq>");
+const QString KanjiDB::frequencyLessEqualKey("freq<=");
+const QString KanjiDB::frequencyMoreEqualKey("freq>=");
+const QString KanjiDB::gradeLessKey("grade<");
+const QString KanjiDB::gradeMoreKey("grade>");
+const QString KanjiDB::gradeLessEqualKey("grade<=");
+const QString KanjiDB::gradeMoreEqualKey("grade>=");
+const QString KanjiDB::jlptLessKey("jlpt<");
+const QString KanjiDB::jlptMoreKey("jlpt>");
+const QString KanjiDB::jlptLessEqualKey("jlpt<=");
+const QString KanjiDB::jlptMoreEqualKey("jlpt>=");
+const QString KanjiDB::skipKey("skip=");
+const QString KanjiDB::fourCornerKey("four=");
+const QString KanjiDB::deRooKey("deroo=");
+const QString KanjiDB::referenceKey("ref.");
+// a key must come before the keys it starts with, "strokes<=" before "strokes<"
+const QString KanjiDB::allKeys[keyCount] = {gradeKey, gradeLessEqualKey, gradeMoreEqualKey, gradeLessKey, gradeMoreKey,
+                                            jlptKey, jlptLessEqualKey, jlptMoreEqualKey, jlptLessKey, jlptMoreKey,
+                                            jis208Key, jis212Key, jis213Key, componentKey, radicalKey,
+                                            strokesKey, strokesLessEqualKey, strokesMoreEqualKey, strokesLessKey, strokesMoreKey, strokesAroundKey,
+                                            frequencyKey, frequencyLessEqualKey, frequencyMoreEqualKey, frequencyLessKey, frequencyMoreKey,
+                                            ucsKey, romajiKey, nelsonKey, radicalNameKey,
+                                            skipKey, fourCornerKey, deRooKey, referenceKey};
+const QString KanjiDB::rangeSeparator("..");
+const QString KanjiDB::regexp(keysRegexp(allKeys, keyCount));
 const QRegExp KanjiDB::searchRegexp("(("+regexp+")"+notSeps+"+)("+seps+"("+regexp+")"+notSeps+"+)*");
 
-KanjiDB::KanjiDB()
+// Kanji objects of the classical radicals, built once from the static tables
+// and shared by every database
+struct RadicalSet
+{
+    RadicalSet();
+    ~RadicalSet();
+
+    KanjiSet radicals;
+    // by radical number, 0 is unused
+    Kanji *byId[Radicals::radicalsSize + 1];
+    // in the order of Radicals::characters
+    Kanji *byCharacter[Radicals::charactersSize];
+};
+
+RadicalSet::RadicalSet()
+{
+    byId[0] = 0;
+    for(unsigned int i = 0; i < Radicals::charactersSize; ++i)
+    {
+        const RadicalCharacter &c = Radicals::characters[i];
+        Kanji *k = new Kanji();
+        k->setClassicalRadical(c.radical);
+        k->setLiteral(QChar(c.unicode));
+        k->setUnicode(c.unicode);
+        k->setStrokeCount(c.strokes);
+        radicals.insert(c.unicode, k);
+        byCharacter[i] = k;
+    }
+    for(unsigned int i = 0; i < Radicals::radicalsSize; ++i)
+    {
+        Kanji *masterRadical = radicals.value(Radicals::radicals[i].unicode);
+        for(unsigned int v = Radicals::variantOffsets[i]; v < Radicals::variantOffsets[i+1]; ++v)
+            masterRadical->addUnicodeVariant(Radicals::variants[v]);
+        byId[i+1] = masterRadical;
+    }
+}
+
+RadicalSet::~RadicalSet()
+{
+    foreach(Kanji *k, radicals)
+        delete k;
+}
+
+Q_GLOBAL_STATIC(RadicalSet, radicalSet)
+
+KanjiDB::KanjiDB() : kanjiRecords(0), recordCount(0), radicals(radicalSet()),
+    languages(ReadingMeaningGroup::allLanguages), loadProfile(fullProfile), queryStatistics(0)
 {
     //empty list returned when no match found
     maxStrokes = 0;
     minStrokes = 255;
-    initRadicals();
 }
 
 KanjiDB::~KanjiDB()
 {
     clear();
-    foreach(Kanji *k, radicals.values())
-        delete k;
-    radicals.clear();
-    radicalsByIndex.clear();
 }
 
 void KanjiDB::clear()
 {
-    //all kanjis are referenced by the unicode map
-    //delete them once from here, clean the rest
-    foreach(Kanji *k, kanjis.values())
-        delete k;
+    queryCache.invalidate();
+    //kanjis are in the record block or, while a kanjidic is read, on their own
+    //the indexes only hold ids
+    for(int i = recordCount; i < kanjisById.size(); ++i)
+        delete kanjisById.at(i);
+    delete[] kanjiRecords;
+    kanjiRecords = 0;
+    recordCount = 0;
+    kanjisById.clear();
     kanjis.clear();
     kanjisJIS208.clear();
     kanjisJIS212.clear();
     kanjisJIS213.clear();
-
-    foreach(QSet<Kanji *> *set, kanjisByStroke)
-    {
-        set->clear();
-        delete set;
-    }
     kanjisByStroke.clear();
-    foreach(QSet<Kanji *> *set, kanjisByJLPT)
-    {
-        set->clear();
-        delete set;
-    }
     kanjisByJLPT.clear();
-    foreach(QSet<Kanji *> *set, kanjisByGrade)
-    {
-        set->clear();
-        delete set;
-    }
     kanjisByGrade.clear();
-    foreach(QSet<Kanji *> *set, kanjisByRadical)
-    {
-        set->clear();
-        delete set;
-    }
     kanjisByRadical.clear();
+    kanjisByNelsonRadical.clear();
+    kanjisByRadicalName.clear();
+    kanjisBySkip.clear();
+    kanjisByFourCorner.clear();
+    kanjisByDeRoo.clear();
+    referenceColumns.clear();
     foreach(Kanji *k, components.values())
         delete k;
     components.clear();
     componentIndexes.clear();
-    foreach(QSet<Kanji *> *set, kanjisByComponent)
-    {
-        set->clear();
-        delete set;
-    }
     kanjisByComponent.clear();
+    variantClusterIds.clear();
+    variantClusterOffsets.clear();
+    variantMembers.clear();
+    componentMasks.clear();
+    readingIndex.clear();
+    strokesRange.clear();
+    frequencyRange.clear();
+    gradeRange.clear();
+    jlptRange.clear();
+    skipRange.clear();
+    fourCornerRange.clear();
+    deRooRange.clear();
+    referenceRanges.clear();
 }
 
-QDataStream &operator >>(QDataStream &stream, KanjiDB &db)
+// an index of posting lists, as its size then each key and its ids
+template <class Key>
+static void writePostingIndex(QDataStream &stream, const QMap<Key, PostingList> &index)
 {
-    db.clear();
-    //all kanjis maps contain only kanji pointers,
-    //and each kanji exists only once, but has a pointer
-    //to it stored in different maps.
-    //kanjis are stored along with the value of their pointer
-    //we use this value to rebuild the maps efficiently:
-    //create a kanji only once when building the unicode map,
-    //then match old references to new references
-    //to build the other maps
-    QMap<quintptr, Kanji *> memMap;
-    unsigned int size;
-    stream >> size;
-    for(unsigned int i = 0; i < size; ++i)
-    {
-        Unicode ucs;
-        Kanji *k = new Kanji;
-        quintptr p;
-        stream >> ucs >> *k >> p;
-        //used to match old reference to new references
-        memMap.insert(p, k);
-        //build unicode map (contains reference to all kanjis)
-        db.kanjis.insert(ucs, k);
-    }
-    stream >> size;
-    for(unsigned int i = 0; i < size; ++i)
-    {
-        QString jis208;
-        quintptr p;
-        stream >> jis208 >> p;
-        //build other map getting new reference from old reference
-        db.kanjisJIS208.insert(jis208, memMap.value(p));
-    }
-    stream >> size;
-    for(unsigned int i = 0; i < size; ++i)
-    {
-        QString jis212;
-        quintptr p;
-        stream >> jis212 >> p;
-        db.kanjisJIS212.insert(jis212, memMap.value(p));
-    }
-    stream >> size;
-    for(unsigned int i = 0; i < size; ++i)
-    {
-        QString jis213;
-        quintptr p;
-        stream >> jis213 >> p;
-        db.kanjisJIS213.insert(jis213, memMap.value(p));
-    }
+    stream << (quint32) index.size();
+    typename QMap<Key, PostingList>::const_iterator i = index.constBegin();
+    for(; i != index.constEnd(); ++i)
+        stream << i.key() << i.value();
+}
+
+template <class Key>
+static void readPostingIndex(QDataStream &stream, QMap<Key, PostingList> &index)
+{
+    quint32 size;
     stream >> size;
-    for(unsigned int i = 0; i < size; ++i)
+    for(quint32 i = 0; i < size; ++i)
     {
-        unsigned int key, subsize;
-        stream >> key >> subsize;
-        QSet<Kanji *> *set = new QSet<Kanji *>;
-        for(unsigned int j = 0; j < subsize; ++j)
-        {
-            quintptr p;
-            stream >> p;
-            set->insert(memMap.value(p));
-        }
-        db.kanjisByStroke.insert(key, set);
+        Key key;
+        PostingList ids;
+        stream >> key >> ids;
+        index.insert(key, ids);
     }
-    stream >> size;
-    for(unsigned int i = 0; i < size; ++i)
-    {
-        unsigned int key, subsize;
-        stream >> key >> subsize;
-        QSet<Kanji *> *set = new QSet<Kanji *>;
-        for(unsigned int j = 0; j < subsize; ++j)
-        {
-            quintptr p;
-            stream >> p;
-            set->insert(memMap.value(p));
-        }
-        db.kanjisByRadical.insert(key, set);
+}
+
+static void writeCodeIndex(QDataStream &stream, const QMap<QString, KanjiId> &index)
+{
+    stream << (quint32) index.size();
+    QMapIterator<QString, KanjiId> i(index);
+    while (i.hasNext()) {
+        i.next();
+        stream << i.key() << i.value();
     }
+}
+
+// ascending and without duplicates, for ids not added in order
+static void sortPostings(PostingList &ids)
+{
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+}
+
+static void readCodeIndex(QDataStream &stream, QMap<QString, KanjiId> &index)
+{
+    quint32 size;
     stream >> size;
-    for(unsigned int i = 0; i < size; ++i)
+    for(quint32 i = 0; i < size; ++i)
     {
-        unsigned int key, subsize;
-        stream >> key >> subsize;
-        QSet<Kanji *> *set = new QSet<Kanji *>;
-        for(unsigned int j = 0; j < subsize; ++j)
-        {
-            quintptr p;
-            stream >> p;
-            set->insert(memMap.value(p));
-        }
-        db.kanjisByGrade.insert(key, set);
+        QString code;
+        KanjiId id;
+        stream >> code >> id;
+        index.insert(code, id);
     }
-    stream >> size;
-    for(unsigned int i = 0; i < size; ++i)
+}
+
+// one part of every kanji, as its byte length then the parts in id order
+static void writeSection(QDataStream &stream, const QVector<Kanji *> &kanjis, void (Kanji::*write)(QDataStream &) const)
+{
+    QByteArray section;
+    QDataStream out(&section, QIODevice::WriteOnly);
+    out.setVersion(stream.version());
+    foreach(const Kanji *k, kanjis)
+        (k->*write)(out);
+    stream << (quint32) section.size();
+    stream.writeRawData(section.constData(), section.size());
+}
+
+// a section left out by the load profile is skipped without being decoded
+static void readSection(QDataStream &stream, const QVector<Kanji *> &kanjis, void (Kanji::*read)(QDataStream &), bool skip)
+{
+    quint32 length;
+    stream >> length;
+    if(skip)
+        stream.skipRawData(length);
+    else
     {
-        unsigned int key, subsize;
-        stream >> key >> subsize;
-        QSet<Kanji *> *set = new QSet<Kanji *>;
-        for(unsigned int j = 0; j < subsize; ++j)
-        {
-            quintptr p;
-            stream >> p;
-            set->insert(memMap.value(p));
-        }
-        db.kanjisByJLPT.insert(key, set);
+        foreach(Kanji *k, kanjis)
+            (k->*read)(stream);
     }
+}
+
+QDataStream &operator >>(QDataStream &stream, KanjiDB &db)
+{
+    db.clear();
+    //kanjis are stored in id order, every other map refers to them by id
+    unsigned int size;
     stream >> size;
+    db.kanjiRecords = new Kanji[size];
+    db.recordCount = size;
+    db.kanjisById.reserve(size);
     for(unsigned int i = 0; i < size; ++i)
     {
-        unsigned int key, subsize;
-        stream >> key >> subsize;
-        QSet<Kanji *> *set = new QSet<Kanji *>;
-        for(unsigned int j = 0; j < subsize; ++j)
-        {
-            quintptr p;
-            stream >> p;
-            set->insert(memMap.value(p));
-        }
-        db.kanjisByComponent.insert(key, set);
+        Kanji *k = &db.kanjiRecords[i];
+        k->readAttributes(stream);
+        k->setId(i);
+        db.kanjisById.append(k);
+        db.kanjis.insert(k->getUnicode(), k);
     }
+    readSection(stream, db.kanjisById, &Kanji::readCodes, db.loadProfile < KanjiDB::fullProfile);
+    readSection(stream, db.kanjisById, &Kanji::readReadings, db.loadProfile < KanjiDB::readingsProfile);
+    readSection(stream, db.kanjisById, &Kanji::readMeanings, db.loadProfile < KanjiDB::fullProfile);
+    readCodeIndex(stream, db.kanjisJIS208);
+    readCodeIndex(stream, db.kanjisJIS212);
+    readCodeIndex(stream, db.kanjisJIS213);
+    readPostingIndex(stream, db.kanjisByStroke);
+    readPostingIndex(stream, db.kanjisByRadical);
+    readPostingIndex(stream, db.kanjisByGrade);
+    readPostingIndex(stream, db.kanjisByJLPT);
+    readPostingIndex(stream, db.kanjisByComponent);
     stream >> size;
     for(unsigned int i = 0; i < size; ++i)
     {
@@ -246,82 +319,59 @@ QDataStream &operator >>(QDataStream &stream, KanjiDB &db)
     }
     stream >> (quint32&) db.minStrokes;
     stream >> (quint32&) db.maxStrokes;
+    //variant clusters, as their size followed by their members
+    stream >> size;
+    db.variantClusterIds.fill(KanjiDB::noCluster, db.kanjisById.size());
+    db.variantClusterOffsets.reserve(size + 1);
+    db.variantClusterOffsets.append(0);
+    for(unsigned int i = 0; i < size; ++i)
+    {
+        unsigned int subsize;
+        stream >> subsize;
+        for(unsigned int j = 0; j < subsize; ++j)
+        {
+            KanjiId id;
+            stream >> id;
+            // a stale or corrupt index, readIndex fails on the status
+            if(stream.status() != QDataStream::Ok || id >= db.kanjisById.size())
+            {
+                stream.setStatus(QDataStream::ReadCorruptData);
+                return stream;
+            }
+            db.variantClusterIds[id] = i;
+            db.variantMembers.append(id);
+        }
+        db.variantClusterOffsets.append(db.variantMembers.size());
+    }
+    readPostingIndex(stream, db.kanjisByNelsonRadical);
+    readPostingIndex(stream, db.kanjisByRadicalName);
+    readPostingIndex(stream, db.kanjisBySkip);
+    readPostingIndex(stream, db.kanjisByFourCorner);
+    readPostingIndex(stream, db.kanjisByDeRoo);
+    stream >> db.referenceColumns;
     return stream;
 }
 
 QDataStream &operator <<(QDataStream &stream, const KanjiDB &db)
 {
-    //maps contain only pointers so a specific streaming is required
-    //the unicode map contains reference to all the kanjis
-    //we store the kanji by reading the unicode map,
-    //and store their pointer value along.
-    //other maps stream only the reference.
-    stream << db.kanjis.size();
-    KanjiSetConstIterator i(db.kanjis);
-    while (i.hasNext()) {
-        i.next();
-        stream << i.key() << *(i.value()) << (quintptr&) i.value();
-    }
-    stream << db.kanjisJIS208.size();
-    QMapIterator<QString, Kanji *> j(db.kanjisJIS208);
-    while (j.hasNext()) {
-        j.next();
-        stream << j.key() << (quintptr&) j.value();
-    }
-    stream << db.kanjisJIS212.size();
-    j = QMapIterator<QString, Kanji *>(db.kanjisJIS212);
-    while (j.hasNext()) {
-        j.next();
-        stream << j.key() << (quintptr&) j.value();
-    }
-    stream << db.kanjisJIS213.size();
-    j = QMapIterator<QString, Kanji *>(db.kanjisJIS213);
-    while (j.hasNext()) {
-        j.next();
-        stream << j.key() << (quintptr&) j.value();
-    }
-    stream << db.kanjisByStroke.size();
-    QMapIterator<unsigned int, QSet<Kanji *> *> k(db.kanjisByStroke);
-    while (k.hasNext()) {
-        k.next();
-        stream << k.key() << k.value()->size();
-        foreach(Kanji *kj, *(k.value()))
-            stream << (quintptr&) kj;
-    }
-    stream << db.kanjisByRadical.size();
-    k = QMapIterator<unsigned int, QSet<Kanji *> *>(db.kanjisByRadical);
-    while (k.hasNext()) {
-        k.next();
-        stream << k.key() << k.value()->size();
-        foreach(Kanji *kj, *(k.value()))
-            stream << (quintptr&) kj;
-    }
-    stream << db.kanjisByGrade.size();
-    k = QMapIterator<unsigned int, QSet<Kanji *> *>(db.kanjisByGrade);
-    while (k.hasNext()) {
-        k.next();
-        stream << k.key() << k.value()->size();
-        foreach(Kanji *kj, *(k.value()))
-            stream << (quintptr&) kj;
-    }
-    stream << db.kanjisByJLPT.size();
-    k = QMapIterator<unsigned int, QSet<Kanji *> *>(db.kanjisByJLPT);
-    while (k.hasNext()) {
-        k.next();
-        stream << k.key() << k.value()->size();
-        foreach(Kanji *kj, *(k.value()))
-            stream << (quintptr&) kj;
-    }
-    stream << db.kanjisByComponent.size();
-    k = QMapIterator<Unicode, QSet<Kanji *> *>(db.kanjisByComponent);
-    while (k.hasNext()) {
-        k.next();
-        stream << k.key() << k.value()->size();
-        foreach(Kanji *kj, *(k.value()))
-            stream << (quintptr&) kj;
-    }
+    //kanjis are stored in id order, their position gives back their id
+    //other maps stream only the id
+    stream << db.kanjisById.size();
+    foreach(Kanji *k, db.kanjisById)
+        k->writeAttributes(stream);
+    writeSection(stream, db.kanjisById, &Kanji::writeCodes);
+    writeSection(stream, db.kanjisById, &Kanji::writeReadings);
+    writeSection(stream, db.kanjisById, &Kanji::writeMeanings);
+    writeCodeIndex(stream, db.kanjisJIS208);
+    writeCodeIndex(stream, db.kanjisJIS212);
+    writeCodeIndex(stream, db.kanjisJIS213);
+    writePostingIndex(stream, db.kanjisByStroke);
+    writePostingIndex(stream, db.kanjisByRadical);
+    writePostingIndex(stream, db.kanjisByGrade);
+    writePostingIndex(stream, db.kanjisByJLPT);
+    writePostingIndex(stream, db.kanjisByComponent);
     stream << db.components.size();
-    i = KanjiSetConstIterator(db.components);
+    KanjiSetConstIterator i(db.components);
     while (i.hasNext()) {
         i.next();
         stream << i.key() << *(i.value());
@@ -340,42 +390,28 @@ QDataStream &operator <<(QDataStream &stream, const KanjiDB &db)
     }
     stream << db.minStrokes;
     stream << db.maxStrokes;
-    return stream;
-}
-
-void KanjiDB::initRadicals()
-{
-    bool b;
-    for(unsigned int i = 0; i < Radicals::radicalsSize; ++i)
+    unsigned int clusterCount = db.variantClusterOffsets.isEmpty() ? 0 : db.variantClusterOffsets.size() - 1;
+    stream << clusterCount;
+    for(unsigned int c = 0; c < clusterCount; ++c)
     {
-        QStringList parts = Radicals::radicals[i].split(":");
-        unsigned char strokes = parts[1].toUShort(&b);
-
-        Kanji *masterRadical = new Kanji();
-        masterRadical->setClassicalRadical(i+1);
-        masterRadical->setLiteral(parts[0].at(0));
-        masterRadical->setUnicode(parts[0].at(0).unicode());
-        masterRadical->setStrokeCount(strokes);
-
-        radicalsByIndex.insert(i+1, masterRadical->getUnicode());
-        radicals.insert(masterRadical->getUnicode(), masterRadical);
-
-        foreach(QChar c, parts[0].mid(1))
-        {
-            Kanji *variantRadical = new Kanji();
-            variantRadical->setClassicalRadical(i+1);
-            variantRadical->setLiteral(c);
-            variantRadical->setUnicode(c.unicode());
-            variantRadical->setStrokeCount(strokes);
-            radicals.insert(c.unicode(), variantRadical);
-            masterRadical->addUnicodeVariant(c.unicode());
-        }
+        stream << db.variantClusterOffsets.at(c+1) - db.variantClusterOffsets.at(c);
+        for(quint32 v = db.variantClusterOffsets.at(c); v < db.variantClusterOffsets.at(c+1); ++v)
+            stream << db.variantMembers.at(v);
     }
+    writePostingIndex(stream, db.kanjisByNelsonRadical);
+    writePostingIndex(stream, db.kanjisByRadicalName);
+    writePostingIndex(stream, db.kanjisBySkip);
+    writePostingIndex(stream, db.kanjisByFourCorner);
+    writePostingIndex(stream, db.kanjisByDeRoo);
+    stream << db.referenceColumns;
+    return stream;
 }
 
 int KanjiDB::readResources(const QDir &basedir)
 {
+    TraceSpan span("readResources");
     error = QString();
+    loadPhases.clear();
     bool b_allDataRead, b_baseDataRead, b_indexSaved;
     b_allDataRead = b_baseDataRead = b_indexSaved = false;
 
@@ -521,9 +557,36 @@ bool KanjiDB::readIndex(QIODevice *device)
 //    else
     in.setVersion(QDataStream::Qt_4_0);
 
+    // the languages the index was written with, it must have all of ours
+    quint32 _languages;
+    in >> _languages;
+    if ((_languages & languages) != languages)
+    {
+        error = QString("Index file lacks some of the selected languages");
+        return false;
+    }
+
     error = QString();
     // Read the data
+    TraceSpan span("index read");
+    QElapsedTimer timer;
+    timer.start();
     in >> *this;
+    if(in.status() != QDataStream::Ok)
+    {
+        error = QString("Corrupted index file");
+        clear();
+        return false;
+    }
+    if(_languages != languages)
+    {
+        foreach(Kanji *k, kanjisById)
+            foreach(ReadingMeaningGroup *rmg, k->getReadingMeaningGroups())
+                rmg->retainLanguages(languages);
+    }
+    recordPhase("index read", timer, kanjis.size());
+    buildDerivedIndexes();
+    queryCache.invalidate();
 
     return true;
 }
@@ -549,6 +612,11 @@ bool KanjiDB::readRadK(QIODevice *device)
     unsigned char index = 0;
     bool ok;
     Unicode currentRadical = 0;
+    QMap<Unicode, PostingList>::iterator containers;
+    quint64 links = 0;
+    TraceSpan span("radk read");
+    QElapsedTimer timer;
+    timer.start();
     while(!(line = ts.readLine()).isNull())
     {
         if(!line.startsWith("#") && !line.size() == 0)
@@ -567,7 +635,7 @@ bool KanjiDB::readRadK(QIODevice *device)
                 components.insert(unicode, k_component);
                 componentIndexes.insert(index++, unicode);
                 currentRadical = unicode;
-                kanjisByComponent.insert(currentRadical, new QSet<Kanji *>);
+                containers = kanjisByComponent.insert(currentRadical, PostingList());
             } else
             {
                 if(currentRadical == 0)
@@ -581,13 +649,20 @@ bool KanjiDB::readRadK(QIODevice *device)
                     if(kanjis.contains(u))
                     {
                         Kanji *container = kanjis.value(u);
-                        kanjisByComponent.value(currentRadical)->insert(container);
+                        containers.value().append(container->getId());
                         container->addComponent(currentRadical);
+                        ++links;
                     }
                 }
             }
         }
     }
+    // radk lists kanjis by stroke count, not by id
+    for(containers = kanjisByComponent.begin(); containers != kanjisByComponent.end(); ++containers)
+        sortPostings(containers.value());
+    recordPhase("radk read", timer, links);
+    buildDerivedIndexes();
+    queryCache.invalidate();
     return true;
 }
 
@@ -597,9 +672,15 @@ bool KanjiDB::readKanjiDic(QIODevice *device)
     int errorLine;
     int errorColumn;
 
+    TraceSpan domSpan("dom parse");
+    QElapsedTimer timer;
+    timer.start();
     QDomDocument domDocument;
-    if (!domDocument.setContent(device, true, &errorStr, &errorLine,
-                                &errorColumn))
+    bool parsed = domDocument.setContent(device, true, &errorStr, &errorLine,
+                                         &errorColumn);
+    recordPhase("dom parse", timer, device->size());
+    domSpan.finish();
+    if (!parsed)
     {
         error = QString("At line %1, column %2: ").arg(errorLine).arg(errorColumn) + errorStr;
         return false;
@@ -612,16 +693,27 @@ bool KanjiDB::readKanjiDic(QIODevice *device)
         return false;
     }
 
-    // kanjidic has 1 header node and pairs of comment and character nodes
-    long count = ( root.childNodes().count() - 1 ) / 2;
-
+    quint64 count = 0;
+    TraceSpan parseSpan("character parse");
+    timer.restart();
     QDomElement child = root.firstChildElement("character");
     while (!child.isNull())
     {
+        if(kanjisById.size() == maxKanjis)
+        {
+            error = QString("More than %1 kanjis").arg(maxKanjis);
+            return false;
+        }
         ++count;
         parseCharacterElement(child);
         child = child.nextSiblingElement("character");
     }
+    recordPhase("character parse", timer, count);
+    layoutByFrequency();
+    buildRadicalNameIndex();
+    buildVariantClusters();
+    buildDerivedIndexes();
+    queryCache.invalidate();
 
     error = QString();
     return true;
@@ -636,9 +728,14 @@ bool KanjiDB::writeIndex(QIODevice *device) const
     out << (qint32)version;
 
     out.setVersion(QDataStream::Qt_4_0);
+    out << languages;
 
     // Write the data
+    TraceSpan span("index write");
+    QElapsedTimer timer;
+    timer.start();
     out << *this;
+    recordPhase("index write", timer, kanjis.size());
 
     error = QString();
     return true;
@@ -649,11 +746,212 @@ const QString KanjiDB::errorString() const
     return error;
 }
 
+void KanjiDB::recordPhase(const QString &name, const QElapsedTimer &timer, quint64 items) const
+{
+    LoadPhase phase;
+    phase.name = name;
+    phase.nsecs = timer.nsecsElapsed();
+    phase.items = items;
+    loadPhases.append(phase);
+}
+
+void KanjiDB::setLanguages(quint32 mask)
+{
+    languages = mask & ReadingMeaningGroup::allLanguages;
+}
+
+quint32 KanjiDB::getLanguages() const
+{
+    return languages;
+}
+
+void KanjiDB::setLoadProfile(LoadProfile profile)
+{
+    loadProfile = profile;
+}
+
+KanjiDB::LoadProfile KanjiDB::getLoadProfile() const
+{
+    return loadProfile;
+}
+
+void KanjiDB::setQueryStatistics(QueryStatistics *statistics)
+{
+    queryStatistics = statistics;
+}
+
+QueryStatistics *KanjiDB::getQueryStatistics() const
+{
+    return queryStatistics;
+}
+
+void KanjiDB::setQueryCacheSize(int maxEntries)
+{
+    queryCache.setMaxEntries(maxEntries);
+}
+
+const QueryCache &KanjiDB::getQueryCache() const
+{
+    return queryCache;
+}
+
+const QList<LoadPhase> &KanjiDB::getLoadPhases() const
+{
+    return loadPhases;
+}
+
+static quint64 indexMemoryUsage(const QMap<unsigned int, PostingList> &map)
+{
+    quint64 bytes = MemoryUsage::mapNodes(map);
+    foreach(const PostingList &ids, map)
+        bytes += MemoryUsage::vector(ids);
+    return bytes;
+}
+
+static quint64 indexMemoryUsage(const QMap<QString, PostingList> &map)
+{
+    quint64 bytes = MemoryUsage::mapNodes(map);
+    QMapIterator<QString, PostingList> i(map);
+    while(i.hasNext())
+    {
+        i.next();
+        bytes += MemoryUsage::string(i.key()) + MemoryUsage::vector(i.value());
+    }
+    return bytes;
+}
+
+static quint64 indexMemoryUsage(const QMap<QString, KanjiId> &map)
+{
+    quint64 bytes = MemoryUsage::mapNodes(map);
+    foreach(const QString &key, map.keys())
+        bytes += MemoryUsage::string(key);
+    return bytes;
+}
+
+QMap<QString, quint64> KanjiDB::memoryUsage() const
+{
+    QMap<QString, quint64> usage;
+
+    quint64 kanjiBytes = MemoryUsage::mapNodes(kanjis) + MemoryUsage::vector(kanjisById);
+    quint64 rmgBytes = 0;
+    foreach(Kanji *k, kanjis)
+    {
+        kanjiBytes += k->memoryUsage();
+        foreach(ReadingMeaningGroup *rmg, k->getReadingMeaningGroups())
+            rmgBytes += rmg->memoryUsage();
+    }
+    usage.insert("kanjis", kanjiBytes);
+    usage.insert("readingMeaningGroups", rmgBytes);
+
+    usage.insert("kanjisJIS208", indexMemoryUsage(kanjisJIS208));
+    usage.insert("kanjisJIS212", indexMemoryUsage(kanjisJIS212));
+    usage.insert("kanjisJIS213", indexMemoryUsage(kanjisJIS213));
+    usage.insert("kanjisByStroke", indexMemoryUsage(kanjisByStroke));
+    usage.insert("kanjisByRadical", indexMemoryUsage(kanjisByRadical));
+    usage.insert("kanjisByNelsonRadical", indexMemoryUsage(kanjisByNelsonRadical));
+    usage.insert("kanjisByRadicalName", indexMemoryUsage(kanjisByRadicalName));
+    usage.insert("kanjisByQueryCode", indexMemoryUsage(kanjisBySkip) + indexMemoryUsage(kanjisByFourCorner)
+                 + indexMemoryUsage(kanjisByDeRoo));
+    quint64 referenceBytes = MemoryUsage::mapNodes(referenceColumns);
+    QMapIterator<QString, QVector<quint16> > r(referenceColumns);
+    while(r.hasNext())
+    {
+        r.next();
+        referenceBytes += MemoryUsage::string(r.key()) + MemoryUsage::vector(r.value());
+    }
+    usage.insert("referenceColumns", referenceBytes);
+    quint64 referenceRangeBytes = MemoryUsage::mapNodes(referenceRanges);
+    foreach(const RangeIndex &range, referenceRanges)
+        referenceRangeBytes += range.memoryUsage();
+    usage.insert("kanjisByGrade", indexMemoryUsage(kanjisByGrade));
+    usage.insert("kanjisByJLPT", indexMemoryUsage(kanjisByJLPT));
+    usage.insert("kanjisByComponent", indexMemoryUsage(kanjisByComponent));
+    usage.insert("componentMasks", MemoryUsage::vector(componentMasks));
+    usage.insert("readingIndex", readingIndex.memoryUsage());
+    usage.insert("rangeIndexes", strokesRange.memoryUsage() + frequencyRange.memoryUsage()
+                 + gradeRange.memoryUsage() + jlptRange.memoryUsage() + skipRange.memoryUsage()
+                 + fourCornerRange.memoryUsage() + deRooRange.memoryUsage() + referenceRangeBytes);
+    usage.insert("variantClusters", MemoryUsage::vector(variantClusterIds)
+                 + MemoryUsage::vector(variantClusterOffsets)
+                 + MemoryUsage::vector(variantMembers));
+
+    quint64 componentBytes = MemoryUsage::mapNodes(components)
+            + MemoryUsage::mapNodes(componentIndexes)
+            + MemoryUsage::mapNodes(faultyComponents);
+    foreach(Kanji *k, components)
+        componentBytes += k->memoryUsage();
+    foreach(const QString &name, faultyComponents)
+        componentBytes += MemoryUsage::string(name);
+    usage.insert("components", componentBytes);
+
+    // shared by all the databases
+    quint64 radicalBytes = sizeof(RadicalSet) + MemoryUsage::mapNodes(radicals->radicals);
+    foreach(Kanji *k, radicals->radicals)
+        radicalBytes += k->memoryUsage();
+    usage.insert("radicals", radicalBytes);
+
+    quint64 total = 0;
+    foreach(quint64 bytes, usage)
+        total += bytes;
+    usage.insert("total", total);
+    return usage;
+}
+
+static const unsigned int skipRadix = 256;
+static const unsigned int fourCornerRadix = 10;
+
+// the ids of one kanji are added one after the other
+static void addPosting(PostingList &ids, KanjiId id)
+{
+    if(ids.isEmpty() || ids.last() != id)
+        ids.append(id);
+}
+
+// '1-4-3'
+static bool parseSkipCode(const QString &text, unsigned int &code)
+{
+    QStringList fields = text.split('-');
+    if(fields.size() != 3)
+        return false;
+    code = 0;
+    foreach(const QString &field, fields)
+    {
+        bool ok;
+        unsigned int value = field.toUInt(&ok, 10);
+        if(!ok || value >= skipRadix)
+            return false;
+        code = code * skipRadix + value;
+    }
+    return code > 0;
+}
+
+// '3413.4' as 134134, the leading 1 keeps 0000.0 from being 0, which range indexes leave out
+static bool parseFourCornerCode(const QString &text, unsigned int &code)
+{
+    QString digits = QString(text).remove('.');
+    if(digits.size() == 4)
+        digits.append('0');
+    if(digits.size() != 5)
+        return false;
+    code = 1;
+    foreach(QChar c, digits)
+    {
+        if(!c.isDigit())
+            return false;
+        code = code * fourCornerRadix + c.digitValue();
+    }
+    return true;
+}
+
 void KanjiDB::parseCharacterElement(const QDomElement &element){
     QString title = element.firstChildElement("literal").text();
     Q_ASSERT(title.length() > 0);
     Kanji *k = new Kanji();
     k->setLiteral(title);
+    // ids follow the file order, so the posting lists fill up sorted
+    k->setId(kanjisById.size());
+    kanjisById.append(k);
+    KanjiId id = k->getId();
 
     bool ok;
 
@@ -671,19 +969,19 @@ void KanjiDB::parseCharacterElement(const QDomElement &element){
         {
             QString text = child.text();
             k->setJis208(text);
-            kanjisJIS208[text] = k;
+            kanjisJIS208[text] = id;
         }
         else if(QString::compare(child.attribute("cp_type", ""), "jis212") == 0)
         {
             QString text = child.text();
             k->setJis212(text);
-            kanjisJIS212[text] = k;
+            kanjisJIS212[text] = id;
         }
         else if(QString::compare(child.attribute("cp_type", ""), "jis213") == 0)
         {
             QString text = child.text();
             k->setJis213(text);
-            kanjisJIS213[text] = k;
+            kanjisJIS213[text] = id;
         }
         child = child.nextSiblingElement("cp_value");
     }
@@ -696,18 +994,16 @@ void KanjiDB::parseCharacterElement(const QDomElement &element){
         {
             unsigned char cRad = child.text().toUInt(&ok, 10);
             k->setClassicalRadical(cRad);
-            QSet<Kanji *> *set = kanjisByRadical.value(cRad);
-            if(set == 0)
-            {
-                set = new QSet<Kanji *>();
-                kanjisByRadical[cRad] = set;
-            }
-            set->insert(k);
+            kanjisByRadical[cRad].append(id);
         }
         else if(QString::compare(child.attribute("rad_type", ""), "nelson_c") == 0)
             k->setNelsonRadical(child.text().toUInt(&ok, 10));
         child = child.nextSiblingElement("rad_value");
     }
+    // nelson_c is only given where Nelson departs from the classical radical
+    unsigned char nRad = k->getNelsonRadical() ? k->getNelsonRadical() : k->getClassicalRadical();
+    if(nRad > 0)
+        kanjisByNelsonRadical[nRad].append(id);
 
     //parsing misc element of character
     QDomElement misc = element.firstChildElement("misc");
@@ -717,13 +1013,7 @@ void KanjiDB::parseCharacterElement(const QDomElement &element){
     {
         unsigned int grade = child.text().toUInt(&ok, 10);
         k->setGrade(grade);
-        QSet<Kanji *> *set = kanjisByGrade.value(grade);
-        if(set == 0)
-        {
-            set = new QSet<Kanji *>();
-            kanjisByGrade[grade] = set;
-        }
-        set->insert(k);
+        kanjisByGrade[grade].append(id);
     }
 
     child = misc.firstChildElement("variant");
@@ -756,32 +1046,61 @@ void KanjiDB::parseCharacterElement(const QDomElement &element){
     {
         unsigned int jlpt = child.text().toUInt(&ok, 10);
         k->setJLPT(jlpt);
-        QSet<Kanji *> *set = kanjisByJLPT.value(jlpt);
-        if(set == 0)
-        {
-            set = new QSet<Kanji *>();
-            kanjisByJLPT[jlpt] = set;
-        }
-        set->insert(k);
+        kanjisByJLPT[jlpt].append(id);
     }
 
     unsigned int strokeCount = misc.firstChildElement("stroke_count").text().toUInt(&ok, 10);
 
     k->setStrokeCount(strokeCount);
-    QSet<Kanji *> *set = kanjisByStroke.value(strokeCount);
-    if(set == 0)
+    if(!kanjisByStroke.contains(strokeCount))
     {
-        set = new QSet<Kanji *>();
-        kanjisByStroke[strokeCount] = set;
         if(strokeCount < minStrokes)
             minStrokes = strokeCount;
         else if(strokeCount > maxStrokes)
             maxStrokes = strokeCount;
     }
-    set->insert(k);
+    kanjisByStroke[strokeCount].append(id);
 
     // end of misc parsing
 
+    // query codes, a kanji may have a few misclassified SKIP codes besides its own
+    QDomElement queryCode = element.firstChildElement("query_code");
+    child = queryCode.firstChildElement("q_code");
+    while (!child.isNull())
+    {
+        QString type = child.attribute("qc_type", "");
+        unsigned int code;
+        if(QString::compare(type, "skip") == 0 && parseSkipCode(child.text(), code))
+            addPosting(kanjisBySkip[code], id);
+        else if(QString::compare(type, "four_corner") == 0 && parseFourCornerCode(child.text(), code))
+            addPosting(kanjisByFourCorner[code], id);
+        else if(QString::compare(type, "deroo") == 0)
+        {
+            code = child.text().toUInt(&ok, 10);
+            if(ok && code > 0)
+                addPosting(kanjisByDeRoo[code], id);
+        }
+        child = child.nextSiblingElement("q_code");
+    }
+
+    // dictionary numbers, the first one of a dictionary is kept
+    QDomElement dicNumber = element.firstChildElement("dic_number");
+    child = dicNumber.firstChildElement("dic_ref");
+    while (!child.isNull())
+    {
+        // some numbers are not integers ('3.13' of busy_people), they are left out
+        unsigned int number = child.text().toUInt(&ok, 10);
+        if(ok && number > 0 && number <= 0xFFFF)
+        {
+            QVector<quint16> &column = referenceColumns[child.attribute("dr_type", "")];
+            if(column.size() <= id)
+                column.insert(column.end(), id + 1 - column.size(), 0);
+            if(column.at(id) == 0)
+                column[id] = number;
+        }
+        child = child.nextSiblingElement("dic_ref");
+    }
+
     // parsing reading_meaning element of character
     QDomElement reamea = element.firstChildElement("reading_meaning");
     if(reamea.isNull())
@@ -802,10 +1121,10 @@ void KanjiDB::parseCharacterElement(const QDomElement &element){
         child = rmgroupElement.firstChildElement("meaning");
         while (!child.isNull())
         {
-            if(!child.hasAttribute("m_lang") || QString::compare(child.attribute("m_lang", ""), "en") == 0)
-                rmGroup->addEnglishMeaning(child.text());
-            else if(QString::compare(child.attribute("m_lang", ""), "fr") == 0)
-                rmGroup->addFrenchMeaning(child.text());
+            // the languages not selected are not even stored
+            int language = ReadingMeaningGroup::languageOf(child.attribute("m_lang", "en"));
+            if(language != -1 && (languages & (1 << language)))
+                rmGroup->addMeaning((ReadingMeaningGroup::Language) language, child.text());
             child = child.nextSiblingElement("meaning");
         }
         k->addReadingMeaningGroup(rmGroup);
@@ -820,200 +1139,713 @@ void KanjiDB::parseCharacterElement(const QDomElement &element){
     }
 }
 
-void KanjiDB::search(const QString &s, KanjiSet &set) const
+// unites or intersects the results of one key group with the results so far
+static void combineKeyGroup(const KanjiIdSet &groupSet, KanjiIdSet &set, bool unite)
 {
-    unsigned int size = s.size();
-    if(size < 1)
-        set.clear();
+    // implicitly shared, the first group of a query costs nothing
+    if(unite)
+        set.unite(groupSet);
     else
+        set.intersect(groupSet);
+}
+
+void KanjiDB::search(const QString &s, KanjiSet &set) const
+{
+    // literal queries key each kanji by its position in the query
+    if(!s.isEmpty() && !isKeywordQuery(s))
     {
-        // attempt to read each character and look it up
-        if(!searchRegexp.exactMatch(s))
-            for(int i = 0; i < s.length(); ++i)
-                searchByUnicode(s[i].unicode(), set, true, i);
-        else
-        {
-            // here the request is parsed
-            // we try to match keyword and process the request one keyword group at a time
-            // ie: 'strokes=1,jlpt=4' is cut as 'strokes=1,' and 'jlpt=4'
-            // first all kanjis with 1 stroke will be stored in the result set
-            // ',' indicates the next set of result must be united to the previous one
-            // so all the kanji of the jlpt will be united to the result set
-
-            // unite reads the end of the current keywordgroup but indicates what to do with the next keyword group
-            // previousUnite tells whether to unite or intersect current keygroup results with the global result set
-            bool unite;
-            bool previousUnite = true;
-            QString copy = s;
-            while(!copy.isEmpty())
-            {
-                if(copy.startsWith(ucsKey))
-                {
-                    QString ucsValue = parseKey(copy, ucsKey, unite);
-                    bool ok;
-                    Unicode ucs = ucsValue.toUInt(&ok, 16);
-                    if(ok)
-                        searchByUnicode(ucs, set, previousUnite, ucs);
-                    else if(!previousUnite)
-                        set.clear();
-                } else if(copy.startsWith(jis208Key))
-                {
-                    searchByStringIndex(parseKey(copy, jis208Key, unite), kanjisJIS208, set, previousUnite);
-                } else if(copy.startsWith(jis212Key))
-                {
-                    searchByStringIndex(parseKey(copy, jis212Key, unite), kanjisJIS212, set, previousUnite);
-                } else if(copy.startsWith(jis213Key))
-                {
-                    searchByStringIndex(parseKey(copy, jis213Key, unite), kanjisJIS213, set, previousUnite);
-                } else if(copy.startsWith(jlptKey))
-                {
-                    bool ok;
-                    unsigned int jlpt = parseKey(copy, jlptKey, unite).toUInt(&ok, 10);
-                    if(ok)
-                        searchByIntIndex(jlpt, kanjisByJLPT, set, previousUnite);
-                    else if(!previousUnite)
-                        set.clear();
-                } else if(copy.startsWith(gradeKey))
-                {
-                    bool ok;
-                    unsigned int grade = parseKey(copy, gradeKey, unite).toUInt(&ok, 10);
-                    if(ok)
-                        searchByIntIndex(grade, kanjisByGrade, set, previousUnite);
-                    else if(!previousUnite)
-                        set.clear();
-                } else if(copy.startsWith(radicalKey))
-                {
-                    bool ok;
-                    QString key = parseKey(copy, radicalKey, unite);
-                    unsigned int radical = key.toUInt(&ok, 10);
-                    if(ok)
-                        searchByIntIndex(radical, kanjisByRadical, set, previousUnite);
-                    else if(key.size() == 1)
-                        if(radicals.contains(key[0].unicode()))
-                            searchByIntIndex(radicals.value(key[0].unicode())->getClassicalRadical(), kanjisByRadical, set, previousUnite);
-                        else
-                            set.clear();
-                    else if(!previousUnite)
-                        set.clear();
-                } else if(copy.startsWith(componentKey))
-                {
-                    QString key = parseKey(copy, componentKey, unite);
-                    if(key.size() == 1)
-                        searchByIntIndex(key.at(0).unicode(), kanjisByComponent, set, previousUnite);
-                    else if(!previousUnite)
-                        set.clear();
-                } else if(copy.startsWith(strokesKey))
-                {
-                    bool ok;
-                    unsigned int strokes = parseKey(copy, strokesKey, unite).toUInt(&ok, 10);
-                    if(ok)
-                        searchByIntIndex(strokes, kanjisByStroke, set, previousUnite);
-                    else if(!previousUnite)
-                        set.clear();
-                } else if(copy.startsWith(strokesLessKey))
-                {
-                    bool ok;
-                    unsigned int strokes = parseKey(copy, strokesLessKey, unite).toUInt(&ok, 10);
-                    if(ok)
-                    {
-                        KanjiSet tmpSet;
-                        for(unsigned int i = minStrokes; i < strokes; ++i)
-                            searchByIntIndex(i, kanjisByStroke, tmpSet, true);
-                        foreach(Kanji *k, tmpSet)
-                            if(previousUnite)
-                                set.insert(k->getUnicode(), k);
-                            else
-                                if(!set.contains(k->getUnicode()))
-                                    set.remove(k->getUnicode());
-                    } else if(!previousUnite)
-                        set.clear();
-                } else if(copy.startsWith(strokesMoreKey))
-                {
-                    bool ok;
-                    unsigned int strokes = parseKey(copy, strokesMoreKey, unite).toUInt(&ok, 10);
-                    if(ok)
-                    {
-                        KanjiSet tmpSet;
-                        for(unsigned int i = maxStrokes; i > strokes ; --i)
-                            searchByIntIndex(i, kanjisByStroke, tmpSet, true);
-                        foreach(Kanji *k, tmpSet)
-                            if(previousUnite)
-                                set.insert(k->getUnicode(), k);
-                            else
-                                if(!set.contains(k->getUnicode()))
-                                    set.remove(k->getUnicode());
-                    } else if(!previousUnite)
-                        set.clear();
-                } else
-                {
-                    // only kanji supported yet -> multiple characters & no keywords = no result
-                    set.clear();
-                    copy = QString();
-                }
-                previousUnite = unite;
-            }
-        }
-        // keywords (ucs=, jis208=, jis212=, jis213=, jlpt=, strokes[<>=], grade=, ',', ' ')
+        searchLiteral(s, set);
+        return;
     }
-    return;
+    // the kanjis already in the set take part in the query
+    QVector<KanjiId> held;
+    foreach(Kanji *k, set)
+        if(owns(k))
+            held << k->getId();
+    KanjiIdSet ids = KanjiIdSet::fromIds(held);
+    search(s, ids);
+    KanjiSetIterator iter(set);
+    while(iter.hasNext())
+    {
+        iter.next();
+        if(!owns(iter.value()) || !ids.contains(iter.value()->getId()))
+            iter.remove();
+    }
+    toKanjiSet(ids, set);
 }
 
-QString KanjiDB::parseKey(QString &parsedString, const QString &key, bool &unite) const
+void KanjiDB::search(const QString &s, KanjiIdSet &set) const
 {
-    QString result;
-    parsedString = parsedString.mid(key.size(), -1);
-    int index = parsedString.indexOf(QRegExp(seps));
-    // no more ' ' or ',' means it the last keygroup, unite is meaningless at this point
-    if(index == -1)
+    // measures are only taken when statistics are set
+    QueryStatistics *statistics = queryStatistics;
+    QElapsedTimer queryTimer, keyTimer;
+    if(statistics)
+        queryTimer.start();
+    TraceSpan span("search");
+    span.setDetail(s);
+
+    // only whole results are cached, not the union with what the set already holds
+    QString cacheKey;
+    quint64 generation = 0;
+    bool cacheable = set.isEmpty() && queryCache.getMaxEntries() > 0;
+    if(cacheable)
     {
-        result = parsedString;
-        parsedString = QString();
-    } else
+        cacheKey = QueryCache::normalize(s);
+        // taken before evaluating, a reload meanwhile makes the result stale
+        generation = queryCache.getGeneration();
+        if(queryCache.find(cacheKey, set))
+        {
+            if(statistics)
+                statistics->recordQuery(s, queryTimer.nsecsElapsed(), set.size());
+            return;
+        }
+    }
+
+    QList<SearchKeyGroup> groups;
+    if(s.size() < 1)
+        set.clear();
+    else if(!parseQuery(s, groups))
     {
-        unite = unionSeps.contains(parsedString.at(index));
-        result = parsedString.mid(0, index);
-        parsedString = parsedString.mid(index+1, -1);
+        // attempt to read each character and look it up
+        if(statistics)
+            keyTimer.start();
+        QVector<KanjiId> found;
+        for(int i = 0; i < s.length(); ++i)
+        {
+            const Kanji *k = kanjis.value(Kanji::codePointAt(s, i));
+            if(k)
+                found << k->getId();
+        }
+        set.unite(KanjiIdSet::fromIds(found));
+        if(statistics)
+            statistics->recordKeyGroup(QueryStatistics::literalKeyType, keyTimer.nsecsElapsed(), set.size());
     }
-    return result;
+    else
+    {
+        // previousUnite tells whether to unite or intersect current keygroup results with the global result set
+        bool previousUnite = true;
+        foreach(const SearchKeyGroup &group, groups)
+        {
+            if(group.key == 0)
+            {
+                // only kanji supported yet -> multiple characters & no keywords = no result
+                set.clear();
+                break;
+            }
+            TraceSpan keySpan("key group");
+            keySpan.setDetail(*group.key);
+            if(statistics)
+                keyTimer.start();
+            evaluateKeyGroup(group, set, previousUnite);
+            if(statistics)
+                statistics->recordKeyGroup(*group.key, keyTimer.nsecsElapsed(), set.size());
+            previousUnite = group.unite;
+        }
+    }
+    if(cacheable)
+        queryCache.insert(cacheKey, set, generation);
+    if(statistics)
+        statistics->recordQuery(s, queryTimer.nsecsElapsed(), set.size());
 }
 
-void KanjiDB::searchByIntIndex(unsigned int index, const QMap<unsigned int, QSet<Kanji *> *> &searchedMap, KanjiSet &setToFill, bool unite) const
+void KanjiDB::searchLiteral(const QString &s, KanjiSet &set) const
 {
-    if(index > 0 && searchedMap.contains(index))
+    QueryStatistics *statistics = queryStatistics;
+    QElapsedTimer queryTimer;
+    if(statistics)
+        queryTimer.start();
+    TraceSpan span("search");
+    span.setDetail(s);
+    for(int i = 0; i < s.length(); ++i)
     {
-        if(unite)
-            foreach(Kanji *k, *searchedMap.value(index))
-                setToFill.insert(k->getUnicode(), k);
-        else
+        int position = i;
+        searchByUnicode(Kanji::codePointAt(s, i), set, true, position);
+    }
+    if(statistics)
+    {
+        statistics->recordKeyGroup(QueryStatistics::literalKeyType, queryTimer.nsecsElapsed(), set.size());
+        statistics->recordQuery(s, queryTimer.nsecsElapsed(), set.size());
+    }
+}
+
+bool KanjiDB::isKeywordQuery(const QString &s) const
+{
+    // QRegExp keeps its match state, a copy is needed to match from several threads
+    QRegExp regexp(searchRegexp);
+    return regexp.exactMatch(s);
+}
+
+void KanjiDB::toKanjiSet(const KanjiIdSet &ids, KanjiSet &set) const
+{
+    foreach(KanjiId id, ids)
+    {
+        Kanji *k = kanjisById.at(id);
+        set.insert(k->getUnicode(), k);
+    }
+}
+
+bool KanjiDB::parseQuery(const QString &s, QList<SearchKeyGroup> &groups) const
+{
+    if(!isKeywordQuery(s))
+        return false;
+
+    // here the request is parsed
+    // we try to match keyword and cut the request one keyword group at a time
+    // ie: 'strokes=1,jlpt=4' is cut as 'strokes=1,' and 'jlpt=4'
+    // first all kanjis with 1 stroke will be stored in the result set
+    // ',' indicates the next set of result must be united to the previous one
+    // so all the kanji of the jlpt will be united to the result set
+
+    // unite reads the end of the current keywordgroup but indicates what to do with the next keyword group
+    QString copy = s;
+    while(!copy.isEmpty())
+    {
+        SearchKeyGroup group;
+        group.key = 0;
+        group.unite = true;
+        for(int i = 0; i < keyCount && group.key == 0; ++i)
+            if(copy.startsWith(allKeys[i]))
+                group.key = &allKeys[i];
+        if(group.key == 0)
         {
-            KanjiSetIterator iter(setToFill);
-            while(iter.hasNext())
+            groups.append(group);
+            break;
+        }
+        group.value = parseKey(copy, *group.key, group.unite);
+        groups.append(group);
+    }
+    // keywords (ucs=, jis208=, jis212=, jis213=, jlpt=, strokes[<>=], grade=, freq=, nelson=, radname=, romaji=, ',', ' ')
+    return true;
+}
+
+// interval of values selected by a comparison key ('grade<=3', 'strokes~9')
+// or by an equality key with a single value or a range ('freq=100', 'strokes=8..12', 'strokes=20..')
+static bool parseRange(const QString &key, const QString &value, unsigned int &low, unsigned int &high)
+{
+    bool ok = true;
+    low = 0;
+    high = 0xFFFFFFFF;
+    if(key.endsWith("<=") || key.endsWith(">=") || key.endsWith('<') || key.endsWith('>') || key.endsWith('~'))
+    {
+        unsigned int v = value.toUInt(&ok, 10);
+        if(!ok)
+            return false;
+        if(key.endsWith("<="))
+            high = v;
+        else if(key.endsWith(">="))
+            low = v;
+        else if(key.endsWith('<'))
+        {
+            if(v == 0)
+                return false;
+            high = v - 1;
+        } else if(key.endsWith('>'))
+        {
+            if(v == 0xFFFFFFFF)
+                return false;
+            low = v + 1;
+        } else
+        {
+            low = v > KanjiDB::strokeTolerance ? v - KanjiDB::strokeTolerance : 0;
+            high = v + KanjiDB::strokeTolerance;
+        }
+        return true;
+    }
+
+    int separator = value.indexOf(KanjiDB::rangeSeparator);
+    if(separator == -1)
+    {
+        low = high = value.toUInt(&ok, 10);
+        return ok;
+    }
+    QString first = value.left(separator);
+    QString last = value.mid(separator + KanjiDB::rangeSeparator.size());
+    if(!first.isEmpty())
+        low = first.toUInt(&ok, 10);
+    if(ok && !last.isEmpty())
+        high = last.toUInt(&ok, 10);
+    return ok && (!first.isEmpty() || !last.isEmpty());
+}
+
+// values taken by one field of a query code pattern
+struct CodeField
+{
+    unsigned int low;
+    unsigned int high;
+};
+
+// a value, a range 'a..b' or '*'
+static bool parseCodeField(const QString &s, unsigned int radix, CodeField &field)
+{
+    bool ok = true;
+    field.low = 0;
+    field.high = radix - 1;
+    if(s == "*")
+        return true;
+    int separator = s.indexOf(KanjiDB::rangeSeparator);
+    if(separator == -1)
+        field.low = field.high = s.toUInt(&ok, 10);
+    else
+    {
+        QString first = s.left(separator);
+        QString last = s.mid(separator + KanjiDB::rangeSeparator.size());
+        if(!first.isEmpty())
+            field.low = first.toUInt(&ok, 10);
+        if(ok && !last.isEmpty())
+            field.high = last.toUInt(&ok, 10);
+    }
+    return ok && field.low <= field.high && field.high < radix;
+}
+
+// 'skip=1-4-*', missing trailing fields are open
+static bool parseSkipPattern(const QString &value, QList<CodeField> &fields)
+{
+    QStringList parts = value.split('-');
+    if(parts.size() > 3)
+        return false;
+    while(parts.size() < 3)
+        parts << "*";
+    foreach(const QString &part, parts)
+    {
+        CodeField field;
+        if(!parseCodeField(part, skipRadix, field))
+            return false;
+        fields << field;
+    }
+    return true;
+}
+
+// 'four=3413.x', the fifth digit is open when left out
+static bool parseFourCornerPattern(const QString &value, QList<CodeField> &fields)
+{
+    QString digits = QString(value).remove('.');
+    if(digits.size() == 4)
+        digits.append('x');
+    if(digits.size() != 5)
+        return false;
+    CodeField lead = {1, 1};
+    fields << lead;
+    foreach(QChar c, digits)
+    {
+        CodeField field = {0, fourCornerRadix - 1};
+        if(c.isDigit())
+            field.low = field.high = c.digitValue();
+        else if(c != 'x' && c != 'X' && c != '*')
+            return false;
+        fields << field;
+    }
+    return true;
+}
+
+// the kanjis whose code matches the fields from depth on, below prefix
+// open trailing fields make one slice, other fields are enumerated where codes exist
+static void findCodes(const RangeIndex &index, const QList<CodeField> &fields, unsigned int radix,
+                      int depth, unsigned int prefix, KanjiIdSet &set)
+{
+    unsigned int span = 1;
+    bool open = true;
+    for(int i = depth + 1; i < fields.size(); ++i)
+    {
+        open = open && fields.at(i).low == 0 && fields.at(i).high == radix - 1;
+        span *= radix;
+    }
+    const CodeField &field = fields.at(depth);
+    if(open)
+    {
+        index.find((prefix * radix + field.low) * span, (prefix * radix + field.high) * span + span - 1, set);
+        return;
+    }
+    for(unsigned int v = field.low; v <= field.high; ++v)
+    {
+        unsigned int code = prefix * radix + v;
+        if(index.count(code * span, code * span + span - 1) > 0)
+            findCodes(index, fields, radix, depth + 1, code, set);
+    }
+}
+
+const RangeIndex *KanjiDB::rangeIndexOf(const QString &key, const QString &value) const
+{
+    const RangeIndex *index;
+    if(key.startsWith("strokes"))
+        index = &strokesRange;
+    else if(key.startsWith("freq"))
+        return &frequencyRange;
+    else if(key.startsWith("grade"))
+        index = &gradeRange;
+    else if(key.startsWith("jlpt"))
+        index = &jlptRange;
+    else if(key.startsWith("deroo"))
+        index = &deRooRange;
+    else
+        return 0;
+    // a single value of an attribute with its own index is looked up there
+    if(key.endsWith('=') && !key.endsWith("<=") && !key.endsWith(">=") && !value.contains(rangeSeparator))
+        return 0;
+    return index;
+}
+
+void KanjiDB::evaluateKeyGroup(const SearchKeyGroup &group, KanjiIdSet &set, bool unite) const
+{
+    const QString *key = group.key;
+    const QString &value = group.value;
+    bool ok;
+    const RangeIndex *range = rangeIndexOf(*key, value);
+    if(range)
+    {
+        unsigned int low, high;
+        KanjiIdSet tmpSet;
+        if(parseRange(*key, value, low, high))
+            range->find(low, high, tmpSet);
+        combineKeyGroup(tmpSet, set, unite);
+        return;
+    }
+    if(key == &ucsKey)
+    {
+        Unicode ucs = value.toUInt(&ok, 16);
+        KanjiIdSet tmpSet;
+        const Kanji *k = ok ? kanjis.value(ucs) : 0;
+        if(k)
+            tmpSet.insert(k->getId());
+        combineKeyGroup(tmpSet, set, unite);
+    } else if(key == &jis208Key)
+    {
+        searchByStringIndex(value, kanjisJIS208, set, unite);
+    } else if(key == &jis212Key)
+    {
+        searchByStringIndex(value, kanjisJIS212, set, unite);
+    } else if(key == &jis213Key)
+    {
+        searchByStringIndex(value, kanjisJIS213, set, unite);
+    } else if(key == &jlptKey)
+    {
+        unsigned int jlpt = value.toUInt(&ok, 10);
+        if(ok)
+            searchByIntIndex(jlpt, kanjisByJLPT, set, unite);
+        else if(!unite)
+            set.clear();
+    } else if(key == &gradeKey)
+    {
+        unsigned int grade = value.toUInt(&ok, 10);
+        if(ok)
+            searchByIntIndex(grade, kanjisByGrade, set, unite);
+        else if(!unite)
+            set.clear();
+    } else if(key == &radicalKey)
+    {
+        unsigned int radical = value.toUInt(&ok, 10);
+        if(ok)
+            searchByIntIndex(radical, kanjisByRadical, set, unite);
+        else if(value.size() == 1 && Radicals::find(value[0].unicode()))
+            searchByIntIndex(Radicals::find(value[0].unicode())->radical, kanjisByRadical, set, unite);
+        else if(!unite)
+            set.clear();
+    } else if(key == &componentKey)
+    {
+        if(value.size() == 1)
+            searchByIntIndex(value.at(0).unicode(), kanjisByComponent, set, unite);
+        else if(!unite)
+            set.clear();
+    } else if(key == &strokesKey)
+    {
+        unsigned int strokes = value.toUInt(&ok, 10);
+        if(ok)
+            searchByIntIndex(strokes, kanjisByStroke, set, unite);
+        else if(!unite)
+            set.clear();
+    } else if(key == &nelsonKey)
+    {
+        unsigned int radical = value.toUInt(&ok, 10);
+        if(ok)
+            searchByIntIndex(radical, kanjisByNelsonRadical, set, unite);
+        else if(!unite)
+            set.clear();
+    } else if(key == &radicalNameKey)
+    {
+        combineKeyGroup(KanjiIdSet::fromSortedIds(kanjisByRadicalName.value(RomajiAutomaton::toHiragana(value))),
+                        set, unite);
+    } else if(key == &skipKey || key == &fourCornerKey)
+    {
+        bool skip = key == &skipKey;
+        unsigned int radix = skip ? skipRadix : fourCornerRadix;
+        QList<CodeField> fields;
+        KanjiIdSet tmpSet;
+        if(skip ? parseSkipPattern(value, fields) : parseFourCornerPattern(value, fields))
+        {
+            // a whole code is looked up directly, a pattern by slices of the sorted codes
+            unsigned int code = 0;
+            bool exact = true;
+            foreach(const CodeField &field, fields)
             {
-                iter.next();
-                if(!searchedMap.value(index)->contains(iter.value()))
-                    iter.remove();
+                exact = exact && field.low == field.high;
+                code = code * radix + field.low;
             }
+            if(exact)
+                tmpSet = KanjiIdSet::fromSortedIds((skip ? kanjisBySkip : kanjisByFourCorner).value(code));
+            else
+                findCodes(skip ? skipRange : fourCornerRange, fields, radix, 0, 0, tmpSet);
         }
-    } else if(!unite)
-        setToFill.clear();
+        combineKeyGroup(tmpSet, set, unite);
+    } else if(key == &deRooKey)
+    {
+        unsigned int code = value.toUInt(&ok, 10);
+        if(ok)
+            searchByIntIndex(code, kanjisByDeRoo, set, unite);
+        else if(!unite)
+            set.clear();
+    } else if(key == &referenceKey)
+    {
+        // 'heisig=1..500' is the dictionary then its comparison
+        KanjiIdSet tmpSet;
+        int comparison = value.indexOf(QRegExp("[<>=]"));
+        if(comparison > 0)
+        {
+            int number = comparison + 1;
+            if(number < value.size() && value.at(number) == '=')
+                ++number;
+            unsigned int low, high;
+            QMap<QString, RangeIndex>::const_iterator index = referenceRanges.constFind(value.left(comparison));
+            if(index != referenceRanges.constEnd()
+                    && parseRange(value.mid(comparison, number - comparison), value.mid(number), low, high))
+                index.value().find(low, high, tmpSet);
+        }
+        combineKeyGroup(tmpSet, set, unite);
+    } else if(key == &romajiKey)
+    {
+        // the romaji is compiled once, then matched against every reading in one walk of the reading trie
+        RomajiAutomaton automaton;
+        KanjiIdSet tmpSet;
+        if(automaton.compile(value))
+            readingIndex.match(automaton, tmpSet);
+        combineKeyGroup(tmpSet, set, unite);
+    } else
+        set.clear();
 }
 
-void KanjiDB::searchByStringIndex(const QString &indexString, const QMap<QString, Kanji *> &searchedMap, KanjiSet &setToFill, bool unite) const
+// one key group shared by the queries of a batch
+class KeyGroupTask : public WorkStealingTask
 {
-    if(indexString.size() > 0 && searchedMap.contains(indexString))
+public:
+    KeyGroupTask(const KanjiDB *d, const SearchKeyGroup &g) : db(d), group(g), nsecs(0) {}
+    void run()
     {
-        Kanji *k = searchedMap.value(indexString);
-        if(unite)
-            setToFill.insert(k->getUnicode(), k);
-        else
+        TraceSpan span("key group");
+        span.setDetail(*group.key);
+        QElapsedTimer timer;
+        timer.start();
+        db->evaluateKeyGroup(group, set, true);
+        nsecs = timer.nsecsElapsed();
+    }
+
+    const KanjiDB *db;
+    SearchKeyGroup group;
+    KanjiIdSet set;
+    qint64 nsecs;
+};
+
+// one distinct query of a batch, literal queries are simply searched
+// keyword queries combine the sets of their key groups once those are evaluated
+class BatchQueryTask : public WorkStealingTask
+{
+public:
+    BatchQueryTask(const KanjiDB *d, const QString &q) : db(d), query(q), literal(false), positions(false), cached(false), nsecs(0) {}
+    void run()
+    {
+        if(literal)
         {
-            bool contained = setToFill.contains(k->getUnicode());
-            setToFill.clear();
-            if(contained)
-                setToFill.insert(k->getUnicode(), k);
+            if(positions)
+                db->search(query, set);
+            else
+                db->search(query, result);
+            return;
         }
-    } else if(!unite)
-        setToFill.clear();
+        TraceSpan span("search");
+        span.setDetail(query);
+        QElapsedTimer timer;
+        timer.start();
+        bool previousUnite = true;
+        for(int i = 0; i < groups.size(); ++i)
+        {
+            if(keyGroups.at(i) == 0)
+            {
+                result.clear();
+                break;
+            }
+            combineKeyGroup(keyGroups.at(i)->set, result, previousUnite);
+            combinedSizes << result.size();
+            previousUnite = groups.at(i).unite;
+        }
+        nsecs = timer.nsecsElapsed();
+    }
+
+    const KanjiDB *db;
+    QString query;
+    QString cacheKey;
+    bool literal;
+    // a literal query keyed by character position, for KanjiSet batches
+    bool positions;
+    bool cached;
+    QList<SearchKeyGroup> groups;
+    // evaluated set of each group, 0 for an unknown key
+    QList<KeyGroupTask *> keyGroups;
+    // size of the result once each group is combined, as search() records it
+    QVector<int> combinedSizes;
+    KanjiIdSet result;
+    // the result as a KanjiSet, for KanjiSet batches
+    KanjiSet set;
+    qint64 nsecs;
+};
+
+void KanjiDB::searchBatch(const QStringList &queries, QList<KanjiSet> &results, WorkStealingPool *pool) const
+{
+    runBatch(queries, 0, &results, pool);
+}
+
+void KanjiDB::searchBatch(const QStringList &queries, QList<KanjiIdSet> &results, WorkStealingPool *pool) const
+{
+    runBatch(queries, &results, 0, pool);
+}
+
+void KanjiDB::runBatch(const QStringList &queries, QList<KanjiIdSet> *idResults, QList<KanjiSet> *setResults,
+                       WorkStealingPool *pool) const
+{
+    if(pool == 0)
+        pool = WorkStealingPool::globalInstance();
+    TraceSpan span("search batch");
+    span.setDetail(QString::number(queries.size()));
+
+    bool cacheable = queryCache.getMaxEntries() > 0;
+    quint64 generation = queryCache.getGeneration();
+
+    // identical queries are evaluated once, then identical key groups
+    QHash<QString, BatchQueryTask *> queryTasks;
+    QList<BatchQueryTask *> distinctQueries;
+    QHash<QString, KeyGroupTask *> keyGroupTasks;
+    QList<WorkStealingTask *> keyGroupPhase, queryPhase;
+    foreach(const QString &query, queries)
+    {
+        if(queryTasks.contains(query))
+            continue;
+        BatchQueryTask *task = new BatchQueryTask(this, query);
+        queryTasks.insert(query, task);
+        distinctQueries << task;
+        if(query.isEmpty())
+            continue;
+        if(!parseQuery(query, task->groups))
+        {
+            // searched as a whole with the key groups, caching included
+            task->literal = true;
+            task->positions = setResults != 0;
+            keyGroupPhase << task;
+            continue;
+        }
+        if(cacheable)
+        {
+            task->cacheKey = QueryCache::normalize(query);
+            if(queryCache.find(task->cacheKey, task->result))
+            {
+                task->cached = true;
+                continue;
+            }
+        }
+        foreach(const SearchKeyGroup &group, task->groups)
+        {
+            if(group.key == 0)
+            {
+                task->keyGroups << 0;
+                continue;
+            }
+            QString name = *group.key + group.value;
+            KeyGroupTask *keyGroupTask = keyGroupTasks.value(name);
+            if(keyGroupTask == 0)
+            {
+                keyGroupTask = new KeyGroupTask(this, group);
+                keyGroupTasks.insert(name, keyGroupTask);
+                keyGroupPhase << keyGroupTask;
+            }
+            task->keyGroups << keyGroupTask;
+        }
+        queryPhase << task;
+    }
+
+    pool->run(keyGroupPhase);
+    pool->run(queryPhase);
+
+    QueryStatistics *statistics = queryStatistics;
+    foreach(BatchQueryTask *task, distinctQueries)
+    {
+        if(task->literal || task->query.isEmpty())
+            continue;
+        if(cacheable && !task->cached)
+            queryCache.insert(task->cacheKey, task->result, generation);
+        if(statistics)
+        {
+            // what the query would have cost on its own, its key groups recorded as search() does
+            qint64 nsecs = task->nsecs;
+            for(int i = 0; i < task->combinedSizes.size(); ++i)
+            {
+                KeyGroupTask *keyGroupTask = task->keyGroups.at(i);
+                statistics->recordKeyGroup(*keyGroupTask->group.key, keyGroupTask->nsecs, task->combinedSizes.at(i));
+                nsecs += keyGroupTask->nsecs;
+            }
+            statistics->recordQuery(task->query, nsecs, task->result.size());
+        }
+    }
+
+    if(idResults)
+    {
+        idResults->clear();
+        foreach(const QString &query, queries)
+            *idResults << queryTasks.value(query)->result;
+    }
+    if(setResults)
+    {
+        foreach(BatchQueryTask *task, distinctQueries)
+            if(!task->positions)
+                toKanjiSet(task->result, task->set);
+        setResults->clear();
+        foreach(const QString &query, queries)
+            *setResults << queryTasks.value(query)->set;
+    }
+    qDeleteAll(distinctQueries);
+    qDeleteAll(keyGroupTasks);
+}
+
+QString KanjiDB::parseKey(QString &parsedString, const QString &key, bool &unite) const
+{
+    QString result;
+    parsedString = parsedString.mid(key.size(), -1);
+    int index = parsedString.indexOf(QRegExp(seps));
+    // no more ' ' or ',' means it the last keygroup, unite is meaningless at this point
+    if(index == -1)
+    {
+        result = parsedString;
+        parsedString = QString();
+    } else
+    {
+        unite = unionSeps.contains(parsedString.at(index));
+        result = parsedString.mid(0, index);
+        parsedString = parsedString.mid(index+1, -1);
+    }
+    return result;
+}
+
+void KanjiDB::searchByIntIndex(unsigned int index, const QMap<unsigned int, PostingList> &searchedMap, KanjiIdSet &setToFill, bool unite) const
+{
+    TraceSpan span("searchByIntIndex");
+    // posting lists are sorted, the set shares them
+    KanjiIdSet postings;
+    if(index > 0)
+        postings = KanjiIdSet::fromSortedIds(searchedMap.value(index));
+    combineKeyGroup(postings, setToFill, unite);
+}
+
+void KanjiDB::searchByStringIndex(const QString &indexString, const QMap<QString, KanjiId> &searchedMap, KanjiIdSet &setToFill, bool unite) const
+{
+    TraceSpan span("searchByStringIndex");
+    KanjiIdSet found;
+    if(indexString.size() > 0 && searchedMap.contains(indexString))
+        found.insert(searchedMap.value(indexString));
+    combineKeyGroup(found, setToFill, unite);
 }
 
 const Kanji *KanjiDB::getByUnicode(Unicode unicode) const
@@ -1021,8 +1853,39 @@ const Kanji *KanjiDB::getByUnicode(Unicode unicode) const
     return kanjis.value(unicode);
 }
 
+const Kanji *KanjiDB::getById(KanjiId id) const
+{
+    return id < kanjisById.size() ? kanjisById.at(id) : 0;
+}
+
+int KanjiDB::getKanjiCount() const
+{
+    return kanjisById.size();
+}
+
+unsigned int KanjiDB::getReference(const Kanji *k, const QString &dictionary) const
+{
+    if(!owns(k))
+        return 0;
+    QMap<QString, QVector<quint16> >::const_iterator column = referenceColumns.constFind(dictionary);
+    if(column == referenceColumns.constEnd() || k->getId() >= column.value().size())
+        return 0;
+    return column.value().at(k->getId());
+}
+
+QStringList KanjiDB::getReferenceDictionaries() const
+{
+    return referenceColumns.keys();
+}
+
+bool KanjiDB::owns(const Kanji *k) const
+{
+    return k && k->getId() < kanjisById.size() && kanjisById.at(k->getId()) == k;
+}
+
 void KanjiDB::searchByUnicode(Unicode unicode, KanjiSet &set, bool unite, int position) const
 {
+    TraceSpan span("searchByUnicode");
     if(unicode > 0 && kanjis.contains(unicode))
     {
         Kanji *k = kanjis.value(unicode);
@@ -1042,24 +1905,368 @@ void KanjiDB::searchByUnicode(Unicode unicode, KanjiSet &set, bool unite, int po
 
 void KanjiDB::findVariants(const Kanji *k, KanjiSet &variants) const
 {
-    foreach(Unicode i, k->getUnicodeVariants())
-        searchByUnicode(i, variants, true, i);
-    foreach(QString s, k->getJis208Variants())
-        searchByStringIndex(s, kanjisJIS208, variants, true);
-    foreach(QString s, k->getJis212Variants())
-        searchByStringIndex(s, kanjisJIS212, variants, true);
-    foreach(QString s, k->getJis213Variants())
-        searchByStringIndex(s, kanjisJIS213, variants, true);
+    if(k == 0)
+        return;
+    if(!owns(k))
+    {
+        // radicals and components are not clustered, their own variant codes are looked up
+        foreach(Unicode i, k->getUnicodeVariants())
+            searchByUnicode(i, variants, true, i);
+        KanjiIdSet ids;
+        foreach(QString s, k->getJis208Variants())
+            searchByStringIndex(s, kanjisJIS208, ids, true);
+        foreach(QString s, k->getJis212Variants())
+            searchByStringIndex(s, kanjisJIS212, ids, true);
+        foreach(QString s, k->getJis213Variants())
+            searchByStringIndex(s, kanjisJIS213, ids, true);
+        toKanjiSet(ids, variants);
+        return;
+    }
+    if(k->getId() >= variantClusterIds.size())
+        return;
+    quint32 cluster = variantClusterIds.at(k->getId());
+    if(cluster == noCluster)
+        return;
+    quint32 end = variantClusterOffsets.at(cluster + 1);
+    for(quint32 i = variantClusterOffsets.at(cluster); i < end; ++i)
+    {
+        Kanji *variant = kanjisById.at(variantMembers.at(i));
+        if(variant != k)
+            variants.insert(variant->getUnicode(), variant);
+    }
+}
+
+static inline int popcount(quint64 x)
+{
+#ifdef __GNUC__
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & Q_UINT64_C(0x5555555555555555));
+    x = (x & Q_UINT64_C(0x3333333333333333)) + ((x >> 2) & Q_UINT64_C(0x3333333333333333));
+    x = (x + (x >> 4)) & Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+    return (int) ((x * Q_UINT64_C(0x0101010101010101)) >> 56);
+#endif
+}
+
+static bool moreSimilar(const SimilarKanji &a, const SimilarKanji &b)
+{
+    if(a.score != b.score)
+        return a.score > b.score;
+    return a.kanji->getUnicode() < b.kanji->getUnicode();
+}
+
+QList<SimilarKanji> KanjiDB::findSimilar(const Kanji *k, int count) const
+{
+    TraceSpan span("findSimilar");
+    QList<SimilarKanji> similar;
+    if(count < 1 || !owns(k) || k->getComponents().isEmpty() || k->getId() >= componentMasks.size())
+        return similar;
+    const ComponentMask &mask = componentMasks.at(k->getId());
+
+    // candidates share at least one component
+    QVector<bool> seen(kanjisById.size(), false);
+    seen[k->getId()] = true;
+    PostingList candidates;
+    foreach(Unicode component, k->getComponents())
+        foreach(KanjiId id, kanjisByComponent.value(component))
+            if(!seen.at(id))
+            {
+                seen[id] = true;
+                candidates.append(id);
+            }
+
+    QVector<SimilarKanji> scored;
+    scored.reserve(candidates.size());
+    foreach(KanjiId id, candidates)
+    {
+        const Kanji *candidate = kanjisById.at(id);
+        const ComponentMask &other = componentMasks.at(id);
+        int shared = 0, all = 0;
+        for(int i = 0; i < 4; ++i)
+        {
+            shared += popcount(mask.bits[i] & other.bits[i]);
+            all += popcount(mask.bits[i] | other.bits[i]);
+        }
+        unsigned int strokes = k->getStrokeCount(), otherStrokes = candidate->getStrokeCount();
+        unsigned int maxStrokes = qMax(strokes, otherStrokes);
+        double strokesDistance = maxStrokes == 0 ? 0 : (double) qAbs((int) strokes - (int) otherStrokes) / maxStrokes;
+
+        SimilarKanji s;
+        s.kanji = candidate;
+        s.score = (all == 0 ? 0 : componentWeight * shared / all)
+                + (k->getClassicalRadical() == candidate->getClassicalRadical() ? radicalWeight : 0)
+                + strokesWeight * (1 - strokesDistance);
+        scored.append(s);
+    }
+
+    int top = qMin(count, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + top, scored.end(), moreSimilar);
+    for(int i = 0; i < top; ++i)
+        similar << scored.at(i);
+    return similar;
+}
+
+static unsigned int strokesOf(const Kanji *k)
+{
+    return k->getStrokeCount();
+}
+
+static unsigned int frequencyOf(const Kanji *k)
+{
+    return k->getFrequency();
+}
+
+static unsigned int gradeOf(const Kanji *k)
+{
+    return k->getGrade();
+}
+
+static unsigned int jlptOf(const Kanji *k)
+{
+    return k->getJLPT();
+}
+
+void KanjiDB::buildDerivedIndexes()
+{
+    TraceSpan span("derived indexes");
+    QElapsedTimer timer;
+    timer.start();
+
+    QHash<Unicode, int> componentBits;
+    QMapIterator<unsigned char, Unicode> c(componentIndexes);
+    while(c.hasNext())
+    {
+        c.next();
+        componentBits.insert(c.value(), c.key());
+    }
+    ComponentMask empty = {{0, 0, 0, 0}};
+    componentMasks.fill(empty, kanjisById.size());
+    quint64 masks = 0;
+    foreach(Kanji *k, kanjisById)
+    {
+        if(k->getComponents().isEmpty())
+            continue;
+        ComponentMask &mask = componentMasks[k->getId()];
+        foreach(Unicode component, k->getComponents())
+        {
+            QHash<Unicode, int>::const_iterator bit = componentBits.constFind(component);
+            if(bit != componentBits.constEnd())
+                mask.bits[bit.value() / 64] |= Q_UINT64_C(1) << (bit.value() % 64);
+        }
+        ++masks;
+    }
+
+    readingIndex.build(kanjisById);
+    strokesRange.build(kanjisById, strokesOf);
+    frequencyRange.build(kanjisById, frequencyOf);
+    gradeRange.build(kanjisById, gradeOf);
+    jlptRange.build(kanjisById, jlptOf);
+    skipRange.build(kanjisBySkip);
+    fourCornerRange.build(kanjisByFourCorner);
+    deRooRange.build(kanjisByDeRoo);
+    referenceRanges.clear();
+    QMapIterator<QString, QVector<quint16> > r(referenceColumns);
+    while(r.hasNext())
+    {
+        r.next();
+        referenceRanges[r.key()].build(r.value());
+    }
+
+    recordPhase("derived indexes", timer, masks + readingIndex.getNodeCount());
+}
+
+void KanjiDB::buildRadicalNameIndex()
+{
+    kanjisByRadicalName.clear();
+    // rad_name is given on the kanji that are radicals,
+    // a name stands for all the kanjis sharing their classical radical
+    foreach(Kanji *k, kanjisById)
+    {
+        if(k->getNamesAsRadical().isEmpty() || !kanjisByRadical.contains(k->getClassicalRadical()))
+            continue;
+        const PostingList &members = kanjisByRadical[k->getClassicalRadical()];
+        foreach(const QString &name, k->getNamesAsRadical())
+            kanjisByRadicalName[RomajiAutomaton::toHiragana(name)] += members;
+    }
+    // several radicals may share a name
+    QMap<QString, PostingList>::iterator i = kanjisByRadicalName.begin();
+    for(; i != kanjisByRadicalName.end(); ++i)
+        sortPostings(i.value());
+}
+
+// kanjidic ranks the 2500 most used kanjis, 1 being the most frequent
+static bool moreFrequent(const Kanji *a, const Kanji *b)
+{
+    if(a->getFrequency() != b->getFrequency())
+    {
+        if(a->getFrequency() == 0 || b->getFrequency() == 0)
+            return a->getFrequency() != 0;
+        return a->getFrequency() < b->getFrequency();
+    }
+    return a->getUnicode() < b->getUnicode();
+}
+
+template <class Key>
+static void remapPostings(QMap<Key, PostingList> &index, const QVector<KanjiId> &newIds)
+{
+    typename QMap<Key, PostingList>::iterator i = index.begin();
+    for(; i != index.end(); ++i)
+    {
+        PostingList &ids = i.value();
+        for(int j = 0; j < ids.size(); ++j)
+            ids[j] = newIds.at(ids.at(j));
+        std::sort(ids.begin(), ids.end());
+    }
+}
+
+static void remapCodes(QMap<QString, KanjiId> &index, const QVector<KanjiId> &newIds)
+{
+    QMap<QString, KanjiId>::iterator i = index.begin();
+    for(; i != index.end(); ++i)
+        i.value() = newIds.at(i.value());
+}
+
+// the columns of a kanjidic being read stop at the last kanji having a number
+static void remapColumn(QVector<quint16> &column, const QVector<KanjiId> &newIds)
+{
+    QVector<quint16> remapped(newIds.size(), 0);
+    for(int i = 0; i < column.size(); ++i)
+        remapped[newIds.at(i)] = column.at(i);
+    column = remapped;
+}
+
+void KanjiDB::layoutByFrequency()
+{
+    TraceSpan span("frequency layout");
+    QElapsedTimer timer;
+    timer.start();
+
+    // the few kanjis most searched and shown share a small region of memory
+    // and the low ids, results list them first
+    QVector<Kanji *> order = kanjisById;
+    std::sort(order.begin(), order.end(), moreFrequent);
+    int size = order.size();
+    QVector<KanjiId> newIds(size);
+    for(int i = 0; i < size; ++i)
+        newIds[order.at(i)->getId()] = i;
+
+    Kanji *records = new Kanji[size];
+    for(int i = 0; i < size; ++i)
+    {
+        records[i].swap(*order.at(i));
+        records[i].setId(i);
+    }
+    // the old records are empty now
+    for(int i = recordCount; i < kanjisById.size(); ++i)
+        delete kanjisById.at(i);
+    delete[] kanjiRecords;
+    kanjiRecords = records;
+    recordCount = size;
+    for(int i = 0; i < size; ++i)
+    {
+        kanjisById[i] = &records[i];
+        kanjis.insert(records[i].getUnicode(), &records[i]);
+    }
+
+    remapCodes(kanjisJIS208, newIds);
+    remapCodes(kanjisJIS212, newIds);
+    remapCodes(kanjisJIS213, newIds);
+    remapPostings(kanjisByStroke, newIds);
+    remapPostings(kanjisByRadical, newIds);
+    remapPostings(kanjisByGrade, newIds);
+    remapPostings(kanjisByJLPT, newIds);
+    remapPostings(kanjisByNelsonRadical, newIds);
+    remapPostings(kanjisByComponent, newIds);
+    remapPostings(kanjisBySkip, newIds);
+    remapPostings(kanjisByFourCorner, newIds);
+    remapPostings(kanjisByDeRoo, newIds);
+    QMap<QString, QVector<quint16> >::iterator column = referenceColumns.begin();
+    for(; column != referenceColumns.end(); ++column)
+        remapColumn(column.value(), newIds);
+    // radical names and variant clusters are built after the layout
+    recordPhase("frequency layout", timer, size);
+}
+
+static int findRoot(QVector<int> &parents, int i)
+{
+    while(parents.at(i) != i)
+    {
+        // path halving
+        parents[i] = parents.at(parents.at(i));
+        i = parents.at(i);
+    }
+    return i;
+}
+
+void KanjiDB::buildVariantClusters()
+{
+    TraceSpan span("variant clusters");
+    QElapsedTimer timer;
+    timer.start();
+    variantClusterIds.fill(noCluster, kanjisById.size());
+    variantClusterOffsets.clear();
+    variantMembers.clear();
+
+    // union find over the kanji ids
+    int size = kanjisById.size();
+    QVector<int> parents(size);
+    for(int i = 0; i < size; ++i)
+        parents[i] = i;
+
+    for(int i = 0; i < size; ++i)
+    {
+        const Kanji *k = kanjisById.at(i);
+        PostingList linked;
+        foreach(Unicode u, k->getUnicodeVariants())
+            if(kanjis.contains(u))
+                linked << kanjis.value(u)->getId();
+        foreach(const QString &s, k->getJis208Variants())
+            if(kanjisJIS208.contains(s))
+                linked << kanjisJIS208.value(s);
+        foreach(const QString &s, k->getJis212Variants())
+            if(kanjisJIS212.contains(s))
+                linked << kanjisJIS212.value(s);
+        foreach(const QString &s, k->getJis213Variants())
+            if(kanjisJIS213.contains(s))
+                linked << kanjisJIS213.value(s);
+        foreach(KanjiId variant, linked)
+        {
+            int a = findRoot(parents, i);
+            int b = findRoot(parents, variant);
+            if(a != b)
+                parents[qMax(a, b)] = qMin(a, b);
+        }
+    }
+
+    // clusters are numbered by their first kanji, members stay in id order
+    QMap<int, PostingList> clusters;
+    for(int i = 0; i < size; ++i)
+        clusters[findRoot(parents, i)] << i;
+    variantClusterOffsets.append(0);
+    foreach(const PostingList &members, clusters)
+    {
+        if(members.size() < 2)
+            continue;
+        quint32 id = variantClusterOffsets.size() - 1;
+        foreach(KanjiId member, members)
+        {
+            variantClusterIds[member] = id;
+            variantMembers.append(member);
+        }
+        variantClusterOffsets.append(variantMembers.size());
+    }
+    recordPhase("variant clusters", timer, variantMembers.size());
 }
 
 const Kanji *KanjiDB::getRadicalVariant(Unicode u) const
 {
-    return radicals.value(u);
+    const RadicalCharacter *c = Radicals::find(u);
+    return c ? radicals->byCharacter[c - Radicals::characters] : 0;
 }
 
 const Kanji *KanjiDB::getRadicalById(unsigned char c) const
 {
-    return radicals.value(radicalsByIndex.value(c));
+    return c <= Radicals::radicalsSize ? radicals->byId[c] : 0;
 }
 
 const Kanji *KanjiDB::getComponent(Unicode u) const
@@ -1077,9 +2284,19 @@ const KanjiSet &KanjiDB::getAllKanjis() const
     return kanjis;
 }
 
+const QMap<unsigned int, PostingList> &KanjiDB::getKanjisByJLPT() const
+{
+    return kanjisByJLPT;
+}
+
+const QMap<unsigned int, PostingList> &KanjiDB::getKanjisByGrade() const
+{
+    return kanjisByGrade;
+}
+
 const KanjiSet &KanjiDB::getAllRadicals() const
 {
-    return radicals;
+    return radicals->radicals;
 }
 
 const KanjiSet &KanjiDB::getAllComponents() const
@@ -3,13 +3,57 @@
 
 #include <QMap>
 #include <QSet>
+#include <QHash>
+#include <QVector>
 #include <QString>
 #include <QStringList>
 #include <QDir>
 #include <QDataStream>
 #include "kanji.h"
+#include "kanjiidset.h"
+#include "querycache.h"
+#include "readingindex.h"
+#include "rangeindex.h"
 
 class QDomElement;
+class QElapsedTimer;
+class QueryStatistics;
+class WorkStealingPool;
+struct RadicalSet;
+
+// wall time and number of items processed by one phase of a load
+struct LoadPhase
+{
+    QString name;
+    qint64 nsecs;
+    quint64 items;
+};
+
+// one result of KanjiDB::findSimilar, score is between 0 and 1
+struct SimilarKanji
+{
+    const Kanji *kanji;
+    double score;
+};
+
+// ids of kanjis in ascending order
+typedef QVector<KanjiId> PostingList;
+
+// one bit per radk component, by component index
+struct ComponentMask
+{
+    quint64 bits[4];
+};
+
+// one keyword group of a query, 'jlpt=1,' has the key jlptKey, the value "1"
+// and unites its results with those of the next group
+struct SearchKeyGroup
+{
+    // one of KanjiDB::allKeys, 0 when the group starts with no known key
+    const QString *key;
+    QString value;
+    bool unite;
+};
 
 class KanjiDB
 {
@@ -20,13 +64,40 @@ public:
     void clear();
 
     const Kanji *getByUnicode(Unicode) const;
+    // 0 if no kanji has this id
+    const Kanji *getById(KanjiId) const;
+    // ids go from 0 to getKanjiCount() excluded, a code point given twice leaves more ids than getAllKanjis()
+    int getKanjiCount() const;
     void searchByUnicode(Unicode, KanjiSet &, bool, int) const;
-    void searchByIntIndex(unsigned int, const QMap<unsigned int, QSet<Kanji *> *> &, KanjiSet &, bool) const;
-    void searchByStringIndex(const QString &, const QMap<QString, Kanji *> &, KanjiSet &, bool) const;
+    void searchByIntIndex(unsigned int, const QMap<unsigned int, PostingList> &, KanjiIdSet &, bool) const;
+    void searchByStringIndex(const QString &, const QMap<QString, KanjiId> &, KanjiIdSet &, bool) const;
+    // a literal query keys each kanji by its position in the query
     void search(const QString &, KanjiSet &) const;
+    // same search, the results as ids: no allocation per result,
+    // a literal query gives its distinct kanjis
+    void search(const QString &, KanjiIdSet &) const;
+    // searches every query on the pool, the global one by default, results come in query order
+    // identical queries and key groups shared by several queries ('jlpt=1') are evaluated once
+    void searchBatch(const QStringList &, QList<KanjiSet> &, WorkStealingPool *pool = 0) const;
+    void searchBatch(const QStringList &, QList<KanjiIdSet> &, WorkStealingPool *pool = 0) const;
+    // false for a literal query, to be looked up character by character
+    bool parseQuery(const QString &, QList<SearchKeyGroup> &) const;
+    void evaluateKeyGroup(const SearchKeyGroup &, KanjiIdSet &, bool unite) const;
+    // unites the kanjis of the ids into the set
+    void toKanjiSet(const KanjiIdSet &, KanjiSet &) const;
+    // every kanji linked to k by a chain of UCS or JIS variant references, k excluded
     void findVariants(const Kanji *k, KanjiSet &setToFill) const;
+    // the number of k in a dictionary of kanjidic's dic_number, by dr_type ("heisig"), 0 if none
+    unsigned int getReference(const Kanji *k, const QString &dictionary) const;
+    QStringList getReferenceDictionaries() const;
+    // the count kanjis looking most like k, best first
+    // only kanjis sharing at least one component with k are scored
+    QList<SimilarKanji> findSimilar(const Kanji *k, int count = 10) const;
 
     const KanjiSet &getAllKanjis() const;
+    // ids of the kanjis of each JLPT level and school grade
+    const QMap<unsigned int, PostingList> &getKanjisByJLPT() const;
+    const QMap<unsigned int, PostingList> &getKanjisByGrade() const;
     const KanjiSet &getAllRadicals() const;
     const KanjiSet &getAllComponents() const;
     const QMap<Unicode, QString> &getFaultyComponents() const;
@@ -47,6 +118,38 @@ public:
 
     const QString errorString() const;
 
+    // phases of the last readResources, or of the reads and writes done since
+    const QList<LoadPhase> &getLoadPhases() const;
+    // estimated bytes held by kanjis, each index map, components, radicals
+    // and reading meaning groups, plus their "total"
+    QMap<QString, quint64> memoryUsage() const;
+
+    // meaning languages kept by the next reads, as a mask of 1 << ReadingMeaningGroup::Language
+    // all of them by default, the others are skipped by the parse and left out of the index
+    // an index lacking a selected language is not read
+    void setLanguages(quint32 mask);
+    quint32 getLanguages() const;
+
+    // parts of the kanjis read from the index, each profile has those of the previous one
+    // attributes: literal, Unicode, radicals, components, strokes, grade, frequency and JLPT
+    // readings: on, kun and nanori readings, romaji= needs them
+    // full: meanings, JIS codes and variants of each kanji and its names as radical
+    // the search indexes are always read, a kanjidic read is always full
+    // an index written after a partial read lacks the parts skipped
+    enum LoadProfile { attributesProfile, readingsProfile, fullProfile };
+    void setLoadProfile(LoadProfile);
+    LoadProfile getLoadProfile() const;
+
+    // search() measures itself into the given statistics, 0 (the default) disables it
+    // the statistics are not owned by the database
+    void setQueryStatistics(QueryStatistics *);
+    QueryStatistics *getQueryStatistics() const;
+
+    // results of search() are cached by query, 0 disables the cache
+    // any read or clear() invalidates it
+    void setQueryCacheSize(int);
+    const QueryCache &getQueryCache() const;
+
     static const QString kanjiDBIndexFilename;
     static const QString defaultKanjiDic2Filename;
     static const QString defaultKRadFilename;
@@ -55,6 +158,8 @@ public:
 
     static const quint32 magic;
     static const quint32 version;
+    // ids are 16 bits
+    static const int maxKanjis = 0x10000;
 
     static const QString unionSeps;
     static const QString interSeps;
@@ -71,10 +176,46 @@ public:
     static const QString jis213Key;
     static const QString radicalKey;
     static const QString componentKey;
-    static const int keyCount = 11;
+    static const QString romajiKey;
+    static const QString nelsonKey;
+    // radical names are matched in hiragana, 'radname=さんずい'
+    static const QString radicalNameKey;
+    // comparisons and ranges, 'strokes=8..12', 'freq<500', 'grade<=3', 'strokes~9'
+    static const QString strokesLessEqualKey;
+    static const QString strokesMoreEqualKey;
+    static const QString strokesAroundKey;
+    static const QString frequencyKey;
+    static const QString frequencyLessKey;
+    static const QString frequencyMoreKey;
+    static const QString frequencyLessEqualKey;
+    static const QString frequencyMoreEqualKey;
+    static const QString gradeLessKey;
+    static const QString gradeMoreKey;
+    static const QString gradeLessEqualKey;
+    static const QString gradeMoreEqualKey;
+    static const QString jlptLessKey;
+    static const QString jlptMoreKey;
+    static const QString jlptLessEqualKey;
+    static const QString jlptMoreEqualKey;
+    // query codes, fields take a value, a range or '*': 'skip=1-4-3', 'skip=1-4-*', 'skip=2-1..3-*'
+    // four corner digits take a value or 'x': 'four=3413.4', 'four=3413.x', 'four=34x3'
+    static const QString skipKey;
+    static const QString fourCornerKey;
+    static const QString deRooKey;
+    // dictionary references by dr_type, a value, a range or a comparison: 'ref.heisig=1..500', 'ref.nelson_c<100'
+    static const QString referenceKey;
+    static const int keyCount = 34;
     static const QString allKeys[keyCount];
     static const QString regexp;
     static const QRegExp searchRegexp;
+    static const QString rangeSeparator;
+    // strokes~9 matches 8 to 10 strokes
+    static const unsigned int strokeTolerance = 1;
+
+    // weights of the findSimilar score, they sum to 1
+    static const double componentWeight;
+    static const double radicalWeight;
+    static const double strokesWeight;
 
     static const int allDataReadAndSaved = 0;
     static const int noDataRead = 1;
@@ -87,35 +228,100 @@ public:
             l << list[i];
         return l;
     }
+    // the keys as alternatives of a regular expression, matched literally ("ref." does not match "refX")
+    static inline QString keysRegexp(const QString *keys, unsigned int size){
+        QStringList l;
+        for(unsigned int i = 0; i < size; ++i)
+            l << QRegExp::escape(keys[i]);
+        return l.join("|");
+    }
 
 private:
-    void initRadicals();
     void parseCharacterElement(const QDomElement &);
     QString parseKey(QString &parsedString, const QString &key, bool &unite) const;
+    bool isKeywordQuery(const QString &) const;
+    void searchLiteral(const QString &, KanjiSet &) const;
+    // either result list may be 0
+    void runBatch(const QStringList &, QList<KanjiIdSet> *, QList<KanjiSet> *, WorkStealingPool *) const;
+    void recordPhase(const QString &name, const QElapsedTimer &, quint64 items) const;
+    void buildVariantClusters();
+    void buildRadicalNameIndex();
+    // indexes computed from the loaded data, never saved
+    void buildDerivedIndexes();
+    // range index answering a comparison or range key, 0 for other keys
+    const RangeIndex *rangeIndexOf(const QString &key, const QString &value) const;
+    // false for the kanjis of other databases, radicals and components
+    bool owns(const Kanji *) const;
+    // renumbers the kanjis, most frequent first, and moves them into one block
+    void layoutByFrequency();
 
     KanjiSet kanjis;
-    QMap<QString, Kanji *> kanjisJIS208;
-    QMap<QString, Kanji *> kanjisJIS212;
-    QMap<QString, Kanji *> kanjisJIS213;
-    QMap<unsigned int, QSet<Kanji *> *> kanjisByStroke;
-    QMap<unsigned int, QSet<Kanji *> *> kanjisByRadical;
-    QMap<unsigned int, QSet<Kanji *> *> kanjisByGrade;
-    QMap<unsigned int, QSet<Kanji *> *> kanjisByJLPT;
-
-    //classical radicals
-    QMap<unsigned char, Unicode> radicalsByIndex;
-    KanjiSet radicals;
+    //every kanji at the position of its id
+    QVector<Kanji *> kanjisById;
+    //kanjis with an id below recordCount, in id order: the frequent ones by rank, then the others
+    //the kanjis of a kanjidic being read are allocated one by one until its layout
+    Kanji *kanjiRecords;
+    int recordCount;
+    QMap<QString, KanjiId> kanjisJIS208;
+    QMap<QString, KanjiId> kanjisJIS212;
+    QMap<QString, KanjiId> kanjisJIS213;
+    QMap<unsigned int, PostingList> kanjisByStroke;
+    QMap<unsigned int, PostingList> kanjisByRadical;
+    QMap<unsigned int, PostingList> kanjisByGrade;
+    QMap<unsigned int, PostingList> kanjisByJLPT;
+    //classical radical where Nelson does not depart from it
+    QMap<unsigned int, PostingList> kanjisByNelsonRadical;
+    //kanjis by the name of their classical radical
+    QMap<QString, PostingList> kanjisByRadicalName;
+    //kanjis by packed query code, skip_misclass codes included
+    //SKIP is pattern << 16 | first << 8 | second, four corner is 1 then its five digits
+    QMap<unsigned int, PostingList> kanjisBySkip;
+    QMap<unsigned int, PostingList> kanjisByFourCorner;
+    QMap<unsigned int, PostingList> kanjisByDeRoo;
+    //dic_ref numbers by dr_type, one by id, 0 where the dictionary has no entry
+    QMap<QString, QVector<quint16> > referenceColumns;
+
+    //classical radicals, shared by all instances
+    const RadicalSet *radicals;
 
     //radk components
     QMap<unsigned char, Unicode> componentIndexes;
     KanjiSet components;
     QMap<Unicode, QString> faultyComponents;
 
-    QMap<Unicode, QSet<Kanji *> *> kanjisByComponent;
+    QMap<Unicode, PostingList> kanjisByComponent;
+
+    //kanjis sorted by attribute, for comparisons and ranges
+    RangeIndex strokesRange;
+    RangeIndex frequencyRange;
+    RangeIndex gradeRange;
+    RangeIndex jlptRange;
+    RangeIndex skipRange;
+    RangeIndex fourCornerRange;
+    RangeIndex deRooRange;
+    QMap<QString, RangeIndex> referenceRanges;
+
+    //on and kun readings, for romaji=
+    ReadingIndex readingIndex;
+
+    //components of each kanji as a bitset by id, for findSimilar
+    QVector<ComponentMask> componentMasks;
+
+    //variant cluster of each kanji by id, noCluster for kanjis without variant
+    //cluster c is variantMembers[variantClusterOffsets[c]] to variantMembers[variantClusterOffsets[c+1]] excluded
+    QVector<quint32> variantClusterIds;
+    QVector<quint32> variantClusterOffsets;
+    QVector<KanjiId> variantMembers;
+    static const quint32 noCluster = 0xFFFFFFFF;
 
     unsigned int minStrokes, maxStrokes;
+    quint32 languages;
+    LoadProfile loadProfile;
 
     mutable QString error;
+    mutable QList<LoadPhase> loadPhases;
+    QueryStatistics *queryStatistics;
+    mutable QueryCache queryCache;
 };
 
 #endif // KANJIDB_H
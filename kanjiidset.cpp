@@ -0,0 +1,129 @@
+#include "kanjiidset.h"
+#include "memoryusage.h"
+#include <algorithm>
+
+KanjiIdSet::KanjiIdSet()
+{
+}
+
+KanjiIdSet KanjiIdSet::fromSortedIds(const QVector<KanjiId> &sorted)
+{
+    KanjiIdSet set;
+    set.ids = sorted;
+    return set;
+}
+
+KanjiIdSet KanjiIdSet::fromIds(const QVector<KanjiId> &unsorted)
+{
+    KanjiIdSet set;
+    set.ids = unsorted;
+    std::sort(set.ids.begin(), set.ids.end());
+    set.ids.erase(std::unique(set.ids.begin(), set.ids.end()), set.ids.end());
+    return set;
+}
+
+bool KanjiIdSet::isEmpty() const
+{
+    return ids.isEmpty();
+}
+
+int KanjiIdSet::size() const
+{
+    return ids.size();
+}
+
+KanjiId KanjiIdSet::at(int i) const
+{
+    return ids.at(i);
+}
+
+bool KanjiIdSet::contains(KanjiId id) const
+{
+    return std::binary_search(ids.constBegin(), ids.constEnd(), id);
+}
+
+KanjiIdSet::const_iterator KanjiIdSet::begin() const
+{
+    return ids.constBegin();
+}
+
+KanjiIdSet::const_iterator KanjiIdSet::end() const
+{
+    return ids.constEnd();
+}
+
+const QVector<KanjiId> &KanjiIdSet::getIds() const
+{
+    return ids;
+}
+
+void KanjiIdSet::clear()
+{
+    ids.clear();
+}
+
+void KanjiIdSet::insert(KanjiId id)
+{
+    const_iterator position = std::lower_bound(ids.constBegin(), ids.constEnd(), id);
+    if(position == ids.constEnd() || *position != id)
+        ids.insert(position - ids.constBegin(), id);
+}
+
+KanjiIdSet &KanjiIdSet::unite(const KanjiIdSet &other)
+{
+    // implicitly shared, uniting into an empty set costs nothing
+    if(ids.isEmpty())
+        ids = other.ids;
+    else if(!other.ids.isEmpty())
+    {
+        QVector<KanjiId> merged(ids.size() + other.ids.size());
+        KanjiId *last = std::set_union(ids.constBegin(), ids.constEnd(),
+                                       other.ids.constBegin(), other.ids.constEnd(), merged.data());
+        merged.resize(last - merged.constData());
+        ids = merged;
+    }
+    return *this;
+}
+
+KanjiIdSet &KanjiIdSet::intersect(const KanjiIdSet &other)
+{
+    if(other.ids.isEmpty())
+        ids.clear();
+    else if(!ids.isEmpty())
+    {
+        QVector<KanjiId> common(qMin(ids.size(), other.ids.size()));
+        KanjiId *last = std::set_intersection(ids.constBegin(), ids.constEnd(),
+                                              other.ids.constBegin(), other.ids.constEnd(), common.data());
+        common.resize(last - common.constData());
+        ids = common;
+    }
+    return *this;
+}
+
+KanjiIdSet &KanjiIdSet::subtract(const KanjiIdSet &other)
+{
+    if(!ids.isEmpty() && !other.ids.isEmpty())
+    {
+        QVector<KanjiId> left(ids.size());
+        KanjiId *last = std::set_difference(ids.constBegin(), ids.constEnd(),
+                                            other.ids.constBegin(), other.ids.constEnd(), left.data());
+        left.resize(last - left.constData());
+        ids = left;
+    }
+    return *this;
+}
+
+bool KanjiIdSet::operator ==(const KanjiIdSet &other) const
+{
+    return ids == other.ids;
+}
+
+bool KanjiIdSet::operator !=(const KanjiIdSet &other) const
+{
+    return ids != other.ids;
+}
+
+quint64 KanjiIdSet::memoryUsage() const
+{
+    return sizeof(KanjiIdSet) + MemoryUsage::vector(ids);
+}
@@ -0,0 +1,45 @@
+#ifndef KANJIIDSET_H
+#define KANJIIDSET_H
+
+#include <QVector>
+#include "kanji.h"
+
+// Ids of kanjis of one database, sorted and without duplicates.
+// Union, intersection and difference are merges of two sorted vectors,
+// and a posting list becomes a set without being copied.
+// KanjiDB::toKanjiSet turns it into a KanjiSet.
+class KanjiIdSet
+{
+public:
+    typedef QVector<KanjiId>::const_iterator const_iterator;
+
+    KanjiIdSet();
+    // the ids must be sorted and distinct, they are shared, not copied
+    static KanjiIdSet fromSortedIds(const QVector<KanjiId> &);
+    // ids in any order, duplicates allowed
+    static KanjiIdSet fromIds(const QVector<KanjiId> &);
+
+    bool isEmpty() const;
+    int size() const;
+    KanjiId at(int) const;
+    bool contains(KanjiId) const;
+    // ascending ids
+    const_iterator begin() const;
+    const_iterator end() const;
+    const QVector<KanjiId> &getIds() const;
+
+    void clear();
+    void insert(KanjiId);
+    KanjiIdSet &unite(const KanjiIdSet &);
+    KanjiIdSet &intersect(const KanjiIdSet &);
+    KanjiIdSet &subtract(const KanjiIdSet &);
+    bool operator ==(const KanjiIdSet &) const;
+    bool operator !=(const KanjiIdSet &) const;
+
+    quint64 memoryUsage() const;
+
+private:
+    QVector<KanjiId> ids;
+};
+
+#endif // KANJIIDSET_H
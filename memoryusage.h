@@ -0,0 +1,76 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <QString>
+#include <QSet>
+#include <QMap>
+#include <QList>
+#include <QVector>
+#include <QHash>
+
+// Rough heap size estimates of the Qt containers, used by the memory accounting
+// of KanjiDB. They count the shared data headers, nodes and element storage
+// but ignore allocator overhead, so they are lower bounds.
+namespace MemoryUsage
+{
+    // QString::Data: ref, alloc, size, data pointer and flags, then the UTF-16 buffer
+    inline quint64 string(const QString &s)
+    {
+        if(s.isNull())
+            return 0;
+        return 4 * sizeof(int) + sizeof(void *) + (s.capacity() + 1) * sizeof(QChar);
+    }
+
+    // QHash nodes hold the next pointer, the hash and the key, plus one pointer per bucket
+    template <class T>
+    inline quint64 set(const QSet<T> &s)
+    {
+        if(s.isEmpty())
+            return 0;
+        return 8 * sizeof(int) + s.capacity() * sizeof(void *)
+                + s.size() * (sizeof(void *) + sizeof(uint) + sizeof(T));
+    }
+
+    inline quint64 set(const QSet<QString> &s)
+    {
+        quint64 bytes = 0;
+        if(!s.isEmpty())
+            bytes = 8 * sizeof(int) + s.capacity() * sizeof(void *)
+                    + s.size() * (sizeof(void *) + sizeof(uint) + sizeof(QString));
+        foreach(const QString &string, s)
+            bytes += MemoryUsage::string(string);
+        return bytes;
+    }
+
+    // Qt 4 maps are skip lists, a node has the key, the value, a backward pointer
+    // and 1.33 forward pointers on average
+    template <class Key, class T>
+    inline quint64 mapNodes(const QMap<Key, T> &m)
+    {
+        return m.size() * (sizeof(Key) + sizeof(T) + sizeof(void *) * 7 / 3);
+    }
+
+    template <class T>
+    inline quint64 list(const QList<T> &l)
+    {
+        return l.isEmpty() ? 0 : 4 * sizeof(int) + l.size() * sizeof(void *);
+    }
+
+    // QVectorData header then the elements, in place
+    template <class T>
+    inline quint64 vector(const QVector<T> &v)
+    {
+        return v.capacity() == 0 ? 0 : 4 * sizeof(int) + v.capacity() * sizeof(T);
+    }
+
+    template <class Key, class T>
+    inline quint64 hash(const QHash<Key, T> &h)
+    {
+        if(h.isEmpty())
+            return 0;
+        return 8 * sizeof(int) + h.capacity() * sizeof(void *)
+                + h.size() * (sizeof(void *) + sizeof(uint) + sizeof(Key) + sizeof(T));
+    }
+}
+
+#endif // MEMORYUSAGE_H
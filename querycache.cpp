@@ -0,0 +1,84 @@
+#include "querycache.h"
+#include "kanjidb.h"
+#include <QMutexLocker>
+
+QueryCache::QueryCache(int maxEntries) : cache(maxEntries), generation(0), hits(0), misses(0)
+{
+}
+
+bool QueryCache::find(const QString &query, KanjiIdSet &result) const
+{
+    QMutexLocker locker(&mutex);
+    // object() refreshes the entry, hence the const_cast
+    KanjiIdSet *cached = const_cast<QCache<QString, KanjiIdSet> &>(cache).object(query);
+    if(cached == 0)
+    {
+        ++misses;
+        return false;
+    }
+    ++hits;
+    result = *cached;
+    return true;
+}
+
+void QueryCache::insert(const QString &query, const KanjiIdSet &result, quint64 resultGeneration)
+{
+    QMutexLocker locker(&mutex);
+    if(resultGeneration != generation || cache.maxCost() == 0)
+        return;
+    cache.insert(query, new KanjiIdSet(result), 1);
+}
+
+void QueryCache::invalidate()
+{
+    QMutexLocker locker(&mutex);
+    cache.clear();
+    ++generation;
+}
+
+quint64 QueryCache::getGeneration() const
+{
+    QMutexLocker locker(&mutex);
+    return generation;
+}
+
+void QueryCache::setMaxEntries(int maxEntries)
+{
+    QMutexLocker locker(&mutex);
+    cache.setMaxCost(qMax(maxEntries, 0));
+}
+
+int QueryCache::getMaxEntries() const
+{
+    QMutexLocker locker(&mutex);
+    return cache.maxCost();
+}
+
+int QueryCache::size() const
+{
+    QMutexLocker locker(&mutex);
+    return cache.size();
+}
+
+quint64 QueryCache::getHits() const
+{
+    QMutexLocker locker(&mutex);
+    return hits;
+}
+
+quint64 QueryCache::getMisses() const
+{
+    QMutexLocker locker(&mutex);
+    return misses;
+}
+
+QString QueryCache::normalize(const QString &query)
+{
+    // keys are lower case, so lowering a keyword query only folds the case of
+    // hexadecimal ucs= values. Literal queries are kept as they are.
+    // QRegExp keeps its match state, a copy is needed to match from several threads
+    QRegExp regexp(KanjiDB::searchRegexp);
+    if(regexp.exactMatch(query))
+        return query.toLower();
+    return query;
+}
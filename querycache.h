@@ -0,0 +1,41 @@
+#ifndef QUERYCACHE_H
+#define QUERYCACHE_H
+
+#include <QCache>
+#include <QMutex>
+#include <QString>
+#include "kanjiidset.h"
+
+// Bounded least recently used cache of search results, keyed by normalized query.
+// Results are implicitly shared id vectors, a hit copies nothing.
+// Every change of the database content invalidates it; results computed against
+// an older generation of the data are refused by insert().
+class QueryCache
+{
+public:
+    QueryCache(int maxEntries = 1000);
+
+    bool find(const QString &query, KanjiIdSet &result) const;
+    void insert(const QString &query, const KanjiIdSet &result, quint64 generation);
+    void invalidate();
+    quint64 getGeneration() const;
+
+    // 0 disables the cache
+    void setMaxEntries(int);
+    int getMaxEntries() const;
+    int size() const;
+    quint64 getHits() const;
+    quint64 getMisses() const;
+
+    // 'ucs=4E9C' and 'ucs=4e9c' share their entry
+    static QString normalize(const QString &);
+
+private:
+    mutable QMutex mutex;
+    QCache<QString, KanjiIdSet> cache;
+    quint64 generation;
+    mutable quint64 hits;
+    mutable quint64 misses;
+};
+
+#endif // QUERYCACHE_H
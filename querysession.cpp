@@ -0,0 +1,115 @@
+#include "querysession.h"
+#include "tracer.h"
+
+QuerySession::QuerySession(const KanjiDB &database)
+    : db(database), generation(0), dataGeneration(database.getQueryCache().getGeneration()), reusedGroups(0)
+{
+}
+
+bool QuerySession::search(const QString &s, KanjiIdSet &set)
+{
+    int ticket = generation.fetchAndAddOrdered(1) + 1;
+    QMutexLocker locker(&mutex);
+    QList<SearchKeyGroup> parsed;
+    if(!db.parseQuery(s, parsed))
+    {
+        // a key being typed ('jlpt=2&gr') reads as literal, the groups kept are for the next keys
+        reusedGroups = 0;
+        db.search(s, set);
+        return true;
+    }
+    return evaluate(parsed, ticket, set);
+}
+
+bool QuerySession::search(const QString &s, KanjiSet &set)
+{
+    int ticket = generation.fetchAndAddOrdered(1) + 1;
+    QMutexLocker locker(&mutex);
+    QList<SearchKeyGroup> parsed;
+    if(!db.parseQuery(s, parsed))
+    {
+        // a key being typed ('jlpt=2&gr') reads as literal, the groups kept are for the next keys
+        reusedGroups = 0;
+        db.search(s, set);
+        return true;
+    }
+    KanjiIdSet ids;
+    if(!evaluate(parsed, ticket, ids))
+        return false;
+    db.toKanjiSet(ids, set);
+    return true;
+}
+
+// the result after group i depends on the groups up to i, and on how each was combined
+// with the previous ones: the unite of group i-1 tells how group i is combined
+static bool sameResult(const QList<SearchKeyGroup> &a, const QList<SearchKeyGroup> &b, int i)
+{
+    if(a.at(i).key != b.at(i).key || a.at(i).value != b.at(i).value)
+        return false;
+    return i == 0 || a.at(i - 1).unite == b.at(i - 1).unite;
+}
+
+bool QuerySession::evaluate(const QList<SearchKeyGroup> &parsed, int ticket, KanjiIdSet &set)
+{
+    TraceSpan span("session search");
+    // the kept results are ids, a read of the database renumbers them
+    quint64 currentData = db.getQueryCache().getGeneration();
+    if(currentData != dataGeneration)
+    {
+        groups.clear();
+        results.clear();
+        dataGeneration = currentData;
+    }
+    int shared = 0;
+    while(shared < parsed.size() && shared < results.size() && sameResult(parsed, groups, shared))
+        ++shared;
+    while(results.size() > shared)
+        results.removeLast();
+    groups = parsed.mid(0, shared);
+    reusedGroups = shared;
+
+    KanjiIdSet current = shared > 0 ? results.last() : KanjiIdSet();
+    for(int i = shared; i < parsed.size(); ++i)
+    {
+        // the results of the groups done so far are kept for the next search
+        if((int) generation != ticket)
+            return false;
+        const SearchKeyGroup &group = parsed.at(i);
+        if(group.key == 0)
+        {
+            // as in KanjiDB::search, no result
+            current.clear();
+        } else
+        {
+            TraceSpan keySpan("key group");
+            keySpan.setDetail(*group.key);
+            db.evaluateKeyGroup(group, current, i == 0 || parsed.at(i - 1).unite);
+        }
+        groups << group;
+        results << current;
+        if(group.key == 0)
+            break;
+    }
+    set.unite(current);
+    return true;
+}
+
+void QuerySession::cancel()
+{
+    generation.fetchAndAddOrdered(1);
+}
+
+void QuerySession::reset()
+{
+    cancel();
+    QMutexLocker locker(&mutex);
+    groups.clear();
+    results.clear();
+    reusedGroups = 0;
+}
+
+int QuerySession::getReusedGroups() const
+{
+    QMutexLocker locker(&mutex);
+    return reusedGroups;
+}
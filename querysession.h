@@ -0,0 +1,47 @@
+#ifndef QUERYSESSION_H
+#define QUERYSESSION_H
+
+#include <QList>
+#include <QString>
+#include <QMutex>
+#include <QAtomicInt>
+#include "kanjidb.h"
+
+// Search as you type over one database.
+// The session keeps the key groups of the last query with the result after each of them.
+// A query starting with the same key groups, combined the same way, resumes from the result of the last one shared,
+// so typing 'jlpt=2&grade=3&strokes>8' only evaluates the group being typed.
+// A newer search or cancel(), from any thread, stops the search in progress before its next key group.
+class QuerySession
+{
+public:
+    explicit QuerySession(const KanjiDB &);
+
+    // the results are united into the set
+    // false if stopped before the end, the set is then left as it was
+    bool search(const QString &, KanjiIdSet &);
+    // a literal query keys each kanji by its position, as KanjiDB::search does
+    bool search(const QString &, KanjiSet &);
+    void cancel();
+    // forgets the results kept, a read of the database does it too
+    void reset();
+    // key groups of the last search resumed from the previous one
+    int getReusedGroups() const;
+
+private:
+    bool evaluate(const QList<SearchKeyGroup> &, int ticket, KanjiIdSet &);
+
+    const KanjiDB &db;
+    // bumped by every search and cancel, a search runs as long as it holds the last value
+    QAtomicInt generation;
+    // one search at a time, a newer one waits for the older to stop
+    mutable QMutex mutex;
+    // results[i] is the result of the key groups 0 to i
+    QList<SearchKeyGroup> groups;
+    QList<KanjiIdSet> results;
+    // generation of the database query cache the results were computed on, bumped by every read
+    quint64 dataGeneration;
+    int reusedGroups;
+};
+
+#endif // QUERYSESSION_H
@@ -0,0 +1,109 @@
+#include "querystatistics.h"
+#include <QMutexLocker>
+
+const QString QueryStatistics::literalKeyType("literal");
+const QString QueryStatistics::queryKeyType("query");
+
+KeyStatistics::KeyStatistics()
+    : count(0), totalNsecs(0), maxNsecs(0), totalSetSize(0), maxSetSize(0),
+      latencies(QueryStatistics::bucketCount, 0), setSizes(QueryStatistics::bucketCount, 0)
+{
+}
+
+QueryStatistics::QueryStatistics(int logSize, qint64 threshold)
+    : slowQueryThreshold(threshold), slowQueryLogSize(qMax(logSize, 1)), next(0)
+{
+}
+
+void QueryStatistics::setSlowQueryThreshold(qint64 nsecs)
+{
+    QMutexLocker locker(&mutex);
+    slowQueryThreshold = nsecs;
+}
+
+qint64 QueryStatistics::getSlowQueryThreshold() const
+{
+    QMutexLocker locker(&mutex);
+    return slowQueryThreshold;
+}
+
+QList<SlowQuery> QueryStatistics::getSlowQueries() const
+{
+    QMutexLocker locker(&mutex);
+    QList<SlowQuery> list;
+    // once the buffer is full, next is also the oldest entry
+    for(int i = 0; i < slowQueries.size(); ++i)
+        list << slowQueries.at((next + i) % slowQueries.size());
+    return list;
+}
+
+QStringList QueryStatistics::getKeyTypes() const
+{
+    QMutexLocker locker(&mutex);
+    return keys.keys();
+}
+
+KeyStatistics QueryStatistics::getKeyStatistics(const QString &keyType) const
+{
+    QMutexLocker locker(&mutex);
+    return keys.value(keyType);
+}
+
+void QueryStatistics::reset()
+{
+    QMutexLocker locker(&mutex);
+    keys.clear();
+    slowQueries.clear();
+    next = 0;
+}
+
+int QueryStatistics::bucket(quint64 value)
+{
+    int b = 0;
+    while(value > 1 && b < bucketCount - 1)
+    {
+        value >>= 1;
+        ++b;
+    }
+    return b;
+}
+
+void QueryStatistics::record(KeyStatistics &stats, qint64 nsecs, int setSize)
+{
+    ++stats.count;
+    stats.totalNsecs += nsecs;
+    stats.maxNsecs = qMax(stats.maxNsecs, nsecs);
+    stats.totalSetSize += setSize;
+    stats.maxSetSize = qMax(stats.maxSetSize, (quint64) setSize);
+    ++stats.latencies[bucket(nsecs)];
+    ++stats.setSizes[bucket(setSize)];
+}
+
+void QueryStatistics::recordKeyGroup(const QString &keyType, qint64 nsecs, int setSize)
+{
+    QMutexLocker locker(&mutex);
+    record(keys[keyType], nsecs, setSize);
+}
+
+void QueryStatistics::recordQuery(const QString &query, qint64 nsecs, int resultSize)
+{
+    QMutexLocker locker(&mutex);
+    record(keys[queryKeyType], nsecs, resultSize);
+    if(nsecs < slowQueryThreshold)
+        return;
+
+    SlowQuery slow;
+    slow.query = query;
+    slow.nsecs = nsecs;
+    slow.resultSize = resultSize;
+    slow.time = QDateTime::currentDateTime();
+    if(slowQueries.size() < slowQueryLogSize)
+    {
+        slowQueries.append(slow);
+        next = slowQueries.size() % slowQueryLogSize;
+    } else
+    {
+        slowQueries[next] = slow;
+        next = (next + 1) % slowQueryLogSize;
+    }
+}
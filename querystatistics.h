@@ -0,0 +1,76 @@
+#ifndef QUERYSTATISTICS_H
+#define QUERYSTATISTICS_H
+
+#include <QString>
+#include <QStringList>
+#include <QMap>
+#include <QVector>
+#include <QList>
+#include <QDateTime>
+#include <QMutex>
+
+// a query slower than the threshold, kept in the slow query log
+struct SlowQuery
+{
+    QString query;
+    qint64 nsecs;
+    int resultSize;
+    QDateTime time;
+};
+
+// aggregated measures of one key type ('jlpt=', 'strokes<'...), of literal lookups or of whole queries
+struct KeyStatistics
+{
+    KeyStatistics();
+
+    quint64 count;
+    qint64 totalNsecs;
+    qint64 maxNsecs;
+    // size of the result set after the key group was applied
+    quint64 totalSetSize;
+    quint64 maxSetSize;
+    // bucket i counts the measures in [2^i, 2^(i+1)[ nanoseconds, or items for set sizes
+    QVector<quint64> latencies;
+    QVector<quint64> setSizes;
+};
+
+// Per query instrumentation of KanjiDB::search.
+// Nothing is measured unless an instance is given to KanjiDB::setQueryStatistics,
+// a disabled search only pays for a null pointer test.
+// Recording and reading are thread safe.
+class QueryStatistics
+{
+public:
+    QueryStatistics(int slowQueryLogSize = 100, qint64 slowQueryThresholdNsecs = 10000000);
+
+    void setSlowQueryThreshold(qint64 nsecs);
+    qint64 getSlowQueryThreshold() const;
+    // oldest first, at most slowQueryLogSize queries
+    QList<SlowQuery> getSlowQueries() const;
+
+    QStringList getKeyTypes() const;
+    KeyStatistics getKeyStatistics(const QString &keyType) const;
+    void reset();
+
+    void recordKeyGroup(const QString &keyType, qint64 nsecs, int setSize);
+    void recordQuery(const QString &query, qint64 nsecs, int resultSize);
+
+    static const int bucketCount = 40;
+    // key types of the measures that are not a key group
+    static const QString literalKeyType;
+    static const QString queryKeyType;
+
+private:
+    static int bucket(quint64);
+    void record(KeyStatistics &, qint64 nsecs, int setSize);
+
+    mutable QMutex mutex;
+    QMap<QString, KeyStatistics> keys;
+    qint64 slowQueryThreshold;
+    // ring buffer, next is the slot the next slow query overwrites
+    QVector<SlowQuery> slowQueries;
+    int slowQueryLogSize;
+    int next;
+};
+
+#endif // QUERYSTATISTICS_H
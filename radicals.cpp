@@ -1,219 +1,599 @@
 #include "radicals.h"
 
-const QString Radicals::radicals[] = {
-    QString::fromUtf8("一:1"),
-    QString::fromUtf8("丨:1"),
-    QString::fromUtf8("丶:1"),
-    QString::fromUtf8("丿:1"),
-    QString::fromUtf8("乙乛⺄乚:1"),
-    QString::fromUtf8("亅:1"),
-    QString::fromUtf8("二:2"),
-    QString::fromUtf8("亠:2"),
-    QString::fromUtf8("人亻:2"),
-    QString::fromUtf8("儿:2"),
-    QString::fromUtf8("入:2"),
-    QString::fromUtf8("八:2"),
-    QString::fromUtf8("冂:2"),
-    QString::fromUtf8("冖:2"),
-    QString::fromUtf8("冫:2"),
-    QString::fromUtf8("几:2"),
-    QString::fromUtf8("凵:2"),
-    QString::fromUtf8("刀刂:2"),
-    QString::fromUtf8("力:2"),
-    QString::fromUtf8("勹:2"),
-    QString::fromUtf8("匕:2"),
-    QString::fromUtf8("匚:2"),
-    QString::fromUtf8("匸:2"),
-    QString::fromUtf8("十:2"),
-    QString::fromUtf8("卜:2"),
-    QString::fromUtf8("卩:2"),
-    QString::fromUtf8("厂:2"),
-    QString::fromUtf8("厶:2"),
-    QString::fromUtf8("又:2"),
-    QString::fromUtf8("口:3"),
-    QString::fromUtf8("囗:3"),
-    QString::fromUtf8("土:3"),
-    QString::fromUtf8("士:3"),
-    QString::fromUtf8("夂:3"),
-    QString::fromUtf8("夊:3"),
-    QString::fromUtf8("夕:3"),
-    QString::fromUtf8("大:3"),
-    QString::fromUtf8("女:3"),
-    QString::fromUtf8("子:3"),
-    QString::fromUtf8("宀:3"),
-    QString::fromUtf8("寸:3"),
-    QString::fromUtf8("小:3"),
-    QString::fromUtf8("尢尣:3"),
-    QString::fromUtf8("尸:3"),
-    QString::fromUtf8("屮:3"),
-    QString::fromUtf8("山:3"),
-    QString::fromUtf8("川巛巜:3"),
-    QString::fromUtf8("工:3"),
-    QString::fromUtf8("己巳已㔾:3"),
-    QString::fromUtf8("巾:3"),
-    QString::fromUtf8("干:3"),
-    QString::fromUtf8("幺:3"),
-    QString::fromUtf8("广:3"),
-    QString::fromUtf8("廴:3"),
-    QString::fromUtf8("廾:3"),
-    QString::fromUtf8("弋:3"),
-    QString::fromUtf8("弓:3"),
-    QString::fromUtf8("彐彑:3"),
-    QString::fromUtf8("彡:3"),
-    QString::fromUtf8("彳:3"),
-    QString::fromUtf8("心忄⺗:4"),
-    QString::fromUtf8("戈:4"),
-    QString::fromUtf8("戸戶户:4"),
-    QString::fromUtf8("手扌龵:4"),
-    QString::fromUtf8("支:4"),
-    QString::fromUtf8("攴攵:4"),
-    QString::fromUtf8("文:4"),
-    QString::fromUtf8("斗:4"),
-    QString::fromUtf8("斤:4"),
-    QString::fromUtf8("方:4"),
-    QString::fromUtf8("无:4"),
-    QString::fromUtf8("日:4"),
-    QString::fromUtf8("曰:4"),
-    QString::fromUtf8("月:4"),
-    QString::fromUtf8("木:4"),
-    QString::fromUtf8("欠:4"),
-    QString::fromUtf8("止:4"),
-    QString::fromUtf8("歹歺:4"),
-    QString::fromUtf8("殳:4"),
-    QString::fromUtf8("母毋⺟:4"),
-    QString::fromUtf8("比:4"),
-    QString::fromUtf8("毛:4"),
-    QString::fromUtf8("氏:4"),
-    QString::fromUtf8("气:4"),
-    QString::fromUtf8("水氵氺:4"),
-    QString::fromUtf8("火灬:4"),
-    QString::fromUtf8("爪爫:4"),
-    QString::fromUtf8("父:4"),
-    QString::fromUtf8("爻:4"),
-    QString::fromUtf8("爿:4"),
-    QString::fromUtf8("片:4"),
-    QString::fromUtf8("牙:4"),
-    QString::fromUtf8("牛牜:4"),
-    QString::fromUtf8("犬犭:4"),
-    QString::fromUtf8("玄:5"),
-    QString::fromUtf8("玉王:5"),
-    QString::fromUtf8("瓜:5"),
-    QString::fromUtf8("瓦:5"),
-    QString::fromUtf8("甘:5"),
-    QString::fromUtf8("生:5"),
-    QString::fromUtf8("用甩:5"),
-    QString::fromUtf8("田:5"),
-    QString::fromUtf8("疋⺪:5"),
-    QString::fromUtf8("疒:5"),
-    QString::fromUtf8("癶:5"),
-    QString::fromUtf8("白:5"),
-    QString::fromUtf8("皮:5"),
-    QString::fromUtf8("皿:5"),
-    QString::fromUtf8("目:5"),
-    QString::fromUtf8("矛:5"),
-    QString::fromUtf8("矢:5"),
-    QString::fromUtf8("石:5"),
-    QString::fromUtf8("示礻:5"),
-    QString::fromUtf8("禸:5"),
-    QString::fromUtf8("禾:5"),
-    QString::fromUtf8("穴:5"),
-    QString::fromUtf8("立:5"),
-    QString::fromUtf8("竹⺮:6"),
-    QString::fromUtf8("米:6"),
-    QString::fromUtf8("糸糹:6"),
-    QString::fromUtf8("缶:6"),
-    QString::fromUtf8("网罒⺲罓⺳:6"),
-    QString::fromUtf8("羊⺶:6"),
-    QString::fromUtf8("羽:6"),
-    QString::fromUtf8("老耂:6"),
-    QString::fromUtf8("而:6"),
-    QString::fromUtf8("耒:6"),
-    QString::fromUtf8("耳:6"),
-    QString::fromUtf8("聿⺻:6"),
-    QString::fromUtf8("肉⺼:6"),
-    QString::fromUtf8("臣:6"),
-    QString::fromUtf8("自:6"),
-    QString::fromUtf8("至:6"),
-    QString::fromUtf8("臼:6"),
-    QString::fromUtf8("舌:6"),
-    QString::fromUtf8("舛:6"),
-    QString::fromUtf8("舟:6"),
-    QString::fromUtf8("艮:6"),
-    QString::fromUtf8("色:6"),
-    QString::fromUtf8("艸艹:6"),
-    QString::fromUtf8("虍:6"),
-    QString::fromUtf8("虫:6"),
-    QString::fromUtf8("血:6"),
-    QString::fromUtf8("行:6"),
-    QString::fromUtf8("衣衤:6"),
-    QString::fromUtf8("西襾覀:6"),
-    QString::fromUtf8("見:7"),
-    QString::fromUtf8("角:7"),
-    QString::fromUtf8("言訁:7"),
-    QString::fromUtf8("谷:7"),
-    QString::fromUtf8("豆:7"),
-    QString::fromUtf8("豕:7"),
-    QString::fromUtf8("豸:7"),
-    QString::fromUtf8("貝:7"),
-    QString::fromUtf8("赤:7"),
-    QString::fromUtf8("走赱:7"),
-    QString::fromUtf8("足⻊:7"),
-    QString::fromUtf8("身:7"),
-    QString::fromUtf8("車:7"),
-    QString::fromUtf8("辛:7"),
-    QString::fromUtf8("辰:7"),
-    QString::fromUtf8("辶辵⻌⻍:7"),
-    QString::fromUtf8("邑阝:7"),
-    QString::fromUtf8("酉:7"),
-    QString::fromUtf8("釆:7"),
-    QString::fromUtf8("里:7"),
-    QString::fromUtf8("金釒:8"),
-    QString::fromUtf8("長镸:8"),
-    QString::fromUtf8("門:8"),
-    QString::fromUtf8("阜阝:8"),
-    QString::fromUtf8("隶:8"),
-    QString::fromUtf8("隹:8"),
-    QString::fromUtf8("雨:8"),
-    QString::fromUtf8("青靑:8"),
-    QString::fromUtf8("非:8"),
-    QString::fromUtf8("面靣:9"),
-    QString::fromUtf8("革:9"),
-    QString::fromUtf8("韋:9"),
-    QString::fromUtf8("韭:9"),
-    QString::fromUtf8("音:9"),
-    QString::fromUtf8("頁:9"),
-    QString::fromUtf8("風:9"),
-    QString::fromUtf8("飛:9"),
-    QString::fromUtf8("食飠:9"),
-    QString::fromUtf8("首:9"),
-    QString::fromUtf8("香:9"),
-    QString::fromUtf8("馬:10"),
-    QString::fromUtf8("骨:10"),
-    QString::fromUtf8("高髙:10"),
-    QString::fromUtf8("髟:10"),
-    QString::fromUtf8("鬥:10"),
-    QString::fromUtf8("鬯:10"),
-    QString::fromUtf8("鬲:10"),
-    QString::fromUtf8("鬼:10"),
-    QString::fromUtf8("魚:11"),
-    QString::fromUtf8("鳥:11"),
-    QString::fromUtf8("鹵:11"),
-    QString::fromUtf8("鹿:11"),
-    QString::fromUtf8("麥:11"),
-    QString::fromUtf8("麻:11"),
-    QString::fromUtf8("黃:12"),
-    QString::fromUtf8("黍:12"),
-    QString::fromUtf8("黑黒:12"),
-    QString::fromUtf8("黹:12"),
-    QString::fromUtf8("黽:13"),
-    QString::fromUtf8("鼎:13"),
-    QString::fromUtf8("鼓:13"),
-    QString::fromUtf8("鼠:13"),
-    QString::fromUtf8("鼻:14"),
-    QString::fromUtf8("齊:14"),
-    QString::fromUtf8("齒歯:15"),
-    QString::fromUtf8("龍:16"),
-    QString::fromUtf8("龜:16"),
-    QString::fromUtf8("龠:17")
+// the 214 classical radicals with their stroke counts, master character first
+// plain aggregates: the tables are laid out by the compiler, nothing runs at startup
+
+const RadicalCharacter Radicals::radicals[radicalsSize] = {
+    {0x4E00, 1, 1}, // 一
+    {0x4E28, 2, 1}, // 丨
+    {0x4E36, 3, 1}, // 丶
+    {0x4E3F, 4, 1}, // 丿
+    {0x4E59, 5, 1}, // 乙
+    {0x4E85, 6, 1}, // 亅
+    {0x4E8C, 7, 2}, // 二
+    {0x4EA0, 8, 2}, // 亠
+    {0x4EBA, 9, 2}, // 人
+    {0x513F, 10, 2}, // 儿
+    {0x5165, 11, 2}, // 入
+    {0x516B, 12, 2}, // 八
+    {0x5182, 13, 2}, // 冂
+    {0x5196, 14, 2}, // 冖
+    {0x51AB, 15, 2}, // 冫
+    {0x51E0, 16, 2}, // 几
+    {0x51F5, 17, 2}, // 凵
+    {0x5200, 18, 2}, // 刀
+    {0x529B, 19, 2}, // 力
+    {0x52F9, 20, 2}, // 勹
+    {0x5315, 21, 2}, // 匕
+    {0x531A, 22, 2}, // 匚
+    {0x5338, 23, 2}, // 匸
+    {0x5341, 24, 2}, // 十
+    {0x535C, 25, 2}, // 卜
+    {0x5369, 26, 2}, // 卩
+    {0x5382, 27, 2}, // 厂
+    {0x53B6, 28, 2}, // 厶
+    {0x53C8, 29, 2}, // 又
+    {0x53E3, 30, 3}, // 口
+    {0x56D7, 31, 3}, // 囗
+    {0x571F, 32, 3}, // 土
+    {0x58EB, 33, 3}, // 士
+    {0x5902, 34, 3}, // 夂
+    {0x590A, 35, 3}, // 夊
+    {0x5915, 36, 3}, // 夕
+    {0x5927, 37, 3}, // 大
+    {0x5973, 38, 3}, // 女
+    {0x5B50, 39, 3}, // 子
+    {0x5B80, 40, 3}, // 宀
+    {0x5BF8, 41, 3}, // 寸
+    {0x5C0F, 42, 3}, // 小
+    {0x5C22, 43, 3}, // 尢
+    {0x5C38, 44, 3}, // 尸
+    {0x5C6E, 45, 3}, // 屮
+    {0x5C71, 46, 3}, // 山
+    {0x5DDD, 47, 3}, // 川
+    {0x5DE5, 48, 3}, // 工
+    {0x5DF1, 49, 3}, // 己
+    {0x5DFE, 50, 3}, // 巾
+    {0x5E72, 51, 3}, // 干
+    {0x5E7A, 52, 3}, // 幺
+    {0x5E7F, 53, 3}, // 广
+    {0x5EF4, 54, 3}, // 廴
+    {0x5EFE, 55, 3}, // 廾
+    {0x5F0B, 56, 3}, // 弋
+    {0x5F13, 57, 3}, // 弓
+    {0x5F50, 58, 3}, // 彐
+    {0x5F61, 59, 3}, // 彡
+    {0x5F73, 60, 3}, // 彳
+    {0x5FC3, 61, 4}, // 心
+    {0x6208, 62, 4}, // 戈
+    {0x6238, 63, 4}, // 戸
+    {0x624B, 64, 4}, // 手
+    {0x652F, 65, 4}, // 支
+    {0x6534, 66, 4}, // 攴
+    {0x6587, 67, 4}, // 文
+    {0x6597, 68, 4}, // 斗
+    {0x65A4, 69, 4}, // 斤
+    {0x65B9, 70, 4}, // 方
+    {0x65E0, 71, 4}, // 无
+    {0x65E5, 72, 4}, // 日
+    {0x66F0, 73, 4}, // 曰
+    {0x6708, 74, 4}, // 月
+    {0x6728, 75, 4}, // 木
+    {0x6B20, 76, 4}, // 欠
+    {0x6B62, 77, 4}, // 止
+    {0x6B79, 78, 4}, // 歹
+    {0x6BB3, 79, 4}, // 殳
+    {0x6BCD, 80, 4}, // 母
+    {0x6BD4, 81, 4}, // 比
+    {0x6BDB, 82, 4}, // 毛
+    {0x6C0F, 83, 4}, // 氏
+    {0x6C14, 84, 4}, // 气
+    {0x6C34, 85, 4}, // 水
+    {0x706B, 86, 4}, // 火
+    {0x722A, 87, 4}, // 爪
+    {0x7236, 88, 4}, // 父
+    {0x723B, 89, 4}, // 爻
+    {0x723F, 90, 4}, // 爿
+    {0x7247, 91, 4}, // 片
+    {0x7259, 92, 4}, // 牙
+    {0x725B, 93, 4}, // 牛
+    {0x72AC, 94, 4}, // 犬
+    {0x7384, 95, 5}, // 玄
+    {0x7389, 96, 5}, // 玉
+    {0x74DC, 97, 5}, // 瓜
+    {0x74E6, 98, 5}, // 瓦
+    {0x7518, 99, 5}, // 甘
+    {0x751F, 100, 5}, // 生
+    {0x7528, 101, 5}, // 用
+    {0x7530, 102, 5}, // 田
+    {0x758B, 103, 5}, // 疋
+    {0x7592, 104, 5}, // 疒
+    {0x7676, 105, 5}, // 癶
+    {0x767D, 106, 5}, // 白
+    {0x76AE, 107, 5}, // 皮
+    {0x76BF, 108, 5}, // 皿
+    {0x76EE, 109, 5}, // 目
+    {0x77DB, 110, 5}, // 矛
+    {0x77E2, 111, 5}, // 矢
+    {0x77F3, 112, 5}, // 石
+    {0x793A, 113, 5}, // 示
+    {0x79B8, 114, 5}, // 禸
+    {0x79BE, 115, 5}, // 禾
+    {0x7A74, 116, 5}, // 穴
+    {0x7ACB, 117, 5}, // 立
+    {0x7AF9, 118, 6}, // 竹
+    {0x7C73, 119, 6}, // 米
+    {0x7CF8, 120, 6}, // 糸
+    {0x7F36, 121, 6}, // 缶
+    {0x7F51, 122, 6}, // 网
+    {0x7F8A, 123, 6}, // 羊
+    {0x7FBD, 124, 6}, // 羽
+    {0x8001, 125, 6}, // 老
+    {0x800C, 126, 6}, // 而
+    {0x8012, 127, 6}, // 耒
+    {0x8033, 128, 6}, // 耳
+    {0x807F, 129, 6}, // 聿
+    {0x8089, 130, 6}, // 肉
+    {0x81E3, 131, 6}, // 臣
+    {0x81EA, 132, 6}, // 自
+    {0x81F3, 133, 6}, // 至
+    {0x81FC, 134, 6}, // 臼
+    {0x820C, 135, 6}, // 舌
+    {0x821B, 136, 6}, // 舛
+    {0x821F, 137, 6}, // 舟
+    {0x826E, 138, 6}, // 艮
+    {0x8272, 139, 6}, // 色
+    {0x8278, 140, 6}, // 艸
+    {0x864D, 141, 6}, // 虍
+    {0x866B, 142, 6}, // 虫
+    {0x8840, 143, 6}, // 血
+    {0x884C, 144, 6}, // 行
+    {0x8863, 145, 6}, // 衣
+    {0x897F, 146, 6}, // 西
+    {0x898B, 147, 7}, // 見
+    {0x89D2, 148, 7}, // 角
+    {0x8A00, 149, 7}, // 言
+    {0x8C37, 150, 7}, // 谷
+    {0x8C46, 151, 7}, // 豆
+    {0x8C55, 152, 7}, // 豕
+    {0x8C78, 153, 7}, // 豸
+    {0x8C9D, 154, 7}, // 貝
+    {0x8D64, 155, 7}, // 赤
+    {0x8D70, 156, 7}, // 走
+    {0x8DB3, 157, 7}, // 足
+    {0x8EAB, 158, 7}, // 身
+    {0x8ECA, 159, 7}, // 車
+    {0x8F9B, 160, 7}, // 辛
+    {0x8FB0, 161, 7}, // 辰
+    {0x8FB6, 162, 7}, // 辶
+    {0x9091, 163, 7}, // 邑
+    {0x9149, 164, 7}, // 酉
+    {0x91C6, 165, 7}, // 釆
+    {0x91CC, 166, 7}, // 里
+    {0x91D1, 167, 8}, // 金
+    {0x9577, 168, 8}, // 長
+    {0x9580, 169, 8}, // 門
+    {0x961C, 170, 8}, // 阜
+    {0x96B6, 171, 8}, // 隶
+    {0x96B9, 172, 8}, // 隹
+    {0x96E8, 173, 8}, // 雨
+    {0x9752, 174, 8}, // 青
+    {0x975E, 175, 8}, // 非
+    {0x9762, 176, 9}, // 面
+    {0x9769, 177, 9}, // 革
+    {0x97CB, 178, 9}, // 韋
+    {0x97ED, 179, 9}, // 韭
+    {0x97F3, 180, 9}, // 音
+    {0x9801, 181, 9}, // 頁
+    {0x98A8, 182, 9}, // 風
+    {0x98DB, 183, 9}, // 飛
+    {0x98DF, 184, 9}, // 食
+    {0x9996, 185, 9}, // 首
+    {0x9999, 186, 9}, // 香
+    {0x99AC, 187, 10}, // 馬
+    {0x9AA8, 188, 10}, // 骨
+    {0x9AD8, 189, 10}, // 高
+    {0x9ADF, 190, 10}, // 髟
+    {0x9B25, 191, 10}, // 鬥
+    {0x9B2F, 192, 10}, // 鬯
+    {0x9B32, 193, 10}, // 鬲
+    {0x9B3C, 194, 10}, // 鬼
+    {0x9B5A, 195, 11}, // 魚
+    {0x9CE5, 196, 11}, // 鳥
+    {0x9E75, 197, 11}, // 鹵
+    {0x9E7F, 198, 11}, // 鹿
+    {0x9EA5, 199, 11}, // 麥
+    {0x9EBB, 200, 11}, // 麻
+    {0x9EC3, 201, 12}, // 黃
+    {0x9ECD, 202, 12}, // 黍
+    {0x9ED1, 203, 12}, // 黑
+    {0x9EF9, 204, 12}, // 黹
+    {0x9EFD, 205, 13}, // 黽
+    {0x9F0E, 206, 13}, // 鼎
+    {0x9F13, 207, 13}, // 鼓
+    {0x9F20, 208, 13}, // 鼠
+    {0x9F3B, 209, 14}, // 鼻
+    {0x9F4A, 210, 14}, // 齊
+    {0x9F52, 211, 15}, // 齒
+    {0x9F8D, 212, 16}, // 龍
+    {0x9F9C, 213, 16}, // 龜
+    {0x9FA0, 214, 17}  // 龠
+};
+
+const unsigned short Radicals::variantOffsets[radicalsSize + 1] = {
+    0, 0, 0, 0, 0, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4,
+    4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 8,
+    8, 11, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 14, 14, 16,
+    18, 18, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 19, 20, 20,
+    22, 22, 22, 22, 22, 24, 25, 26, 26, 26, 26, 26, 26, 27, 28, 28,
+    29, 29, 29, 29, 29, 30, 30, 31, 31, 31, 31, 31, 31, 31, 31, 31,
+    31, 32, 32, 32, 32, 32, 33, 33, 34, 34, 38, 39, 39, 40, 40, 40,
+    40, 41, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 43, 43, 43, 43,
+    43, 44, 46, 46, 46, 47, 47, 47, 47, 47, 47, 47, 48, 49, 49, 49,
+    49, 49, 52, 53, 53, 53, 53, 54, 55, 55, 56, 56, 56, 56, 57, 57,
+    58, 58, 58, 58, 58, 58, 58, 58, 59, 59, 59, 59, 59, 60, 60, 60,
+    60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 60, 61, 61, 61, 61, 61,
+    61, 61, 61, 62, 62, 62, 62
+};
+
+const unsigned short Radicals::variants[variantsSize] = {
+    0x4E5B, // 乛
+    0x2E84, // ⺄
+    0x4E5A, // 乚
+    0x4EBB, // 亻
+    0x5202, // 刂
+    0x5C23, // 尣
+    0x5DDB, // 巛
+    0x5DDC, // 巜
+    0x5DF3, // 巳
+    0x5DF2, // 已
+    0x353E, // 㔾
+    0x5F51, // 彑
+    0x5FC4, // 忄
+    0x2E97, // ⺗
+    0x6236, // 戶
+    0x6237, // 户
+    0x624C, // 扌
+    0x9FB5, // 龵
+    0x6535, // 攵
+    0x6B7A, // 歺
+    0x6BCB, // 毋
+    0x2E9F, // ⺟
+    0x6C35, // 氵
+    0x6C3A, // 氺
+    0x706C, // 灬
+    0x722B, // 爫
+    0x725C, // 牜
+    0x72AD, // 犭
+    0x738B, // 王
+    0x7529, // 甩
+    0x2EAA, // ⺪
+    0x793B, // 礻
+    0x2EAE, // ⺮
+    0x7CF9, // 糹
+    0x7F52, // 罒
+    0x2EB2, // ⺲
+    0x7F53, // 罓
+    0x2EB3, // ⺳
+    0x2EB6, // ⺶
+    0x8002, // 耂
+    0x2EBB, // ⺻
+    0x2EBC, // ⺼
+    0x8279, // 艹
+    0x8864, // 衤
+    0x897E, // 襾
+    0x8980, // 覀
+    0x8A01, // 訁
+    0x8D71, // 赱
+    0x2ECA, // ⻊
+    0x8FB5, // 辵
+    0x2ECC, // ⻌
+    0x2ECD, // ⻍
+    0x961D, // 阝
+    0x91D2, // 釒
+    0x9578, // 镸
+    0x961D, // 阝
+    0x9751, // 靑
+    0x9763, // 靣
+    0x98E0, // 飠
+    0x9AD9, // 髙
+    0x9ED2, // 黒
+    0x6B6F  // 歯
+};
+
+// 阝 is a variant of both radical 163 and radical 170, it is looked up as 170
+const RadicalCharacter Radicals::characters[charactersSize] = {
+    {0x2E84, 5, 1}, // ⺄
+    {0x2E97, 61, 4}, // ⺗
+    {0x2E9F, 80, 4}, // ⺟
+    {0x2EAA, 103, 5}, // ⺪
+    {0x2EAE, 118, 6}, // ⺮
+    {0x2EB2, 122, 6}, // ⺲
+    {0x2EB3, 122, 6}, // ⺳
+    {0x2EB6, 123, 6}, // ⺶
+    {0x2EBB, 129, 6}, // ⺻
+    {0x2EBC, 130, 6}, // ⺼
+    {0x2ECA, 157, 7}, // ⻊
+    {0x2ECC, 162, 7}, // ⻌
+    {0x2ECD, 162, 7}, // ⻍
+    {0x353E, 49, 3}, // 㔾
+    {0x4E00, 1, 1}, // 一
+    {0x4E28, 2, 1}, // 丨
+    {0x4E36, 3, 1}, // 丶
+    {0x4E3F, 4, 1}, // 丿
+    {0x4E59, 5, 1}, // 乙
+    {0x4E5A, 5, 1}, // 乚
+    {0x4E5B, 5, 1}, // 乛
+    {0x4E85, 6, 1}, // 亅
+    {0x4E8C, 7, 2}, // 二
+    {0x4EA0, 8, 2}, // 亠
+    {0x4EBA, 9, 2}, // 人
+    {0x4EBB, 9, 2}, // 亻
+    {0x513F, 10, 2}, // 儿
+    {0x5165, 11, 2}, // 入
+    {0x516B, 12, 2}, // 八
+    {0x5182, 13, 2}, // 冂
+    {0x5196, 14, 2}, // 冖
+    {0x51AB, 15, 2}, // 冫
+    {0x51E0, 16, 2}, // 几
+    {0x51F5, 17, 2}, // 凵
+    {0x5200, 18, 2}, // 刀
+    {0x5202, 18, 2}, // 刂
+    {0x529B, 19, 2}, // 力
+    {0x52F9, 20, 2}, // 勹
+    {0x5315, 21, 2}, // 匕
+    {0x531A, 22, 2}, // 匚
+    {0x5338, 23, 2}, // 匸
+    {0x5341, 24, 2}, // 十
+    {0x535C, 25, 2}, // 卜
+    {0x5369, 26, 2}, // 卩
+    {0x5382, 27, 2}, // 厂
+    {0x53B6, 28, 2}, // 厶
+    {0x53C8, 29, 2}, // 又
+    {0x53E3, 30, 3}, // 口
+    {0x56D7, 31, 3}, // 囗
+    {0x571F, 32, 3}, // 土
+    {0x58EB, 33, 3}, // 士
+    {0x5902, 34, 3}, // 夂
+    {0x590A, 35, 3}, // 夊
+    {0x5915, 36, 3}, // 夕
+    {0x5927, 37, 3}, // 大
+    {0x5973, 38, 3}, // 女
+    {0x5B50, 39, 3}, // 子
+    {0x5B80, 40, 3}, // 宀
+    {0x5BF8, 41, 3}, // 寸
+    {0x5C0F, 42, 3}, // 小
+    {0x5C22, 43, 3}, // 尢
+    {0x5C23, 43, 3}, // 尣
+    {0x5C38, 44, 3}, // 尸
+    {0x5C6E, 45, 3}, // 屮
+    {0x5C71, 46, 3}, // 山
+    {0x5DDB, 47, 3}, // 巛
+    {0x5DDC, 47, 3}, // 巜
+    {0x5DDD, 47, 3}, // 川
+    {0x5DE5, 48, 3}, // 工
+    {0x5DF1, 49, 3}, // 己
+    {0x5DF2, 49, 3}, // 已
+    {0x5DF3, 49, 3}, // 巳
+    {0x5DFE, 50, 3}, // 巾
+    {0x5E72, 51, 3}, // 干
+    {0x5E7A, 52, 3}, // 幺
+    {0x5E7F, 53, 3}, // 广
+    {0x5EF4, 54, 3}, // 廴
+    {0x5EFE, 55, 3}, // 廾
+    {0x5F0B, 56, 3}, // 弋
+    {0x5F13, 57, 3}, // 弓
+    {0x5F50, 58, 3}, // 彐
+    {0x5F51, 58, 3}, // 彑
+    {0x5F61, 59, 3}, // 彡
+    {0x5F73, 60, 3}, // 彳
+    {0x5FC3, 61, 4}, // 心
+    {0x5FC4, 61, 4}, // 忄
+    {0x6208, 62, 4}, // 戈
+    {0x6236, 63, 4}, // 戶
+    {0x6237, 63, 4}, // 户
+    {0x6238, 63, 4}, // 戸
+    {0x624B, 64, 4}, // 手
+    {0x624C, 64, 4}, // 扌
+    {0x652F, 65, 4}, // 支
+    {0x6534, 66, 4}, // 攴
+    {0x6535, 66, 4}, // 攵
+    {0x6587, 67, 4}, // 文
+    {0x6597, 68, 4}, // 斗
+    {0x65A4, 69, 4}, // 斤
+    {0x65B9, 70, 4}, // 方
+    {0x65E0, 71, 4}, // 无
+    {0x65E5, 72, 4}, // 日
+    {0x66F0, 73, 4}, // 曰
+    {0x6708, 74, 4}, // 月
+    {0x6728, 75, 4}, // 木
+    {0x6B20, 76, 4}, // 欠
+    {0x6B62, 77, 4}, // 止
+    {0x6B6F, 211, 15}, // 歯
+    {0x6B79, 78, 4}, // 歹
+    {0x6B7A, 78, 4}, // 歺
+    {0x6BB3, 79, 4}, // 殳
+    {0x6BCB, 80, 4}, // 毋
+    {0x6BCD, 80, 4}, // 母
+    {0x6BD4, 81, 4}, // 比
+    {0x6BDB, 82, 4}, // 毛
+    {0x6C0F, 83, 4}, // 氏
+    {0x6C14, 84, 4}, // 气
+    {0x6C34, 85, 4}, // 水
+    {0x6C35, 85, 4}, // 氵
+    {0x6C3A, 85, 4}, // 氺
+    {0x706B, 86, 4}, // 火
+    {0x706C, 86, 4}, // 灬
+    {0x722A, 87, 4}, // 爪
+    {0x722B, 87, 4}, // 爫
+    {0x7236, 88, 4}, // 父
+    {0x723B, 89, 4}, // 爻
+    {0x723F, 90, 4}, // 爿
+    {0x7247, 91, 4}, // 片
+    {0x7259, 92, 4}, // 牙
+    {0x725B, 93, 4}, // 牛
+    {0x725C, 93, 4}, // 牜
+    {0x72AC, 94, 4}, // 犬
+    {0x72AD, 94, 4}, // 犭
+    {0x7384, 95, 5}, // 玄
+    {0x7389, 96, 5}, // 玉
+    {0x738B, 96, 5}, // 王
+    {0x74DC, 97, 5}, // 瓜
+    {0x74E6, 98, 5}, // 瓦
+    {0x7518, 99, 5}, // 甘
+    {0x751F, 100, 5}, // 生
+    {0x7528, 101, 5}, // 用
+    {0x7529, 101, 5}, // 甩
+    {0x7530, 102, 5}, // 田
+    {0x758B, 103, 5}, // 疋
+    {0x7592, 104, 5}, // 疒
+    {0x7676, 105, 5}, // 癶
+    {0x767D, 106, 5}, // 白
+    {0x76AE, 107, 5}, // 皮
+    {0x76BF, 108, 5}, // 皿
+    {0x76EE, 109, 5}, // 目
+    {0x77DB, 110, 5}, // 矛
+    {0x77E2, 111, 5}, // 矢
+    {0x77F3, 112, 5}, // 石
+    {0x793A, 113, 5}, // 示
+    {0x793B, 113, 5}, // 礻
+    {0x79B8, 114, 5}, // 禸
+    {0x79BE, 115, 5}, // 禾
+    {0x7A74, 116, 5}, // 穴
+    {0x7ACB, 117, 5}, // 立
+    {0x7AF9, 118, 6}, // 竹
+    {0x7C73, 119, 6}, // 米
+    {0x7CF8, 120, 6}, // 糸
+    {0x7CF9, 120, 6}, // 糹
+    {0x7F36, 121, 6}, // 缶
+    {0x7F51, 122, 6}, // 网
+    {0x7F52, 122, 6}, // 罒
+    {0x7F53, 122, 6}, // 罓
+    {0x7F8A, 123, 6}, // 羊
+    {0x7FBD, 124, 6}, // 羽
+    {0x8001, 125, 6}, // 老
+    {0x8002, 125, 6}, // 耂
+    {0x800C, 126, 6}, // 而
+    {0x8012, 127, 6}, // 耒
+    {0x8033, 128, 6}, // 耳
+    {0x807F, 129, 6}, // 聿
+    {0x8089, 130, 6}, // 肉
+    {0x81E3, 131, 6}, // 臣
+    {0x81EA, 132, 6}, // 自
+    {0x81F3, 133, 6}, // 至
+    {0x81FC, 134, 6}, // 臼
+    {0x820C, 135, 6}, // 舌
+    {0x821B, 136, 6}, // 舛
+    {0x821F, 137, 6}, // 舟
+    {0x826E, 138, 6}, // 艮
+    {0x8272, 139, 6}, // 色
+    {0x8278, 140, 6}, // 艸
+    {0x8279, 140, 6}, // 艹
+    {0x864D, 141, 6}, // 虍
+    {0x866B, 142, 6}, // 虫
+    {0x8840, 143, 6}, // 血
+    {0x884C, 144, 6}, // 行
+    {0x8863, 145, 6}, // 衣
+    {0x8864, 145, 6}, // 衤
+    {0x897E, 146, 6}, // 襾
+    {0x897F, 146, 6}, // 西
+    {0x8980, 146, 6}, // 覀
+    {0x898B, 147, 7}, // 見
+    {0x89D2, 148, 7}, // 角
+    {0x8A00, 149, 7}, // 言
+    {0x8A01, 149, 7}, // 訁
+    {0x8C37, 150, 7}, // 谷
+    {0x8C46, 151, 7}, // 豆
+    {0x8C55, 152, 7}, // 豕
+    {0x8C78, 153, 7}, // 豸
+    {0x8C9D, 154, 7}, // 貝
+    {0x8D64, 155, 7}, // 赤
+    {0x8D70, 156, 7}, // 走
+    {0x8D71, 156, 7}, // 赱
+    {0x8DB3, 157, 7}, // 足
+    {0x8EAB, 158, 7}, // 身
+    {0x8ECA, 159, 7}, // 車
+    {0x8F9B, 160, 7}, // 辛
+    {0x8FB0, 161, 7}, // 辰
+    {0x8FB5, 162, 7}, // 辵
+    {0x8FB6, 162, 7}, // 辶
+    {0x9091, 163, 7}, // 邑
+    {0x9149, 164, 7}, // 酉
+    {0x91C6, 165, 7}, // 釆
+    {0x91CC, 166, 7}, // 里
+    {0x91D1, 167, 8}, // 金
+    {0x91D2, 167, 8}, // 釒
+    {0x9577, 168, 8}, // 長
+    {0x9578, 168, 8}, // 镸
+    {0x9580, 169, 8}, // 門
+    {0x961C, 170, 8}, // 阜
+    {0x961D, 170, 8}, // 阝
+    {0x96B6, 171, 8}, // 隶
+    {0x96B9, 172, 8}, // 隹
+    {0x96E8, 173, 8}, // 雨
+    {0x9751, 174, 8}, // 靑
+    {0x9752, 174, 8}, // 青
+    {0x975E, 175, 8}, // 非
+    {0x9762, 176, 9}, // 面
+    {0x9763, 176, 9}, // 靣
+    {0x9769, 177, 9}, // 革
+    {0x97CB, 178, 9}, // 韋
+    {0x97ED, 179, 9}, // 韭
+    {0x97F3, 180, 9}, // 音
+    {0x9801, 181, 9}, // 頁
+    {0x98A8, 182, 9}, // 風
+    {0x98DB, 183, 9}, // 飛
+    {0x98DF, 184, 9}, // 食
+    {0x98E0, 184, 9}, // 飠
+    {0x9996, 185, 9}, // 首
+    {0x9999, 186, 9}, // 香
+    {0x99AC, 187, 10}, // 馬
+    {0x9AA8, 188, 10}, // 骨
+    {0x9AD8, 189, 10}, // 高
+    {0x9AD9, 189, 10}, // 髙
+    {0x9ADF, 190, 10}, // 髟
+    {0x9B25, 191, 10}, // 鬥
+    {0x9B2F, 192, 10}, // 鬯
+    {0x9B32, 193, 10}, // 鬲
+    {0x9B3C, 194, 10}, // 鬼
+    {0x9B5A, 195, 11}, // 魚
+    {0x9CE5, 196, 11}, // 鳥
+    {0x9E75, 197, 11}, // 鹵
+    {0x9E7F, 198, 11}, // 鹿
+    {0x9EA5, 199, 11}, // 麥
+    {0x9EBB, 200, 11}, // 麻
+    {0x9EC3, 201, 12}, // 黃
+    {0x9ECD, 202, 12}, // 黍
+    {0x9ED1, 203, 12}, // 黑
+    {0x9ED2, 203, 12}, // 黒
+    {0x9EF9, 204, 12}, // 黹
+    {0x9EFD, 205, 13}, // 黽
+    {0x9F0E, 206, 13}, // 鼎
+    {0x9F13, 207, 13}, // 鼓
+    {0x9F20, 208, 13}, // 鼠
+    {0x9F3B, 209, 14}, // 鼻
+    {0x9F4A, 210, 14}, // 齊
+    {0x9F52, 211, 15}, // 齒
+    {0x9F8D, 212, 16}, // 龍
+    {0x9F9C, 213, 16}, // 龜
+    {0x9FA0, 214, 17}, // 龠
+    {0x9FB5, 64, 4}  // 龵
 };
 
+const RadicalCharacter *Radicals::find(unsigned int unicode)
+{
+    unsigned int begin = 0;
+    unsigned int end = charactersSize;
+    while(begin < end)
+    {
+        unsigned int middle = (begin + end) / 2;
+        if(characters[middle].unicode < unicode)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    if(begin < charactersSize && characters[begin].unicode == unicode)
+        return &characters[begin];
+    return 0;
+}
@@ -1,11 +1,29 @@
 #ifndef RADICALS_H
 #define RADICALS_H
 
-#include <QString>
+// one character of the radical tables
+struct RadicalCharacter {
+    unsigned short unicode;
+    unsigned char radical;
+    unsigned char strokes;
+};
 
+// Static tables of the classical radicals, compiled in rather than parsed.
 struct Radicals {
-    static const QString radicals[];
     static const unsigned int radicalsSize = 214;
+    static const unsigned int variantsSize = 62;
+    static const unsigned int charactersSize = 275;
+
+    // radical n is at index n - 1
+    static const RadicalCharacter radicals[radicalsSize];
+    // the variants of radical n are variants[variantOffsets[n - 1]] to variants[variantOffsets[n]] excluded
+    static const unsigned short variantOffsets[radicalsSize + 1];
+    static const unsigned short variants[variantsSize];
+    // masters and variants, sorted by code point
+    static const RadicalCharacter characters[charactersSize];
+
+    // binary search of characters, 0 if the code point is no radical
+    static const RadicalCharacter *find(unsigned int unicode);
 };
 
 #endif // RADICALS_H
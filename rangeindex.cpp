@@ -0,0 +1,156 @@
+#include "rangeindex.h"
+#include "memoryusage.h"
+#include <QMap>
+#include <QList>
+
+RangeIndex::RangeIndex() : sorted(true)
+{
+}
+
+void RangeIndex::clear()
+{
+    ids.clear();
+    values.clear();
+    offsets.clear();
+    sorted = true;
+}
+
+void RangeIndex::build(const QVector<Kanji *> &all, Attribute attribute)
+{
+    QVector<unsigned int> column(all.size(), 0);
+    foreach(Kanji *k, all)
+        column[k->getId()] = attribute(k);
+    buildColumn(column);
+}
+
+void RangeIndex::build(const QVector<quint16> &column)
+{
+    QVector<unsigned int> widened(column.size());
+    for(int id = 0; id < column.size(); ++id)
+        widened[id] = column.at(id);
+    buildColumn(widened);
+}
+
+void RangeIndex::buildColumn(const QVector<unsigned int> &column)
+{
+    clear();
+    // a counting pass, then each kanji goes to its slot
+    QMap<unsigned int, int> counts;
+    foreach(unsigned int value, column)
+    {
+        if(value > 0)
+            ++counts[value];
+    }
+    values.reserve(counts.size());
+    offsets.reserve(counts.size() + 1);
+    int offset = 0;
+    QMapIterator<unsigned int, int> i(counts);
+    while(i.hasNext())
+    {
+        i.next();
+        values.append(i.key());
+        offsets.append(offset);
+        offset += i.value();
+    }
+    offsets.append(offset);
+
+    ids.resize(offset);
+    QVector<int> next = offsets;
+    // the id order is kept within a value
+    for(int id = 0; id < column.size(); ++id)
+    {
+        if(column.at(id) > 0)
+            ids[next[lowerBound(column.at(id))]++] = id;
+    }
+    for(int j = 1; j < ids.size() && sorted; ++j)
+        sorted = ids.at(j - 1) < ids.at(j);
+}
+
+void RangeIndex::build(const QMap<unsigned int, QVector<KanjiId> > &postings)
+{
+    clear();
+    values.reserve(postings.size());
+    offsets.reserve(postings.size() + 1);
+    QMapIterator<unsigned int, QVector<KanjiId> > i(postings);
+    while(i.hasNext())
+    {
+        i.next();
+        if(i.key() == 0 || i.value().isEmpty())
+            continue;
+        if(!ids.isEmpty() && ids.last() >= i.value().first())
+            sorted = false;
+        values.append(i.key());
+        offsets.append(ids.size());
+        ids += i.value();
+    }
+    offsets.append(ids.size());
+    ids.squeeze();
+}
+
+int RangeIndex::lowerBound(unsigned int value) const
+{
+    int begin = 0;
+    int end = values.size();
+    while(begin < end)
+    {
+        int middle = (begin + end) / 2;
+        if(values.at(middle) < value)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return begin;
+}
+
+void RangeIndex::find(unsigned int low, unsigned int high, KanjiIdSet &set) const
+{
+    if(low > high || values.isEmpty())
+        return;
+    int firstValue = lowerBound(low);
+    int lastValue = high == 0xFFFFFFFF ? values.size() : lowerBound(high + 1);
+    if(firstValue >= lastValue)
+        return;
+    if(sorted || lastValue - firstValue == 1)
+    {
+        int first = offsets.at(firstValue);
+        set.unite(KanjiIdSet::fromSortedIds(ids.mid(first, offsets.at(lastValue) - first)));
+        return;
+    }
+    // the runs of the values are merged two by two, each id goes through log2(runs) merges
+    QList<KanjiIdSet> runs;
+    for(int v = firstValue; v < lastValue; ++v)
+        runs << KanjiIdSet::fromSortedIds(ids.mid(offsets.at(v), offsets.at(v + 1) - offsets.at(v)));
+    while(runs.size() > 1)
+    {
+        QList<KanjiIdSet> merged;
+        for(int r = 0; r + 1 < runs.size(); r += 2)
+            merged << runs[r].unite(runs.at(r + 1));
+        if(runs.size() % 2 == 1)
+            merged << runs.last();
+        runs = merged;
+    }
+    set.unite(runs.first());
+}
+
+int RangeIndex::count(unsigned int low, unsigned int high) const
+{
+    if(low > high || values.isEmpty())
+        return 0;
+    int last = high == 0xFFFFFFFF ? ids.size() : offsets.at(lowerBound(high + 1));
+    return last - offsets.at(lowerBound(low));
+}
+
+unsigned int RangeIndex::getMinimum() const
+{
+    return values.isEmpty() ? 0 : values.first();
+}
+
+unsigned int RangeIndex::getMaximum() const
+{
+    return values.isEmpty() ? 0 : values.last();
+}
+
+quint64 RangeIndex::memoryUsage() const
+{
+    return MemoryUsage::vector(ids) + MemoryUsage::vector(values) + MemoryUsage::vector(offsets);
+}
@@ -0,0 +1,47 @@
+#ifndef RANGEINDEX_H
+#define RANGEINDEX_H
+
+#include <QVector>
+#include <QMap>
+#include "kanjiidset.h"
+
+// Kanjis sorted on one numeric attribute, with the offset of each distinct value.
+// Any interval of values is a slice of the sorted array, made of one run of ascending ids per value.
+// Kanjis with a value of 0, meaning unknown, are left out.
+class RangeIndex
+{
+public:
+    typedef unsigned int (*Attribute)(const Kanji *);
+
+    RangeIndex();
+    void clear();
+    // kanjis by id
+    void build(const QVector<Kanji *> &kanjis, Attribute);
+    // values by id
+    void build(const QVector<quint16> &column);
+    // kanjis by value, a kanji may have several values
+    void build(const QMap<unsigned int, QVector<KanjiId> > &postings);
+    // the kanjis valued from low to high, both included
+    void find(unsigned int low, unsigned int high, KanjiIdSet &set) const;
+    // number of ids valued from low to high, without building them
+    int count(unsigned int low, unsigned int high) const;
+    unsigned int getMinimum() const;
+    unsigned int getMaximum() const;
+    quint64 memoryUsage() const;
+
+private:
+    // single valued, column[id] is the value of the kanji id
+    void buildColumn(const QVector<unsigned int> &column);
+    // first index of the values not less than value
+    int lowerBound(unsigned int value) const;
+
+    QVector<KanjiId> ids;
+    // ids ascending across values too, as when the ids follow the attribute, any slice is then a set
+    bool sorted;
+    // distinct values in ascending order, the kanjis of values[i] are
+    // ids[offsets[i]] to ids[offsets[i+1]] excluded
+    QVector<unsigned int> values;
+    QVector<int> offsets;
+};
+
+#endif // RANGEINDEX_H
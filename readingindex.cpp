@@ -0,0 +1,115 @@
+#include "readingindex.h"
+#include "readingmeaninggroup.h"
+#include "romaji.h"
+#include "memoryusage.h"
+#include <QSet>
+
+void ReadingIndex::clear()
+{
+    nodes.clear();
+}
+
+void ReadingIndex::build(const QVector<Kanji *> &kanjis)
+{
+    nodes.clear();
+    nodes.append(Node());
+    foreach(Kanji *k, kanjis)
+    {
+        foreach(ReadingMeaningGroup *group, k->getReadingMeaningGroups())
+        {
+            foreach(const QString &on, group->getOnReadings())
+                insert(RomajiAutomaton::toHiragana(on).remove('-'), k->getId());
+            foreach(const QString &kun, group->getKunReadings())
+            {
+                QString reading = RomajiAutomaton::toHiragana(kun).remove('-');
+                int okurigana = reading.indexOf('.');
+                if(okurigana != -1)
+                {
+                    insert(reading.left(okurigana), k->getId());
+                    reading.remove(okurigana, 1);
+                }
+                insert(reading, k->getId());
+            }
+        }
+    }
+    nodes.squeeze();
+}
+
+void ReadingIndex::insert(const QString &reading, KanjiId id)
+{
+    if(reading.isEmpty())
+        return;
+    int node = 0;
+    foreach(QChar c, reading)
+    {
+        int next = nodes.at(node).children.value(c, -1);
+        if(next == -1)
+        {
+            next = nodes.size();
+            nodes[node].children.insert(c, next);
+            nodes.append(Node());
+        }
+        node = next;
+    }
+    // the readings of a kanji are inserted one after the other
+    QVector<KanjiId> &readers = nodes[node].ids;
+    if(readers.isEmpty() || readers.last() != id)
+        readers.append(id);
+}
+
+int ReadingIndex::walk(int node, const QString &s) const
+{
+    foreach(QChar c, s)
+    {
+        node = nodes.at(node).children.value(c, -1);
+        if(node == -1)
+            break;
+    }
+    return node;
+}
+
+void ReadingIndex::match(const RomajiAutomaton &automaton, KanjiIdSet &set) const
+{
+    if(nodes.isEmpty())
+        return;
+    // (automaton state, trie node) pairs, each visited once
+    QSet<quint64> visited;
+    QList<quint64> pending;
+    QVector<KanjiId> matched;
+    pending << 0;
+    visited << 0;
+    while(!pending.isEmpty())
+    {
+        quint64 pair = pending.takeLast();
+        int state = pair >> 32;
+        int node = pair & 0xFFFFFFFF;
+        if(state == automaton.getFinalState())
+            matched += nodes.at(node).ids;
+        foreach(const RomajiAutomaton::Edge &edge, automaton.getEdges(state))
+        {
+            int next = walk(node, edge.kana);
+            if(next == -1)
+                continue;
+            quint64 nextPair = ((quint64) edge.to << 32) | next;
+            if(!visited.contains(nextPair))
+            {
+                visited << nextPair;
+                pending << nextPair;
+            }
+        }
+    }
+    set.unite(KanjiIdSet::fromIds(matched));
+}
+
+int ReadingIndex::getNodeCount() const
+{
+    return nodes.size();
+}
+
+quint64 ReadingIndex::memoryUsage() const
+{
+    quint64 bytes = MemoryUsage::vector(nodes);
+    foreach(const Node &node, nodes)
+        bytes += MemoryUsage::mapNodes(node.children) + MemoryUsage::vector(node.ids);
+    return bytes;
+}
@@ -0,0 +1,41 @@
+#ifndef READINGINDEX_H
+#define READINGINDEX_H
+
+#include <QMap>
+#include <QVector>
+#include <QChar>
+#include "kanjiidset.h"
+
+class RomajiAutomaton;
+
+// Trie of the on and kun readings of every kanji, in hiragana.
+// A kun reading is stored with and without its okurigana ("あい.する" as あい
+// and あいする), prefix and suffix marks are dropped.
+// A query walks the trie and a romaji automaton together, every reading is
+// matched in the same pass.
+class ReadingIndex
+{
+public:
+    void clear();
+    // kanjis by id
+    void build(const QVector<Kanji *> &kanjis);
+    // the kanjis having a reading spelled by the automaton
+    void match(const RomajiAutomaton &, KanjiIdSet &) const;
+    int getNodeCount() const;
+    quint64 memoryUsage() const;
+
+private:
+    struct Node
+    {
+        QMap<QChar, int> children;
+        QVector<KanjiId> ids;
+    };
+
+    void insert(const QString &reading, KanjiId id);
+    // walks the characters of s from node, -1 if the trie has no such path
+    int walk(int node, const QString &s) const;
+
+    QVector<Node> nodes;
+};
+
+#endif // READINGINDEX_H
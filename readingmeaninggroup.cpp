@@ -1,4 +1,21 @@
 #include "readingmeaninggroup.h"
+#include "memoryusage.h"
+#include <QString>
+
+static const char *languageCodes[ReadingMeaningGroup::languageCount] = {"en", "fr", "es", "pt"};
+
+int ReadingMeaningGroup::languageOf(const QString &code)
+{
+    for(int i = 0; i < languageCount; ++i)
+        if(code == languageCodes[i])
+            return i;
+    return -1;
+}
+
+QString ReadingMeaningGroup::codeOf(Language language)
+{
+    return QString(languageCodes[language]);
+}
 
 ReadingMeaningGroup::ReadingMeaningGroup()
 {
@@ -6,22 +23,40 @@ ReadingMeaningGroup::ReadingMeaningGroup()
 
 QDataStream &operator >>(QDataStream &stream, ReadingMeaningGroup &rmg)
 {
-    stream >> rmg.onReadings;
-    stream >> rmg.kunReadings;
-    stream >> rmg.englishMeanings;
-    stream >> rmg.frenchMeanings;
+    rmg.readReadings(stream);
+    rmg.readMeanings(stream);
     return stream;
 }
 
 QDataStream &operator <<(QDataStream &stream, const ReadingMeaningGroup &rmg)
 {
-    stream << rmg.onReadings;
-    stream << rmg.kunReadings;
-    stream << rmg.englishMeanings;
-    stream << rmg.frenchMeanings;
+    rmg.writeReadings(stream);
+    rmg.writeMeanings(stream);
     return stream;
 }
 
+void ReadingMeaningGroup::readReadings(QDataStream &stream)
+{
+    stream >> onReadings;
+    stream >> kunReadings;
+}
+
+void ReadingMeaningGroup::writeReadings(QDataStream &stream) const
+{
+    stream << onReadings;
+    stream << kunReadings;
+}
+
+void ReadingMeaningGroup::readMeanings(QDataStream &stream)
+{
+    stream >> meanings;
+}
+
+void ReadingMeaningGroup::writeMeanings(QDataStream &stream) const
+{
+    stream << meanings;
+}
+
 const QSet<QString> & ReadingMeaningGroup::getOnReadings()
 {
     return onReadings;
@@ -42,22 +77,57 @@ void ReadingMeaningGroup::addKunReading(const QString &kunReading)
     kunReadings.insert(kunReading);
 }
 
+const QSet<QString> & ReadingMeaningGroup::getMeanings(Language language) const
+{
+    static const QSet<QString> none;
+    QMap<quint8, QSet<QString> >::const_iterator i = meanings.constFind(language);
+    return i == meanings.constEnd() ? none : i.value();
+}
+
+void ReadingMeaningGroup::addMeaning(Language language, const QString &meaning)
+{
+    meanings[language].insert(meaning);
+}
+
 const QSet<QString> & ReadingMeaningGroup::getFrenchMeanings()
 {
-    return frenchMeanings;
+    return getMeanings(french);
 }
 
 void ReadingMeaningGroup::addFrenchMeaning(const QString &frenchMeaning)
 {
-    frenchMeanings.insert(frenchMeaning);
+    addMeaning(french, frenchMeaning);
 }
 
 const QSet<QString> & ReadingMeaningGroup::getEnglishMeanings()
 {
-    return englishMeanings;
+    return getMeanings(english);
 }
 
 void ReadingMeaningGroup::addEnglishMeaning(const QString &englishMeaning)
 {
-    englishMeanings.insert(englishMeaning);
+    addMeaning(english, englishMeaning);
+}
+
+void ReadingMeaningGroup::retainLanguages(quint32 mask)
+{
+    QMap<quint8, QSet<QString> >::iterator i = meanings.begin();
+    while(i != meanings.end())
+    {
+        if(mask & (1 << i.key()))
+            ++i;
+        else
+            i = meanings.erase(i);
+    }
+}
+
+quint64 ReadingMeaningGroup::memoryUsage() const
+{
+    quint64 bytes = sizeof(ReadingMeaningGroup)
+            + MemoryUsage::set(onReadings)
+            + MemoryUsage::set(kunReadings)
+            + MemoryUsage::mapNodes(meanings);
+    foreach(const QSet<QString> &set, meanings)
+        bytes += MemoryUsage::set(set);
+    return bytes;
 }
@@ -2,6 +2,7 @@
 #define READINGMEANINGGROUP_H
 
 #include <QSet>
+#include <QMap>
 #include <QDataStream>
 
 class QString;
@@ -9,25 +10,44 @@ class QString;
 class ReadingMeaningGroup
 {
 public:
+    // m_lang of kanjidic2 meanings, a meaning without m_lang is English
+    enum Language { english, french, spanish, portuguese, languageCount };
+    // masks of languages have the bit 1 << language set
+    static const quint32 allLanguages = (1 << languageCount) - 1;
+    // -1 for a language kanjidic2 does not have
+    static int languageOf(const QString &code);
+    static QString codeOf(Language);
+
     ReadingMeaningGroup();
+    void addMeaning(Language, const QString &);
     void addFrenchMeaning(const QString &);
     void addEnglishMeaning(const QString &);
     void addOnReading(const QString &);
     void addKunReading(const QString &);
     const QSet<QString> & getOnReadings();
     const QSet<QString> & getKunReadings();
+    // empty for a language not loaded
+    const QSet<QString> & getMeanings(Language) const;
     const QSet<QString> & getFrenchMeanings();
     const QSet<QString> & getEnglishMeanings();
+    // drops the meanings of the languages out of the mask
+    void retainLanguages(quint32 mask);
+    // estimated bytes held by the group
+    quint64 memoryUsage() const;
 
     friend QDataStream &operator >>(QDataStream &stream, ReadingMeaningGroup &rmg);
     friend QDataStream &operator <<(QDataStream &stream, const ReadingMeaningGroup &rmg);
+    // the readings and the meanings are streamed apart by the index
+    void readReadings(QDataStream &);
+    void writeReadings(QDataStream &) const;
+    void readMeanings(QDataStream &);
+    void writeMeanings(QDataStream &) const;
 
 private:
     QSet<QString> onReadings;
     QSet<QString> kunReadings;
-    QSet<QString> englishMeanings;
-    QSet<QString> frenchMeanings;
-    // other languages to come???
+    // only the languages having meanings take room
+    QMap<quint8, QSet<QString> > meanings;
 };
 
 #endif // READINGMEANINGGROUP_H
@@ -0,0 +1,189 @@
+#include "romaji.h"
+#include <cstring>
+
+struct RomajiSyllable
+{
+    const char *romaji;
+    ushort kana[2];
+};
+
+// Hepburn and Kunrei spellings, a romaji may appear twice when it spells two kana
+static const RomajiSyllable syllables[] = {
+    // vowels
+    {"a", {0x3042, 0}}, {"i", {0x3044, 0}}, {"u", {0x3046, 0}}, {"e", {0x3048, 0}},
+    {"o", {0x304A, 0}},
+    // k row
+    {"ka", {0x304B, 0}}, {"ki", {0x304D, 0}}, {"ku", {0x304F, 0}}, {"ke", {0x3051, 0}},
+    {"ko", {0x3053, 0}}, {"kya", {0x304D, 0x3083}}, {"kyu", {0x304D, 0x3085}}, {"kyo", {0x304D, 0x3087}},
+    // g row
+    {"ga", {0x304C, 0}}, {"gi", {0x304E, 0}}, {"gu", {0x3050, 0}}, {"ge", {0x3052, 0}},
+    {"go", {0x3054, 0}}, {"gya", {0x304E, 0x3083}}, {"gyu", {0x304E, 0x3085}}, {"gyo", {0x304E, 0x3087}},
+    // s row
+    {"sa", {0x3055, 0}}, {"shi", {0x3057, 0}}, {"si", {0x3057, 0}}, {"su", {0x3059, 0}},
+    {"se", {0x305B, 0}}, {"so", {0x305D, 0}}, {"sha", {0x3057, 0x3083}}, {"sya", {0x3057, 0x3083}},
+    {"shu", {0x3057, 0x3085}}, {"syu", {0x3057, 0x3085}}, {"sho", {0x3057, 0x3087}}, {"syo", {0x3057, 0x3087}},
+    // z row
+    {"za", {0x3056, 0}}, {"ji", {0x3058, 0}}, {"zi", {0x3058, 0}}, {"zu", {0x305A, 0}},
+    {"ze", {0x305C, 0}}, {"zo", {0x305E, 0}}, {"ja", {0x3058, 0x3083}}, {"jya", {0x3058, 0x3083}},
+    {"zya", {0x3058, 0x3083}}, {"ju", {0x3058, 0x3085}}, {"jyu", {0x3058, 0x3085}}, {"zyu", {0x3058, 0x3085}},
+    {"jo", {0x3058, 0x3087}}, {"jyo", {0x3058, 0x3087}}, {"zyo", {0x3058, 0x3087}},
+    // t row
+    {"ta", {0x305F, 0}}, {"chi", {0x3061, 0}}, {"ti", {0x3061, 0}}, {"tsu", {0x3064, 0}},
+    {"tu", {0x3064, 0}}, {"te", {0x3066, 0}}, {"to", {0x3068, 0}}, {"cha", {0x3061, 0x3083}},
+    {"tya", {0x3061, 0x3083}}, {"chu", {0x3061, 0x3085}}, {"tyu", {0x3061, 0x3085}}, {"cho", {0x3061, 0x3087}},
+    {"tyo", {0x3061, 0x3087}},
+    // d row
+    {"da", {0x3060, 0}}, {"ji", {0x3062, 0}}, {"di", {0x3062, 0}}, {"zu", {0x3065, 0}},
+    {"du", {0x3065, 0}}, {"de", {0x3067, 0}}, {"do", {0x3069, 0}}, {"ja", {0x3062, 0x3083}},
+    {"dya", {0x3062, 0x3083}}, {"ju", {0x3062, 0x3085}}, {"dyu", {0x3062, 0x3085}}, {"jo", {0x3062, 0x3087}},
+    {"dyo", {0x3062, 0x3087}},
+    // n row
+    {"na", {0x306A, 0}}, {"ni", {0x306B, 0}}, {"nu", {0x306C, 0}}, {"ne", {0x306D, 0}},
+    {"no", {0x306E, 0}}, {"nya", {0x306B, 0x3083}}, {"nyu", {0x306B, 0x3085}}, {"nyo", {0x306B, 0x3087}},
+    {"n'", {0x3093, 0}}, {"nn", {0x3093, 0}},
+    // h row
+    {"ha", {0x306F, 0}}, {"hi", {0x3072, 0}}, {"fu", {0x3075, 0}}, {"hu", {0x3075, 0}},
+    {"he", {0x3078, 0}}, {"ho", {0x307B, 0}}, {"hya", {0x3072, 0x3083}}, {"hyu", {0x3072, 0x3085}},
+    {"hyo", {0x3072, 0x3087}},
+    // b row
+    {"ba", {0x3070, 0}}, {"bi", {0x3073, 0}}, {"bu", {0x3076, 0}}, {"be", {0x3079, 0}},
+    {"bo", {0x307C, 0}}, {"bya", {0x3073, 0x3083}}, {"byu", {0x3073, 0x3085}}, {"byo", {0x3073, 0x3087}},
+    // p row
+    {"pa", {0x3071, 0}}, {"pi", {0x3074, 0}}, {"pu", {0x3077, 0}}, {"pe", {0x307A, 0}},
+    {"po", {0x307D, 0}}, {"pya", {0x3074, 0x3083}}, {"pyu", {0x3074, 0x3085}}, {"pyo", {0x3074, 0x3087}},
+    // m row
+    {"ma", {0x307E, 0}}, {"mi", {0x307F, 0}}, {"mu", {0x3080, 0}}, {"me", {0x3081, 0}},
+    {"mo", {0x3082, 0}}, {"mya", {0x307F, 0x3083}}, {"myu", {0x307F, 0x3085}}, {"myo", {0x307F, 0x3087}},
+    // y row
+    {"ya", {0x3084, 0}}, {"yu", {0x3086, 0}}, {"yo", {0x3088, 0}},
+    // r row
+    {"ra", {0x3089, 0}}, {"ri", {0x308A, 0}}, {"ru", {0x308B, 0}}, {"re", {0x308C, 0}},
+    {"ro", {0x308D, 0}}, {"rya", {0x308A, 0x3083}}, {"ryu", {0x308A, 0x3085}}, {"ryo", {0x308A, 0x3087}},
+    // w row
+    {"wa", {0x308F, 0}}, {"wi", {0x3090, 0}}, {"we", {0x3091, 0}}, {"wo", {0x3092, 0}},
+    {"o", {0x3092, 0}},
+};
+static const int syllableCount = sizeof(syllables) / sizeof(RomajiSyllable);
+
+static const ushort hatsuon = 0x3093;
+static const ushort sokuon = 0x3063;
+static const ushort kanaA = 0x3042;
+static const ushort kanaI = 0x3044;
+static const ushort kanaU = 0x3046;
+static const ushort kanaE = 0x3048;
+static const ushort kanaO = 0x304A;
+
+RomajiAutomaton::RomajiAutomaton()
+{
+}
+
+void RomajiAutomaton::addEdge(int from, int to, const QString &kana)
+{
+    Edge edge;
+    edge.to = to;
+    edge.kana = kana;
+    edges[from].append(edge);
+}
+
+static inline QString kanaString(const ushort kana[2])
+{
+    return QString::fromUtf16(kana, kana[1] ? 2 : 1);
+}
+
+bool RomajiAutomaton::compile(const QString &romaji)
+{
+    // a long vowel becomes its vowel followed by '^', which is then read as a second vowel
+    QString input;
+    foreach(QChar c, romaji.toLower())
+    {
+        switch(c.unicode())
+        {
+        case 0x0101: case 0x00E2: input += "a^"; break;
+        case 0x012B: case 0x00EE: input += "i^"; break;
+        case 0x016B: case 0x00FB: input += "u^"; break;
+        case 0x0113: case 0x00EA: input += "e^"; break;
+        case 0x014D: case 0x00F4: input += "o^"; break;
+        default: input += c;
+        }
+    }
+    // anything else than ASCII turns into '?', which no syllable reads
+    QByteArray latin = input.toLatin1();
+    int size = latin.size();
+    edges.clear();
+    edges.resize(size + 1);
+
+    for(int i = 0; i < size; ++i)
+    {
+        const char *at = latin.constData() + i;
+        for(int s = 0; s < syllableCount; ++s)
+        {
+            int length = strlen(syllables[s].romaji);
+            if(i + length <= size && strncmp(at, syllables[s].romaji, length) == 0)
+                addEdge(i, i + length, kanaString(syllables[s].kana));
+        }
+        char c = at[0];
+        char following = i + 1 < size ? at[1] : 0;
+        // a lone n is ん, so is m before b, p and m in older Hepburn ("shimbun")
+        if(c == 'n' || (c == 'm' && following != 0 && strchr("bpm", following)))
+            addEdge(i, i + 1, QString(QChar(hatsuon)));
+        // doubled consonants and "tch" start with っ
+        if(following != 0 && c == following && strchr("bcdfghjkprstwz", c))
+            addEdge(i, i + 1, QString(QChar(sokuon)));
+        if(c == 't' && following == 'c' && i + 2 < size && at[2] == 'h')
+            addEdge(i, i + 1, QString(QChar(sokuon)));
+        if(c == '^' && i > 0)
+        {
+            switch(at[-1])
+            {
+            case 'a': addEdge(i, i + 1, QString(QChar(kanaA))); break;
+            case 'i': addEdge(i, i + 1, QString(QChar(kanaI))); break;
+            case 'u': addEdge(i, i + 1, QString(QChar(kanaU))); break;
+            // ē is えい or ええ, ō is おう or おお
+            case 'e':
+                addEdge(i, i + 1, QString(QChar(kanaI)));
+                addEdge(i, i + 1, QString(QChar(kanaE)));
+                break;
+            case 'o':
+                addEdge(i, i + 1, QString(QChar(kanaU)));
+                addEdge(i, i + 1, QString(QChar(kanaO)));
+                break;
+            }
+        }
+    }
+
+    // edges only go forward, one pass tells whether the end is reachable
+    QVector<bool> reachable(size + 1, false);
+    reachable[0] = size > 0;
+    for(int i = 0; i < size; ++i)
+        if(reachable.at(i))
+            foreach(const Edge &edge, edges.at(i))
+                reachable[edge.to] = true;
+    return reachable.at(size);
+}
+
+int RomajiAutomaton::getStateCount() const
+{
+    return edges.size();
+}
+
+int RomajiAutomaton::getFinalState() const
+{
+    return edges.size() - 1;
+}
+
+const QList<RomajiAutomaton::Edge> &RomajiAutomaton::getEdges(int state) const
+{
+    return edges.at(state);
+}
+
+QString RomajiAutomaton::toHiragana(const QString &s)
+{
+    QString hiragana(s);
+    for(int i = 0; i < hiragana.size(); ++i)
+    {
+        ushort u = hiragana.at(i).unicode();
+        if(u >= 0x30A1 && u <= 0x30F6)
+            hiragana[i] = QChar(u - 0x60);
+    }
+    return hiragana;
+}
@@ -0,0 +1,39 @@
+#ifndef ROMAJI_H
+#define ROMAJI_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+
+// Every hiragana spelling of a romaji input, as an automaton.
+// States are the positions in the input, an edge reads a romaji syllable and
+// spells it in kana. Hepburn and Kunrei spellings are both accepted ("shi", "si"),
+// ambiguous input keeps all its readings: "n" is ん or starts the な row, "ji" is
+// じ or ぢ, and a long vowel written ō or ô is おう or おお.
+class RomajiAutomaton
+{
+public:
+    struct Edge
+    {
+        int to;
+        QString kana;
+    };
+
+    RomajiAutomaton();
+
+    // false if no kana spelling covers the whole input
+    bool compile(const QString &romaji);
+    int getStateCount() const;
+    int getFinalState() const;
+    const QList<Edge> &getEdges(int state) const;
+
+    // katakana to hiragana, other characters are kept
+    static QString toHiragana(const QString &);
+
+private:
+    void addEdge(int from, int to, const QString &kana);
+
+    QVector<QList<Edge> > edges;
+};
+
+#endif // ROMAJI_H
@@ -0,0 +1,655 @@
+#include <QtTest/QtTest>
+#include <QBuffer>
+#include <QDomDocument>
+#include "kanjidb.h"
+#include "romaji.h"
+#include "querystatistics.h"
+#include "textannotator.h"
+#include "querysession.h"
+#include "radicals.h"
+#include "syntheticdictionary.h"
+
+// what the generated kanjidic2 says of one kanji, read straight from the XML
+struct Entry
+{
+    Unicode unicode;
+    // "strokes", "grade", "jlpt", "freq", "deroo" and the dr_type of each dic_ref, 0 when absent
+    QMap<QString, unsigned int> values;
+    unsigned int skip[3];
+    // in hiragana, kun readings with and without their okurigana
+    QStringList readings;
+};
+
+// receives the batches of an annotator in one vector
+class CollectingSink : public AnnotationSink
+{
+public:
+    void annotations(const Annotation *batch, int count)
+    {
+        for(int i = 0; i < count; ++i)
+            all.append(batch[i]);
+    }
+
+    QVector<Annotation> all;
+};
+
+// Checks that the indexed and batched search paths give the results a plain
+// scan of the dictionary gives. The reference results are computed from the
+// generated XML, not from the database.
+class KanjiDBTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void romajiSpellings_data();
+    void romajiSpellings();
+    void romajiApostrophe();
+    void romajiSearch();
+    void ranges_data();
+    void ranges();
+    void skip_data();
+    void skip();
+    void searchBatch();
+    void batchStatistics();
+    void radicalVariants();
+    void session_data();
+    void session();
+    void sessionReuse();
+    void annotate_data();
+    void annotate();
+
+private:
+    void readEntries();
+    QList<Unicode> unicodes(const KanjiIdSet &) const;
+    QList<Unicode> unicodes(const KanjiSet &) const;
+    QStringList batchQueries() const;
+    QString annotatedText(int length) const;
+    QVector<Annotation> expectedAnnotations(const QString &text, TextAnnotator::Encoding) const;
+    static QByteArray encode(const QString &, TextAnnotator::Encoding);
+    static void compareAnnotations(const QVector<Annotation> &actual, const QVector<Annotation> &expected);
+    static QSet<QString> spellings(const QString &romaji);
+    static QString hiragana(const QString &);
+    static QList<Unicode> sorted(const QSet<Unicode> &);
+
+    SyntheticDictionary *dictionary;
+    KanjiDB *db;
+    QList<Entry> entries;
+};
+
+static const unsigned int scale = 10;
+
+void KanjiDBTest::initTestCase()
+{
+    dictionary = new SyntheticDictionary(scale);
+    db = new KanjiDB;
+    // every search is evaluated, not answered from the cache
+    db->setQueryCacheSize(0);
+    QBuffer kanjiDic(const_cast<QByteArray *>(&dictionary->getKanjiDic2()));
+    kanjiDic.open(QIODevice::ReadOnly);
+    QVERIFY2(db->readKanjiDic(&kanjiDic), qPrintable(db->errorString()));
+    QBuffer radK(const_cast<QByteArray *>(&dictionary->getRadKFileX()));
+    radK.open(QIODevice::ReadOnly | QIODevice::Text);
+    QVERIFY2(db->readRadK(&radK), qPrintable(db->errorString()));
+    readEntries();
+    QCOMPARE((unsigned int) entries.size(), dictionary->getCharacterCount());
+}
+
+void KanjiDBTest::cleanupTestCase()
+{
+    delete db;
+    delete dictionary;
+}
+
+void KanjiDBTest::readEntries()
+{
+    QDomDocument document;
+    QVERIFY(document.setContent(dictionary->getKanjiDic2()));
+    QDomElement character = document.documentElement().firstChildElement("character");
+    while(!character.isNull())
+    {
+        Entry entry;
+        QString literal = character.firstChildElement("literal").text();
+        int i = 0;
+        entry.unicode = Kanji::codePointAt(literal, i);
+
+        QDomElement misc = character.firstChildElement("misc");
+        entry.values["strokes"] = misc.firstChildElement("stroke_count").text().toUInt();
+        entry.values["grade"] = misc.firstChildElement("grade").text().toUInt();
+        entry.values["jlpt"] = misc.firstChildElement("jlpt").text().toUInt();
+        entry.values["freq"] = misc.firstChildElement("freq").text().toUInt();
+
+        QDomElement child = character.firstChildElement("dic_number").firstChildElement("dic_ref");
+        for(; !child.isNull(); child = child.nextSiblingElement("dic_ref"))
+            entry.values[child.attribute("dr_type")] = child.text().toUInt();
+
+        entry.skip[0] = entry.skip[1] = entry.skip[2] = 0;
+        child = character.firstChildElement("query_code").firstChildElement("q_code");
+        for(; !child.isNull(); child = child.nextSiblingElement("q_code"))
+        {
+            if(child.attribute("qc_type") == "skip")
+            {
+                QStringList fields = child.text().split('-');
+                for(int f = 0; f < 3; ++f)
+                    entry.skip[f] = fields.at(f).toUInt();
+            } else if(child.attribute("qc_type") == "deroo")
+                entry.values["deroo"] = child.text().toUInt();
+        }
+
+        child = character.firstChildElement("reading_meaning").firstChildElement("rmgroup").firstChildElement("reading");
+        for(; !child.isNull(); child = child.nextSiblingElement("reading"))
+        {
+            QString reading = hiragana(child.text());
+            if(child.attribute("r_type") == "ja_on")
+                entry.readings << reading;
+            else if(child.attribute("r_type") == "ja_kun")
+            {
+                int okurigana = reading.indexOf('.');
+                if(okurigana != -1)
+                    entry.readings << reading.left(okurigana);
+                entry.readings << reading.remove('.');
+            }
+        }
+        entries << entry;
+        character = character.nextSiblingElement("character");
+    }
+}
+
+QString KanjiDBTest::hiragana(const QString &s)
+{
+    QString result;
+    foreach(QChar c, s)
+    {
+        if(c.unicode() >= 0x30A1 && c.unicode() <= 0x30F6)
+            result.append(QChar(c.unicode() - 0x60));
+        else
+            result.append(c);
+    }
+    return result;
+}
+
+QList<Unicode> KanjiDBTest::sorted(const QSet<Unicode> &set)
+{
+    QList<Unicode> list = set.toList();
+    qSort(list);
+    return list;
+}
+
+QList<Unicode> KanjiDBTest::unicodes(const KanjiIdSet &ids) const
+{
+    QSet<Unicode> set;
+    foreach(KanjiId id, ids)
+        set << db->getById(id)->getUnicode();
+    return sorted(set);
+}
+
+QList<Unicode> KanjiDBTest::unicodes(const KanjiSet &kanjis) const
+{
+    QSet<Unicode> set;
+    foreach(const Kanji *k, kanjis)
+        set << k->getUnicode();
+    return sorted(set);
+}
+
+// every kana string the automaton spells from its first state to its final one
+QSet<QString> KanjiDBTest::spellings(const QString &romaji)
+{
+    RomajiAutomaton automaton;
+    QSet<QString> result;
+    if(!automaton.compile(romaji))
+        return result;
+    QList<QPair<int, QString> > pending;
+    pending << qMakePair(0, QString());
+    while(!pending.isEmpty())
+    {
+        QPair<int, QString> path = pending.takeLast();
+        if(path.first == automaton.getFinalState())
+            result << path.second;
+        foreach(const RomajiAutomaton::Edge &edge, automaton.getEdges(path.first))
+            pending << qMakePair(edge.to, path.second + edge.kana);
+    }
+    return result;
+}
+
+void KanjiDBTest::romajiSpellings_data()
+{
+    QTest::addColumn<QString>("hepburn");
+    QTest::addColumn<QString>("kunrei");
+    QTest::newRow("shi") << "shi" << "si";
+    QTest::newRow("chi") << "chi" << "ti";
+    QTest::newRow("tsu") << "tsu" << "tu";
+    QTest::newRow("fu") << "fu" << "hu";
+    QTest::newRow("sha") << "shashin" << "syasin";
+    QTest::newRow("cho") << "chotto" << "tyotto";
+    QTest::newRow("shimbun") << "shimbun" << "sinbun";
+}
+
+// Hepburn and Kunrei spellings of a word spell the same kana
+void KanjiDBTest::romajiSpellings()
+{
+    QFETCH(QString, hepburn);
+    QFETCH(QString, kunrei);
+    QSet<QString> expected = spellings(kunrei);
+    QVERIFY(!expected.isEmpty());
+    QCOMPARE(spellings(hepburn), expected);
+}
+
+void KanjiDBTest::romajiApostrophe()
+{
+    // n' is only ん, a lone n may also start the な row
+    QSet<QString> separated = spellings("kan'i");
+    QCOMPARE(separated.size(), 1);
+    QVERIFY(separated.contains(QString::fromUtf8("かんい")));
+    QSet<QString> joined = spellings("kani");
+    QVERIFY(joined.contains(QString::fromUtf8("かに")));
+    QVERIFY(joined.contains(QString::fromUtf8("かんい")));
+    QVERIFY(!spellings("kan'a").contains(QString::fromUtf8("かな")));
+}
+
+void KanjiDBTest::romajiSearch()
+{
+    QString hepburn = dictionary->sampleValue(KanjiDB::romajiKey);
+    QVERIFY(!hepburn.isEmpty());
+    QString kunrei = QString(hepburn).replace("shi", "si").replace("chi", "ti").replace("tsu", "tu");
+    QSet<QString> kana = spellings(hepburn);
+
+    QSet<Unicode> expected;
+    foreach(const Entry &entry, entries)
+        foreach(const QString &reading, entry.readings)
+            if(kana.contains(reading))
+                expected << entry.unicode;
+    QVERIFY(!expected.isEmpty());
+
+    KanjiIdSet found;
+    db->search(KanjiDB::romajiKey + hepburn, found);
+    QCOMPARE(unicodes(found), sorted(expected));
+    KanjiIdSet foundKunrei;
+    db->search(KanjiDB::romajiKey + kunrei, foundKunrei);
+    QCOMPARE(unicodes(foundKunrei), sorted(expected));
+}
+
+void KanjiDBTest::ranges_data()
+{
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<QString>("attribute");
+    QTest::addColumn<unsigned int>("low");
+    QTest::addColumn<unsigned int>("high");
+    const unsigned int any = 0xFFFFFFFF;
+    QTest::newRow("strokes<") << "strokes<8" << "strokes" << 1u << 7u;
+    QTest::newRow("strokes>") << "strokes>12" << "strokes" << 13u << any;
+    QTest::newRow("strokes<=") << "strokes<=8" << "strokes" << 1u << 8u;
+    QTest::newRow("strokes>=") << "strokes>=10" << "strokes" << 10u << any;
+    QTest::newRow("strokes range") << "strokes=5..9" << "strokes" << 5u << 9u;
+    QTest::newRow("strokes~") << "strokes~10" << "strokes"
+                              << 10 - KanjiDB::strokeTolerance << 10 + KanjiDB::strokeTolerance;
+    QTest::newRow("grade<=") << "grade<=3" << "grade" << 1u << 3u;
+    QTest::newRow("grade>") << "grade>6" << "grade" << 7u << any;
+    QTest::newRow("grade range") << "grade=2..5" << "grade" << 2u << 5u;
+    QTest::newRow("jlpt>=") << "jlpt>=3" << "jlpt" << 3u << any;
+    QTest::newRow("jlpt<") << "jlpt<2" << "jlpt" << 1u << 1u;
+    QTest::newRow("freq<=") << "freq<=20" << "freq" << 1u << 20u;
+    QTest::newRow("freq>") << "freq>20" << "freq" << 21u << any;
+    QTest::newRow("freq range") << "freq=5..50" << "freq" << 5u << 50u;
+    QTest::newRow("deroo range") << "deroo=100..900" << "deroo" << 100u << 900u;
+    QTest::newRow("heisig range") << "ref.heisig=1..50" << "heisig" << 1u << 50u;
+    QTest::newRow("heisig>=") << "ref.heisig>=1900" << "heisig" << 1900u << any;
+    QTest::newRow("nelson_c<") << "ref.nelson_c<100" << "nelson_c" << 1u << 99u;
+}
+
+// range index lookups give what a linear filter on the attribute gives
+void KanjiDBTest::ranges()
+{
+    QFETCH(QString, query);
+    QFETCH(QString, attribute);
+    QFETCH(unsigned int, low);
+    QFETCH(unsigned int, high);
+
+    QSet<Unicode> expected;
+    foreach(const Entry &entry, entries)
+    {
+        unsigned int value = entry.values.value(attribute);
+        if(value > 0 && value >= low && value <= high)
+            expected << entry.unicode;
+    }
+    QVERIFY(!expected.isEmpty());
+
+    KanjiIdSet found;
+    db->search(query, found);
+    QCOMPARE(unicodes(found), sorted(expected));
+    // the same through the KanjiSet search
+    KanjiSet kanjis;
+    db->search(query, kanjis);
+    QCOMPARE(unicodes(kanjis), sorted(expected));
+}
+
+void KanjiDBTest::skip_data()
+{
+    QTest::addColumn<QString>("pattern");
+    QTest::newRow("pattern") << "1-*-*";
+    QTest::newRow("short pattern") << "3";
+    QTest::newRow("middle range") << "2-1..3-*";
+    QTest::newRow("two ranges") << "1-4..9-2..5";
+    QTest::newRow("last field") << "*-*-7";
+    QTest::newRow("last range") << "4-2-1..3";
+    QTest::newRow("open ranges") << "..2-5..-*";
+    QTest::newRow("sample") << dictionary->sampleValue(KanjiDB::skipKey);
+}
+
+// SKIP patterns give what matching each code field by field gives
+void KanjiDBTest::skip()
+{
+    QFETCH(QString, pattern);
+    QStringList fields = pattern.split('-');
+    while(fields.size() < 3)
+        fields << "*";
+    unsigned int low[3], high[3];
+    for(int f = 0; f < 3; ++f)
+    {
+        low[f] = 0;
+        high[f] = 0xFFFFFFFF;
+        if(fields.at(f) == "*")
+            continue;
+        int separator = fields.at(f).indexOf(KanjiDB::rangeSeparator);
+        if(separator == -1)
+        {
+            low[f] = high[f] = fields.at(f).toUInt();
+            continue;
+        }
+        QString first = fields.at(f).left(separator);
+        QString last = fields.at(f).mid(separator + KanjiDB::rangeSeparator.size());
+        if(!first.isEmpty())
+            low[f] = first.toUInt();
+        if(!last.isEmpty())
+            high[f] = last.toUInt();
+    }
+
+    QSet<Unicode> expected;
+    foreach(const Entry &entry, entries)
+    {
+        bool matched = true;
+        for(int f = 0; f < 3; ++f)
+            matched = matched && entry.skip[f] >= low[f] && entry.skip[f] <= high[f];
+        if(matched)
+            expected << entry.unicode;
+    }
+    QVERIFY(!expected.isEmpty());
+
+    KanjiIdSet found;
+    db->search(KanjiDB::skipKey + pattern, found);
+    QCOMPARE(unicodes(found), sorted(expected));
+}
+
+QStringList KanjiDBTest::batchQueries() const
+{
+    QStringList queries;
+    for(int i = 0; i < KanjiDB::keyCount; ++i)
+    {
+        QString value = dictionary->sampleValue(KanjiDB::allKeys[i]);
+        if(!value.isEmpty())
+            queries << KanjiDB::allKeys[i] + value;
+    }
+    queries << KanjiDB::jlptKey + "2&" + KanjiDB::gradeKey + "3"
+            << KanjiDB::jlptKey + "2," + KanjiDB::gradeKey + "3"
+            << KanjiDB::strokesLessKey + "8&" + KanjiDB::skipKey + "1-*-*," + KanjiDB::jlptKey + "1"
+            << KanjiDB::gradeKey + "2," + KanjiDB::gradeKey + "4&" + KanjiDB::strokesMoreKey + "6"
+            << dictionary->sampleText(5)
+            << "refXheisig=1";
+    return queries;
+}
+
+// a batch answers each query as search() does, whatever it shares between them
+void KanjiDBTest::searchBatch()
+{
+    QStringList queries = batchQueries();
+    // duplicates and the empty query go through the batch too
+    queries << queries.first() << "" << queries.at(queries.size() - 2);
+
+    QList<KanjiIdSet> ids;
+    db->searchBatch(queries, ids);
+    QCOMPARE(ids.size(), queries.size());
+    QList<KanjiSet> sets;
+    db->searchBatch(queries, sets);
+    QCOMPARE(sets.size(), queries.size());
+    for(int i = 0; i < queries.size(); ++i)
+    {
+        KanjiIdSet expectedIds;
+        db->search(queries.at(i), expectedIds);
+        QVERIFY2(ids.at(i) == expectedIds, qPrintable(queries.at(i)));
+        // literal queries are keyed by position, keys included
+        KanjiSet expectedSet;
+        db->search(queries.at(i), expectedSet);
+        QVERIFY2(sets.at(i).keys() == expectedSet.keys(), qPrintable(queries.at(i)));
+    }
+}
+
+// the statistics of a batch are those of its queries searched one by one
+void KanjiDBTest::batchStatistics()
+{
+    QStringList queries = batchQueries();
+    QueryStatistics single, batch;
+    db->setQueryStatistics(&single);
+    foreach(const QString &query, queries)
+    {
+        KanjiIdSet set;
+        db->search(query, set);
+    }
+    db->setQueryStatistics(&batch);
+    QList<KanjiIdSet> results;
+    db->searchBatch(queries, results);
+    db->setQueryStatistics(0);
+
+    QCOMPARE(batch.getKeyTypes(), single.getKeyTypes());
+    foreach(const QString &keyType, single.getKeyTypes())
+    {
+        KeyStatistics expected = single.getKeyStatistics(keyType);
+        KeyStatistics actual = batch.getKeyStatistics(keyType);
+        QVERIFY2(actual.count == expected.count, qPrintable(keyType));
+        QVERIFY2(actual.totalSetSize == expected.totalSetSize, qPrintable(keyType));
+        QVERIFY2(actual.maxSetSize == expected.maxSetSize, qPrintable(keyType));
+        QVERIFY2(actual.setSizes == expected.setSizes, qPrintable(keyType));
+    }
+}
+
+// radicals are not kanjis of the database, their variants are still found
+void KanjiDBTest::radicalVariants()
+{
+    int found = 0;
+    for(unsigned int n = 1; n <= Radicals::radicalsSize; ++n)
+    {
+        const Kanji *radical = db->getRadicalById(n);
+        QVERIFY(radical != 0);
+        QSet<Unicode> expected;
+        foreach(Unicode u, radical->getUnicodeVariants())
+            if(db->getByUnicode(u))
+                expected << u;
+        KanjiSet variants;
+        db->findVariants(radical, variants);
+        QCOMPARE(unicodes(variants), sorted(expected));
+        found += variants.size();
+    }
+    // some radical variants are among the generated kanjis
+    QVERIFY(found > 0);
+}
+
+void KanjiDBTest::session_data()
+{
+    QTest::addColumn<QStringList>("queries");
+    QString typed = KanjiDB::jlptKey + "2&" + KanjiDB::gradeKey + "3&" + KanjiDB::strokesMoreKey + "8";
+    QStringList prefixes;
+    for(int i = 1; i <= typed.size(); ++i)
+        prefixes << typed.left(i);
+    QTest::newRow("typing") << prefixes;
+    // the same key groups, combined one way then the other
+    QString jlpt = KanjiDB::jlptKey + "2";
+    QString grade = KanjiDB::gradeKey + "3";
+    QString strokes = KanjiDB::strokesMoreKey + "8";
+    QTest::newRow("alternating") << (QStringList()
+            << jlpt + "," + grade << jlpt + "&" + grade << jlpt + "," + grade
+            << jlpt + "," + grade + "&" + strokes << jlpt + "&" + grade + "&" + strokes
+            << jlpt + "&" + grade + "," + strokes << jlpt + "," + grade + "," + strokes
+            << grade + "&" + jlpt << grade + "," + jlpt);
+}
+
+// a session answers every query as search() does, whatever it kept from the previous ones
+void KanjiDBTest::session()
+{
+    QFETCH(QStringList, queries);
+    QuerySession session(*db);
+    foreach(const QString &query, queries)
+    {
+        KanjiIdSet expected;
+        db->search(query, expected);
+        KanjiIdSet found;
+        QVERIFY(session.search(query, found));
+        QVERIFY2(found == expected, qPrintable(query));
+        KanjiSet expectedSet, foundSet;
+        db->search(query, expectedSet);
+        QVERIFY(session.search(query, foundSet));
+        QVERIFY2(foundSet.keys() == expectedSet.keys(), qPrintable(query));
+    }
+}
+
+void KanjiDBTest::sessionReuse()
+{
+    QString jlpt = KanjiDB::jlptKey + "2";
+    QString grade = KanjiDB::gradeKey + "3";
+    QString strokes = KanjiDB::strokesMoreKey + "8";
+    QuerySession session(*db);
+    KanjiIdSet set;
+    session.search(jlpt + "&" + grade, set);
+    set.clear();
+    session.search(jlpt + "&" + grade + "&" + strokes, set);
+    QCOMPARE(session.getReusedGroups(), 2);
+    // grade=3 is now intersected, not united: only jlpt=2 is kept
+    set.clear();
+    session.search(jlpt + "," + grade + "&" + strokes, set);
+    QCOMPARE(session.getReusedGroups(), 1);
+
+    // a read of the database drops what the session kept
+    QByteArray index;
+    QBuffer buffer(&index);
+    buffer.open(QIODevice::WriteOnly);
+    QVERIFY2(db->writeIndex(&buffer), qPrintable(db->errorString()));
+    buffer.close();
+    buffer.open(QIODevice::ReadOnly);
+    QVERIFY2(db->readIndex(&buffer), qPrintable(db->errorString()));
+    set.clear();
+    session.search(jlpt + "," + grade + "&" + strokes + "," + grade, set);
+    QCOMPARE(session.getReusedGroups(), 0);
+    KanjiIdSet expected;
+    db->search(jlpt + "," + grade + "&" + strokes + "," + grade, expected);
+    QVERIFY(set == expected);
+}
+
+// kanjis of the database, ASCII, kana, an ideograph outside the database and a surrogate pair
+QString KanjiDBTest::annotatedText(int length) const
+{
+    QString sample = dictionary->sampleText(97);
+    QString text;
+    int i = 0;
+    while(text.size() < length)
+    {
+        text.append(sample.at(i % sample.size()));
+        switch(i % 7)
+        {
+        case 0: text.append(QLatin1String("ab ")); break;
+        case 2: text.append(QString::fromUtf8("かな")); break;
+        case 3: text.append(QChar(0x9FA0)); break;
+        case 5: text.append(QChar(QChar::highSurrogate(0x20B9F))).append(QChar(QChar::lowSurrogate(0x20B9F))); break;
+        case 6: text.append('\n'); break;
+        }
+        ++i;
+    }
+    return text;
+}
+
+QByteArray KanjiDBTest::encode(const QString &text, TextAnnotator::Encoding encoding)
+{
+    if(encoding == TextAnnotator::utf8)
+        return text.toUtf8();
+    return QByteArray((const char *) text.utf16(), 2 * text.size());
+}
+
+QVector<Annotation> KanjiDBTest::expectedAnnotations(const QString &text, TextAnnotator::Encoding encoding) const
+{
+    QVector<Annotation> expected;
+    quint64 offset = 0;
+    for(int i = 0; i < text.size(); ++i)
+    {
+        int start = i;
+        Unicode u = Kanji::codePointAt(text, i);
+        const Kanji *k = db->getByUnicode(u);
+        if(k)
+        {
+            Annotation annotation = {encoding == TextAnnotator::utf8 ? offset : (quint64) start, k->getId()};
+            expected.append(annotation);
+        }
+        offset += u < 0x80 ? 1 : u < 0x800 ? 2 : u < 0x10000 ? 3 : 4;
+    }
+    return expected;
+}
+
+void KanjiDBTest::compareAnnotations(const QVector<Annotation> &actual, const QVector<Annotation> &expected)
+{
+    QCOMPARE(actual.size(), expected.size());
+    for(int i = 0; i < actual.size(); ++i)
+    {
+        if(actual.at(i).offset != expected.at(i).offset || actual.at(i).id != expected.at(i).id)
+            QFAIL(qPrintable(QString("annotation %1: offset %2 id %3, expected offset %4 id %5").arg(i)
+                             .arg(actual.at(i).offset).arg(actual.at(i).id)
+                             .arg(expected.at(i).offset).arg(expected.at(i).id)));
+    }
+}
+
+void KanjiDBTest::annotate_data()
+{
+    QTest::addColumn<int>("encoding");
+    QTest::newRow("utf8") << (int) TextAnnotator::utf8;
+    QTest::newRow("utf16") << (int) TextAnnotator::utf16;
+}
+
+// chunk and piece boundaries fall inside code points, the offsets must not move
+void KanjiDBTest::annotate()
+{
+    QFETCH(int, encoding);
+    TextAnnotator::Encoding textEncoding = (TextAnnotator::Encoding) encoding;
+    TextAnnotator annotator(*db);
+
+    // a few chunks long
+    QString text = annotatedText(TextAnnotator::chunkSize + TextAnnotator::chunkSize / 3);
+    QByteArray data = encode(text, textEncoding);
+    QVector<Annotation> expected = expectedAnnotations(text, textEncoding);
+    QVERIFY(!expected.isEmpty());
+
+    QVector<Annotation> whole;
+    annotator.annotate(data.constData(), data.size(), textEncoding, whole);
+    compareAnnotations(whole, expected);
+
+    QVector<Annotation> parallel;
+    annotator.annotateParallel(data.constData(), data.size(), textEncoding, parallel);
+    compareAnnotations(parallel, expected);
+
+    CollectingSink batches;
+    annotator.annotateParallel(data.constData(), data.size(), textEncoding, batches);
+    compareAnnotations(batches.all, expected);
+
+    // pieces of 1 to 13 bytes for a while, then large ones
+    CollectingSink streamed;
+    AnnotationStream stream(annotator, textEncoding, streamed);
+    int position = 0;
+    for(int piece = 1; position < data.size(); piece = piece % 13 + 1)
+    {
+        int size = position < (1 << 16) ? piece : piece * 4099;
+        size = qMin(size, data.size() - position);
+        stream.feed(data.constData() + position, size);
+        position += size;
+    }
+    stream.finish();
+    compareAnnotations(streamed.all, expected);
+}
+
+QTEST_MAIN(KanjiDBTest)
+
+#include "kanjidbtest.moc"
@@ -0,0 +1,16 @@
+# -------------------------------------------------
+# KanjiDB result checks on a synthetic dictionary
+# build the library in the parent directory first
+# -------------------------------------------------
+QT += xml testlib
+QT -= gui
+TARGET = kanjidbtest
+CONFIG += console
+CONFIG -= app_bundle
+TEMPLATE = app
+INCLUDEPATH += .. ../benchmark
+LIBS += -L.. -lJapaneseDB
+PRE_TARGETDEPS += ../libJapaneseDB.a
+SOURCES += kanjidbtest.cpp \
+    ../benchmark/syntheticdictionary.cpp
+HEADERS += ../benchmark/syntheticdictionary.h
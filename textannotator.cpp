@@ -0,0 +1,320 @@
+#include "textannotator.h"
+#include "kanjidb.h"
+#include "workstealingpool.h"
+#include "tracer.h"
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+const int TextAnnotator::batchSize;
+const int TextAnnotator::chunkSize;
+const quint32 TextAnnotator::noKanji;
+
+static const int pageSize = 256;
+static const Unicode lastCodePoint = 0x10FFFF;
+
+TextAnnotator::TextAnnotator(const KanjiDB &db)
+{
+    directory.fill(-1, (lastCodePoint >> 8) + 1);
+    foreach(const Kanji *k, db.getAllKanjis())
+    {
+        Unicode unicode = k->getUnicode();
+        if(unicode > lastCodePoint)
+            continue;
+        int &page = directory[unicode >> 8];
+        if(page == -1)
+        {
+            page = pages.size() / pageSize;
+            pages.insert(pages.end(), pageSize, noKanji);
+        }
+        pages[page * pageSize + (unicode & 0xFF)] = k->getId();
+    }
+    pages.squeeze();
+}
+
+quint32 TextAnnotator::idOf(Unicode unicode) const
+{
+    if(unicode > lastCodePoint)
+        return noKanji;
+    int page = directory.at(unicode >> 8);
+    return page == -1 ? noKanji : pages.at(page * pageSize + (unicode & 0xFF));
+}
+
+bool TextAnnotator::isIdeograph(Unicode unicode)
+{
+    return (unicode >= 0x3400 && unicode <= 0x4DBF) || (unicode >= 0x4E00 && unicode <= 0x9FFF)
+            || (unicode >= 0xF900 && unicode <= 0xFAFF) || (unicode >= 0x20000 && unicode <= 0x3134F);
+}
+
+void TextAnnotator::add(Unicode unicode, quint64 offset, QVector<Annotation> &annotations, QVector<Unicode> *unknown) const
+{
+    quint32 id = idOf(unicode);
+    if(id != noKanji)
+    {
+        Annotation annotation = {offset, (KanjiId) id};
+        annotations.append(annotation);
+    } else if(unknown && isIdeograph(unicode))
+        unknown->append(unicode);
+}
+
+static inline int lowestBit(int mask)
+{
+    int bit = 0;
+    while(!(mask & 1))
+    {
+        mask >>= 1;
+        ++bit;
+    }
+    return bit;
+}
+
+// the first byte from i on that may start a CJK ideograph: the ideographs are
+// from U+3400, their UTF-8 lead byte is 0xE3 or more, continuation bytes are below
+static int skipUtf8(const uchar *data, int i, int size)
+{
+#ifdef __SSE2__
+    const __m128i threshold = _mm_set1_epi8((char) 0xE3);
+    for(; i + 16 <= size; i += 16)
+    {
+        __m128i bytes = _mm_loadu_si128((const __m128i *) (data + i));
+        // unsigned bytes >= threshold: those left unchanged by the max
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(bytes, threshold), bytes));
+        if(mask != 0)
+            return i + lowestBit(mask);
+    }
+#endif
+    for(; i < size; ++i)
+    {
+        if(data[i] >= 0xE3)
+            return i;
+    }
+    return size;
+}
+
+static inline ushort unitAt(const uchar *data, int i)
+{
+    ushort unit;
+    memcpy(&unit, data + 2 * i, sizeof(unit));
+    return unit;
+}
+
+// the first unit from i on that may be or start a CJK ideograph, U+3400 or more,
+// high surrogates included
+static int skipUtf16(const uchar *data, int i, int size)
+{
+#ifdef __SSE2__
+    // SSE2 only compares signed words, the sign bit is flipped to compare unsigned ones
+    const __m128i sign = _mm_set1_epi16((short) 0x8000);
+    const __m128i threshold = _mm_set1_epi16((short) (0x33FF ^ 0x8000));
+    for(; i + 8 <= size; i += 8)
+    {
+        __m128i units = _mm_xor_si128(_mm_loadu_si128((const __m128i *) (data + 2 * i)), sign);
+        int mask = _mm_movemask_epi8(_mm_cmpgt_epi16(units, threshold));
+        if(mask != 0)
+            return i + lowestBit(mask) / 2;
+    }
+#endif
+    for(; i < size; ++i)
+    {
+        if(unitAt(data, i) >= 0x3400)
+            return i;
+    }
+    return size;
+}
+
+int TextAnnotator::scan(const uchar *data, int size, Encoding encoding, quint64 offset,
+                        QVector<Annotation> &annotations, QVector<Unicode> *unknown) const
+{
+    if(encoding == utf16)
+        return 2 * scanUtf16(data, size / 2, offset, annotations, unknown);
+    return scanUtf8(data, size, offset, annotations, unknown);
+}
+
+int TextAnnotator::scanUtf8(const uchar *data, int size, quint64 offset, QVector<Annotation> &annotations,
+                            QVector<Unicode> *unknown) const
+{
+    int i = 0;
+    while((i = skipUtf8(data, i, size)) < size)
+    {
+        uchar lead = data[i];
+        // 0xE3 to 0xEF lead 3 bytes, 0xF0 to 0xF4 lead 4, the others are malformed
+        int length = lead < 0xF0 ? 3 : 4;
+        if(lead > 0xF4)
+        {
+            ++i;
+            continue;
+        }
+        Unicode unicode = lead & (length == 3 ? 0x0F : 0x07);
+        int j = 1;
+        for(; j < length && i + j < size && (data[i + j] & 0xC0) == 0x80; ++j)
+            unicode = (unicode << 6) | (data[i + j] & 0x3F);
+        if(j < length)
+        {
+            // cut by the end of the data, or malformed
+            if(i + j == size)
+                return i;
+            ++i;
+            continue;
+        }
+        add(unicode, offset + i, annotations, unknown);
+        i += length;
+    }
+    return size;
+}
+
+int TextAnnotator::scanUtf16(const uchar *data, int size, quint64 offset, QVector<Annotation> &annotations,
+                             QVector<Unicode> *unknown) const
+{
+    int i = 0;
+    while((i = skipUtf16(data, i, size)) < size)
+    {
+        Unicode unicode = unitAt(data, i);
+        int length = 1;
+        if((unicode & 0xFC00) == 0xD800)
+        {
+            if(i + 1 == size)
+                return i;
+            ushort low = unitAt(data, i + 1);
+            if((low & 0xFC00) == 0xDC00)
+            {
+                unicode = 0x10000 + ((unicode - 0xD800) << 10) + (low - 0xDC00);
+                length = 2;
+            }
+        }
+        add(unicode, offset + i, annotations, unknown);
+        i += length;
+    }
+    return size;
+}
+
+void TextAnnotator::annotate(const char *data, int size, Encoding encoding, QVector<Annotation> &annotations,
+                             quint64 offset) const
+{
+    TraceSpan span("annotate");
+    scan((const uchar *) data, size, encoding, offset, annotations);
+}
+
+// one chunk of a text annotated in parallel, starting on a code point
+class AnnotationTask : public WorkStealingTask
+{
+public:
+    AnnotationTask(const TextAnnotator *a, const char *d, int s, TextAnnotator::Encoding e, quint64 o)
+        : annotator(a), data(d), size(s), encoding(e), offset(o) {}
+    void run()
+    {
+        annotator->annotate(data, size, encoding, annotations, offset);
+    }
+
+    const TextAnnotator *annotator;
+    const char *data;
+    int size;
+    TextAnnotator::Encoding encoding;
+    quint64 offset;
+    QVector<Annotation> annotations;
+};
+
+// the chunk boundary at or after i that does not cut a code point
+static int chunkBoundary(const uchar *data, int i, int size, TextAnnotator::Encoding encoding)
+{
+    if(i >= size)
+        return size;
+    if(encoding == TextAnnotator::utf16)
+    {
+        // chunkSize is even, a low surrogate goes with its high one
+        if(i + 2 <= size && (unitAt(data, i / 2) & 0xFC00) == 0xDC00)
+            i += 2;
+        return qMin(i, size);
+    }
+    for(int j = 0; j < 3 && i < size && (data[i] & 0xC0) == 0x80; ++j)
+        ++i;
+    return i;
+}
+
+void TextAnnotator::annotateParallel(const char *data, int size, Encoding encoding,
+                                     QVector<Annotation> &annotations, WorkStealingPool *pool) const
+{
+    TraceSpan span("annotate parallel");
+    if(pool == 0)
+        pool = WorkStealingPool::globalInstance();
+    int shift = encoding == utf16 ? 1 : 0;
+    QList<AnnotationTask *> chunks;
+    QList<WorkStealingTask *> tasks;
+    int begin = 0;
+    while(begin < size)
+    {
+        int end = chunkBoundary((const uchar *) data, qMin(size, begin + chunkSize), size, encoding);
+        AnnotationTask *task = new AnnotationTask(this, data + begin, end - begin, encoding, begin >> shift);
+        chunks << task;
+        tasks << task;
+        begin = end;
+    }
+    pool->run(tasks);
+    // the chunks are in text order
+    foreach(AnnotationTask *chunk, chunks)
+        annotations += chunk->annotations;
+    qDeleteAll(chunks);
+}
+
+void TextAnnotator::annotateParallel(const char *data, int size, Encoding encoding, AnnotationSink &sink,
+                                     WorkStealingPool *pool) const
+{
+    QVector<Annotation> annotations;
+    annotateParallel(data, size, encoding, annotations, pool);
+    for(int i = 0; i < annotations.size(); i += batchSize)
+        sink.annotations(annotations.constData() + i, qMin(batchSize, annotations.size() - i));
+}
+
+AnnotationStream::AnnotationStream(const TextAnnotator &a, TextAnnotator::Encoding e, AnnotationSink &s)
+    : annotator(a), encoding(e), sink(s), position(0)
+{
+}
+
+void AnnotationStream::feed(const QByteArray &data)
+{
+    feed(data.constData(), data.size());
+}
+
+void AnnotationStream::feed(const char *data, int size)
+{
+    int shift = encoding == TextAnnotator::utf16 ? 1 : 0;
+    int begin = 0;
+    if(!carry.isEmpty())
+    {
+        // the cut code point is completed by at most 4 bytes of this piece,
+        // the code points that follow it in those bytes are annotated with it
+        int carried = carry.size();
+        int taken = qMin(size, 4);
+        carry.append(data, taken);
+        int used = annotator.scan((const uchar *) carry.constData(), carry.size(), encoding,
+                                  (position - carried) >> shift, pending);
+        if(used < carried)
+        {
+            // the piece was too short to complete it
+            carry.remove(0, used);
+            position += size;
+            return;
+        }
+        begin = used - carried;
+        carry.clear();
+    }
+    int used = annotator.scan((const uchar *) data + begin, size - begin, encoding, (position + begin) >> shift, pending);
+    carry = QByteArray(data + begin + used, size - begin - used);
+    position += size;
+    flush(false);
+}
+
+void AnnotationStream::finish()
+{
+    flush(true);
+    carry.clear();
+    position = 0;
+}
+
+void AnnotationStream::flush(bool all)
+{
+    int count = all ? pending.size() : pending.size() / TextAnnotator::batchSize * TextAnnotator::batchSize;
+    for(int i = 0; i < count; i += TextAnnotator::batchSize)
+        sink.annotations(pending.constData() + i, qMin(TextAnnotator::batchSize, count - i));
+    pending.remove(0, count);
+}
@@ -0,0 +1,101 @@
+#ifndef TEXTANNOTATOR_H
+#define TEXTANNOTATOR_H
+
+#include <QVector>
+#include <QByteArray>
+#include "kanji.h"
+
+class KanjiDB;
+class WorkStealingPool;
+
+// one kanji found in a text, offset is that of its first code unit:
+// a byte for UTF-8, a 16-bit unit for UTF-16, so a QString position
+struct Annotation
+{
+    quint64 offset;
+    KanjiId id;
+};
+
+// receives the annotations of a text in batches, in text order
+class AnnotationSink
+{
+public:
+    virtual ~AnnotationSink() {}
+    virtual void annotations(const Annotation *batch, int count) = 0;
+};
+
+// Finds the kanjis of a database in large texts.
+// Runs of text without CJK ideographs are skipped 16 bytes at a time with SSE2 where the
+// compiler has it, full code points are decoded, surrogate pairs and 4-byte sequences included,
+// and looked up in a table by code point built once from the database.
+// The table holds ids: the annotator must be built again after the database is read again.
+class TextAnnotator
+{
+public:
+    // UTF-16 is in host byte order, as QString::utf16()
+    enum Encoding { utf8, utf16 };
+    // annotations handed to a sink at a time
+    static const int batchSize = 4096;
+    // bytes of text per parallel task
+    static const int chunkSize = 1 << 20;
+    static const quint32 noKanji = 0xFFFFFFFF;
+
+    explicit TextAnnotator(const KanjiDB &);
+
+    // id of the kanji of a code point, noKanji if the database has none
+    quint32 idOf(Unicode) const;
+    // CJK unified and compatibility ideographs, extensions included
+    static bool isIdeograph(Unicode);
+    // appends the kanjis of a whole text to annotations, offset is added to their offsets
+    void annotate(const char *data, int size, Encoding, QVector<Annotation> &annotations, quint64 offset = 0) const;
+    // same, the text is cut into chunks annotated in parallel on the pool, the global one by default
+    void annotateParallel(const char *data, int size, Encoding, QVector<Annotation> &annotations,
+                          WorkStealingPool *pool = 0) const;
+    // same, the annotations are handed to the sink batchSize at a time
+    void annotateParallel(const char *data, int size, Encoding, AnnotationSink &, WorkStealingPool *pool = 0) const;
+
+    // annotates the complete code points of data, returns the bytes used,
+    // what is left is a code point cut by the end of data
+    // the ideographs the database does not have are appended to unknown, if given
+    int scan(const uchar *data, int size, Encoding, quint64 offset, QVector<Annotation> &annotations,
+             QVector<Unicode> *unknown = 0) const;
+
+private:
+    int scanUtf8(const uchar *data, int size, quint64 offset, QVector<Annotation> &, QVector<Unicode> *) const;
+    int scanUtf16(const uchar *data, int size, quint64 offset, QVector<Annotation> &, QVector<Unicode> *) const;
+    void add(Unicode, quint64 offset, QVector<Annotation> &, QVector<Unicode> *unknown) const;
+
+    // pages of 256 code points, only those holding kanjis are allocated
+    // directory[c >> 8] is the page of c, -1 for none
+    QVector<int> directory;
+    QVector<quint32> pages;
+};
+
+// A text annotated as it is read, in pieces of any size cut anywhere,
+// even inside a code point. Annotations go to the sink batchSize at a time.
+class AnnotationStream
+{
+public:
+    AnnotationStream(const TextAnnotator &, TextAnnotator::Encoding, AnnotationSink &);
+
+    void feed(const char *data, int size);
+    void feed(const QByteArray &);
+    // hands the last annotations to the sink and starts a new text
+    // a code point left incomplete by the last piece is dropped
+    void finish();
+
+private:
+    // the full batches only, or everything
+    void flush(bool all);
+
+    const TextAnnotator &annotator;
+    TextAnnotator::Encoding encoding;
+    AnnotationSink &sink;
+    // the bytes of a code point cut by the end of the previous piece
+    QByteArray carry;
+    // bytes fed since the start of the text
+    quint64 position;
+    QVector<Annotation> pending;
+};
+
+#endif // TEXTANNOTATOR_H
@@ -0,0 +1,120 @@
+#include "tracer.h"
+#include <QIODevice>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+#include <QHash>
+#include <QThread>
+#include <QCoreApplication>
+
+volatile bool Tracer::enabled = false;
+
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    qint64 begin;
+    qint64 end;
+    int thread;
+    QString detail;
+};
+
+struct TraceBuffer
+{
+    QMutex mutex;
+    QElapsedTimer clock;
+    QVector<TraceEvent> events;
+    // small thread numbers are easier to read than thread handles in the viewer
+    QHash<quintptr, int> threads;
+};
+
+Q_GLOBAL_STATIC(TraceBuffer, traceBuffer)
+
+void Tracer::setEnabled(bool e)
+{
+    TraceBuffer *buffer = traceBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    if(e && !buffer->clock.isValid())
+        buffer->clock.start();
+    enabled = e;
+}
+
+void Tracer::clear()
+{
+    TraceBuffer *buffer = traceBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    buffer->events.clear();
+}
+
+qint64 Tracer::now()
+{
+    return traceBuffer()->clock.nsecsElapsed();
+}
+
+void Tracer::record(const char *name, const char *category, qint64 begin, qint64 end, const QString &detail)
+{
+    TraceBuffer *buffer = traceBuffer();
+    quintptr handle = (quintptr) QThread::currentThreadId();
+    QMutexLocker locker(&buffer->mutex);
+    QHash<quintptr, int>::const_iterator it = buffer->threads.constFind(handle);
+    if(it == buffer->threads.constEnd())
+        it = buffer->threads.insert(handle, buffer->threads.size() + 1);
+    TraceEvent event;
+    event.name = name;
+    event.category = category;
+    event.begin = begin;
+    event.end = end;
+    event.thread = it.value();
+    event.detail = detail;
+    buffer->events.append(event);
+}
+
+static QByteArray jsonString(const QString &s)
+{
+    QByteArray escaped("\"");
+    QByteArray utf8 = s.toUtf8();
+    for(int i = 0; i < utf8.size(); ++i)
+    {
+        char c = utf8.at(i);
+        if(c == '"' || c == '\\')
+            escaped.append('\\').append(c);
+        else if((uchar) c < 0x20)
+            escaped.append(QString("\\u%1").arg((int) (uchar) c, 4, 16, QChar('0')).toLatin1());
+        else
+            escaped.append(c);
+    }
+    return escaped.append('"');
+}
+
+QByteArray Tracer::toJson()
+{
+    TraceBuffer *buffer = traceBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray json("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for(int i = 0; i < buffer->events.size(); ++i)
+    {
+        const TraceEvent &event = buffer->events.at(i);
+        if(i > 0)
+            json.append(",");
+        // complete events, timestamps and durations are in microseconds
+        json.append("\n{\"name\":").append(jsonString(event.name))
+                .append(",\"cat\":").append(jsonString(event.category))
+                .append(",\"ph\":\"X\",\"ts\":").append(QByteArray::number(event.begin / 1000.0, 'f', 3))
+                .append(",\"dur\":").append(QByteArray::number((event.end - event.begin) / 1000.0, 'f', 3))
+                .append(",\"pid\":").append(pid)
+                .append(",\"tid\":").append(QByteArray::number(event.thread));
+        if(!event.detail.isEmpty())
+            json.append(",\"args\":{\"detail\":").append(jsonString(event.detail)).append("}");
+        json.append("}");
+    }
+    json.append("\n]}\n");
+    return json;
+}
+
+bool Tracer::write(QIODevice *device)
+{
+    QByteArray json = toJson();
+    return device->write(json) == json.size();
+}
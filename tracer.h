@@ -0,0 +1,66 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QString>
+#include <QByteArray>
+
+class QIODevice;
+
+// Opt-in recording of nested spans (load phases, search key groups, index lookups)
+// with their thread, dumped as Chrome trace event JSON for chrome://tracing or Perfetto.
+// While disabled, which is the default, a span costs one flag test.
+class Tracer
+{
+public:
+    static void setEnabled(bool);
+    static inline bool isEnabled() { return enabled; }
+    // drops the recorded spans
+    static void clear();
+    static QByteArray toJson();
+    static bool write(QIODevice *);
+
+    // nanoseconds since tracing was first enabled
+    static qint64 now();
+    static void record(const char *name, const char *category, qint64 begin, qint64 end, const QString &detail);
+
+private:
+    static volatile bool enabled;
+};
+
+// Records a complete event from its construction to its destruction, or to finish()
+class TraceSpan
+{
+public:
+    inline TraceSpan(const char *n, const char *c = "kanjidb") : name(n), category(c), active(Tracer::isEnabled())
+    {
+        if(active)
+            begin = Tracer::now();
+    }
+    inline ~TraceSpan()
+    {
+        finish();
+    }
+    // shown in the event args, ignored when tracing is disabled
+    inline void setDetail(const QString &d)
+    {
+        if(active)
+            detail = d;
+    }
+    inline void finish()
+    {
+        if(active)
+        {
+            Tracer::record(name, category, begin, Tracer::now(), detail);
+            active = false;
+        }
+    }
+
+private:
+    const char *name;
+    const char *category;
+    bool active;
+    qint64 begin;
+    QString detail;
+};
+
+#endif // TRACER_H
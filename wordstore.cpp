@@ -0,0 +1,567 @@
+#include "wordstore.h"
+#include <QIODevice>
+#include <QFile>
+#include <QtAlgorithms>
+
+const quint32 WordStore::magic = 0x5AD5ED1C;
+const quint32 WordStore::version = 1;
+
+// magic, version, 6 table sizes, auxiliary data size
+static const int headerSize = 9 * sizeof(quint32);
+
+static int comparePooled(const ushort *a, quint32 aLength, const ushort *b, quint32 bLength)
+{
+    quint32 length = qMin(aLength, bLength);
+    for(quint32 i = 0; i < length; ++i)
+        if(a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    if(aLength == bLength)
+        return 0;
+    return aLength < bLength ? -1 : 1;
+}
+
+WordStore::WordStore() : mappedFile(0), mappedData(0)
+{
+    clear();
+}
+
+WordStore::~WordStore()
+{
+    clear();
+}
+
+void WordStore::clear()
+{
+    if(mappedFile)
+    {
+        if(mappedData)
+            mappedFile->unmap(mappedData);
+        mappedFile->close();
+        delete mappedFile;
+    }
+    mappedFile = 0;
+    mappedData = 0;
+    blob = QByteArray();
+    entries = 0;
+    strings = 0;
+    headwordIndex = readingIndex = 0;
+    kanjiIndex = 0;
+    pool = 0;
+    auxiliaryData = 0;
+    entriesSize = stringsSize = headwordIndexSize = readingIndexSize = kanjiIndexSize = poolSize = auxiliaryDataSize = 0;
+}
+
+bool WordStore::isEmpty() const
+{
+    return entriesSize == 0;
+}
+
+bool WordStore::attach(const QByteArray &data)
+{
+    clear();
+    blob = data;
+    if(!setup((const uchar *) blob.constData(), blob.size()))
+    {
+        blob = QByteArray();
+        return false;
+    }
+    return true;
+}
+
+bool WordStore::read(QIODevice *device)
+{
+    return attach(device->readAll());
+}
+
+bool WordStore::map(const QString &fileName)
+{
+    clear();
+    mappedFile = new QFile(fileName);
+    if(!mappedFile->open(QIODevice::ReadOnly))
+    {
+        error = QString("Cannot open %1").arg(fileName);
+        clear();
+        return false;
+    }
+    mappedData = mappedFile->map(0, mappedFile->size());
+    if(mappedData == 0)
+    {
+        error = QString("Cannot map %1").arg(fileName);
+        clear();
+        return false;
+    }
+    if(!setup(mappedData, mappedFile->size()))
+    {
+        QString setupError = error;
+        clear();
+        error = setupError;
+        return false;
+    }
+    return true;
+}
+
+bool WordStore::write(QIODevice *device) const
+{
+    if(blob.isEmpty() && mappedData == 0)
+    {
+        error = QString("Empty word store");
+        return false;
+    }
+    const char *data = mappedData ? (const char *) mappedData : blob.constData();
+    qint64 size = mappedData ? mappedFile->size() : blob.size();
+    if(device->write(data, size) != size)
+    {
+        error = device->errorString();
+        return false;
+    }
+    error = QString();
+    return true;
+}
+
+void WordStore::swap(WordStore &other)
+{
+    // the tables point into the blob or the mapping, whose data does not move
+    qSwap(blob, other.blob);
+    qSwap(mappedFile, other.mappedFile);
+    qSwap(mappedData, other.mappedData);
+    qSwap(entries, other.entries);
+    qSwap(strings, other.strings);
+    qSwap(headwordIndex, other.headwordIndex);
+    qSwap(readingIndex, other.readingIndex);
+    qSwap(kanjiIndex, other.kanjiIndex);
+    qSwap(pool, other.pool);
+    qSwap(auxiliaryData, other.auxiliaryData);
+    qSwap(entriesSize, other.entriesSize);
+    qSwap(stringsSize, other.stringsSize);
+    qSwap(headwordIndexSize, other.headwordIndexSize);
+    qSwap(readingIndexSize, other.readingIndexSize);
+    qSwap(kanjiIndexSize, other.kanjiIndexSize);
+    qSwap(poolSize, other.poolSize);
+    qSwap(auxiliaryDataSize, other.auxiliaryDataSize);
+}
+
+bool WordStore::setup(const uchar *data, qint64 size)
+{
+    if(size < headerSize)
+    {
+        error = QString("Truncated word store");
+        return false;
+    }
+    const quint32 *header = (const quint32 *) data;
+    if(header[0] != magic)
+    {
+        error = QString("Bad file format, not a recognized word store");
+        return false;
+    }
+    if(header[1] != version)
+    {
+        error = QString("Unsupported word store version");
+        return false;
+    }
+    quint32 sizes[6];
+    for(int i = 0; i < 6; ++i)
+        sizes[i] = header[2+i];
+    qint64 expected = headerSize
+            + (qint64) sizes[0] * sizeof(WordEntryRecord)
+            + (qint64) sizes[1] * sizeof(WordStringRef)
+            + (qint64) sizes[2] * sizeof(WordIndexItem)
+            + (qint64) sizes[3] * sizeof(WordIndexItem)
+            + (qint64) sizes[4] * sizeof(WordKanjiItem)
+            + (qint64) sizes[5] * sizeof(ushort);
+    qint64 auxiliaryOffset = (expected + 3) & ~3;
+    if(header[8] > 0)
+        expected = auxiliaryOffset + header[8];
+    if(size < expected)
+    {
+        error = QString("Truncated word store");
+        return false;
+    }
+
+    const uchar *p = data + headerSize;
+    entriesSize = sizes[0];
+    entries = (const WordEntryRecord *) p;
+    p += entriesSize * sizeof(WordEntryRecord);
+    stringsSize = sizes[1];
+    strings = (const WordStringRef *) p;
+    p += stringsSize * sizeof(WordStringRef);
+    headwordIndexSize = sizes[2];
+    headwordIndex = (const WordIndexItem *) p;
+    p += headwordIndexSize * sizeof(WordIndexItem);
+    readingIndexSize = sizes[3];
+    readingIndex = (const WordIndexItem *) p;
+    p += readingIndexSize * sizeof(WordIndexItem);
+    kanjiIndexSize = sizes[4];
+    kanjiIndex = (const WordKanjiItem *) p;
+    p += kanjiIndexSize * sizeof(WordKanjiItem);
+    poolSize = sizes[5];
+    pool = (const ushort *) p;
+    auxiliaryDataSize = header[8];
+    auxiliaryData = data + auxiliaryOffset;
+
+    if(!checkReferences())
+    {
+        error = QString("Corrupted word store");
+        return false;
+    }
+    error = QString();
+    return true;
+}
+
+// the lookups trust the tables, so every reference is checked once against the table it points into
+bool WordStore::checkReferences() const
+{
+    for(quint32 i = 0; i < stringsSize; ++i)
+        if((quint64) strings[i].offset + strings[i].length > poolSize)
+            return false;
+    for(quint32 i = 0; i < entriesSize; ++i)
+    {
+        const WordEntryRecord &record = entries[i];
+        if((quint64) record.firstString + record.headwordCount + record.readingCount + record.glossCount > stringsSize)
+            return false;
+    }
+    const WordIndexItem *indexes[2] = {headwordIndex, readingIndex};
+    quint32 indexSizes[2] = {headwordIndexSize, readingIndexSize};
+    for(int j = 0; j < 2; ++j)
+        for(quint32 i = 0; i < indexSizes[j]; ++i)
+            if(indexes[j][i].string >= stringsSize || indexes[j][i].entry >= entriesSize)
+                return false;
+    for(quint32 i = 0; i < kanjiIndexSize; ++i)
+        if(kanjiIndex[i].entry >= entriesSize)
+            return false;
+    return true;
+}
+
+quint32 WordStore::entryCount() const
+{
+    return entriesSize;
+}
+
+const WordEntryRecord &WordStore::entry(quint32 i) const
+{
+    Q_ASSERT(i < entriesSize);
+    return entries[i];
+}
+
+quint32 WordStore::stringCount() const
+{
+    return stringsSize;
+}
+
+QString WordStore::string(quint32 i) const
+{
+    Q_ASSERT(i < stringsSize);
+    const WordStringRef &ref = strings[i];
+    return QString::fromRawData((const QChar *) (pool + ref.offset), ref.length);
+}
+
+void WordStore::findString(const WordIndexItem *index, quint32 size, const QString &s, bool prefix, QVector<quint32> &result) const
+{
+    const ushort *key = s.utf16();
+    quint32 keyLength = s.size();
+    // lower bound of the key
+    quint32 first = 0, count = size;
+    while(count > 0)
+    {
+        quint32 step = count / 2;
+        const WordStringRef &ref = strings[index[first+step].string];
+        if(comparePooled(pool + ref.offset, ref.length, key, keyLength) < 0)
+        {
+            first += step + 1;
+            count -= step + 1;
+        } else
+            count = step;
+    }
+    for(quint32 i = first; i < size; ++i)
+    {
+        const WordStringRef &ref = strings[index[i].string];
+        quint32 length = prefix ? qMin(ref.length, keyLength) : ref.length;
+        if(comparePooled(pool + ref.offset, length, key, keyLength) != 0)
+            break;
+        result.append(index[i].entry);
+    }
+}
+
+void WordStore::findHeadword(const QString &s, QVector<quint32> &result) const
+{
+    findString(headwordIndex, headwordIndexSize, s, false, result);
+}
+
+void WordStore::findReading(const QString &s, bool prefix, QVector<quint32> &result) const
+{
+    findString(readingIndex, readingIndexSize, s, prefix, result);
+}
+
+void WordStore::findKanji(Unicode u, QVector<quint32> &result) const
+{
+    quint32 first = 0, count = kanjiIndexSize;
+    while(count > 0)
+    {
+        quint32 step = count / 2;
+        if(kanjiIndex[first+step].unicode < u)
+        {
+            first += step + 1;
+            count -= step + 1;
+        } else
+            count = step;
+    }
+    for(quint32 i = first; i < kanjiIndexSize && kanjiIndex[i].unicode == u; ++i)
+        result.append(kanjiIndex[i].entry);
+}
+
+const uchar *WordStore::auxiliary() const
+{
+    return auxiliaryData;
+}
+
+quint32 WordStore::auxiliarySize() const
+{
+    return auxiliaryDataSize;
+}
+
+const QString WordStore::errorString() const
+{
+    return error;
+}
+
+// sorts index items by their pooled string, entries in file order for equal strings
+struct PooledStringLessThan
+{
+    PooledStringLessThan(const QVector<WordStringRef> &s, const QVector<ushort> &p)
+        : strings(s.constData()), pool(p.constData()) {}
+
+    bool operator()(const WordIndexItem &a, const WordIndexItem &b) const
+    {
+        const WordStringRef &ra = strings[a.string];
+        const WordStringRef &rb = strings[b.string];
+        int c = comparePooled(pool + ra.offset, ra.length, pool + rb.offset, rb.length);
+        if(c != 0)
+            return c < 0;
+        return a.entry < b.entry;
+    }
+
+    const WordStringRef *strings;
+    const ushort *pool;
+};
+
+static bool kanjiItemLessThan(const WordKanjiItem &a, const WordKanjiItem &b)
+{
+    if(a.unicode != b.unicode)
+        return a.unicode < b.unicode;
+    return a.entry < b.entry;
+}
+
+WordStoreBuilder::WordStoreBuilder()
+{
+}
+
+quint32 WordStoreBuilder::addString(const QString &s)
+{
+    WordStringRef ref;
+    ref.offset = pool.size();
+    ref.length = s.size();
+    const ushort *data = s.utf16();
+    for(int i = 0; i < s.size(); ++i)
+        pool.append(data[i]);
+    strings.append(ref);
+    return strings.size() - 1;
+}
+
+const QString WordStoreBuilder::string(quint32 i) const
+{
+    const WordStringRef &ref = strings.at(i);
+    return QString((const QChar *) (pool.constData() + ref.offset), ref.length);
+}
+
+void WordStoreBuilder::setAuxiliary(const QByteArray &data)
+{
+    auxiliary = data;
+}
+
+quint32 WordStoreBuilder::addEntry(quint32 sequence, quint16 flags, const QStringList &headwords,
+                                   const QStringList &readings, const QStringList &glosses)
+{
+    WordEntryRecord record;
+    record.sequence = sequence;
+    record.firstString = strings.size();
+    record.headwordCount = headwords.size();
+    record.readingCount = readings.size();
+    record.glossCount = glosses.size();
+    record.flags = flags;
+    quint32 index = entries.size();
+
+    foreach(const QString &s, headwords)
+    {
+        addString(s);
+        for(int i = 0; i < s.size(); ++i)
+        {
+            Unicode u = Kanji::codePointAt(s, i);
+            if(isIdeograph(u))
+            {
+                WordKanjiItem item;
+                item.unicode = u;
+                item.entry = index;
+                kanjiItems.append(item);
+            }
+        }
+    }
+    foreach(const QString &s, readings)
+        addString(s);
+    foreach(const QString &s, glosses)
+        addString(s);
+
+    entries.append(record);
+    return index;
+}
+
+quint32 WordStoreBuilder::size() const
+{
+    return entries.size();
+}
+
+QByteArray WordStoreBuilder::build()
+{
+    QVector<WordIndexItem> headwordItems, readingItems;
+    for(int i = 0; i < entries.size(); ++i)
+    {
+        const WordEntryRecord &record = entries.at(i);
+        WordIndexItem item;
+        item.entry = i;
+        for(quint32 j = 0; j < record.headwordCount; ++j)
+        {
+            item.string = record.firstString + j;
+            headwordItems.append(item);
+        }
+        for(quint32 j = 0; j < record.readingCount; ++j)
+        {
+            item.string = record.firstString + record.headwordCount + j;
+            readingItems.append(item);
+        }
+    }
+    PooledStringLessThan lessThan(strings, pool);
+    qSort(headwordItems.begin(), headwordItems.end(), lessThan);
+    qSort(readingItems.begin(), readingItems.end(), lessThan);
+
+    // a kanji appearing twice in an entry is indexed once
+    qSort(kanjiItems.begin(), kanjiItems.end(), kanjiItemLessThan);
+    QVector<WordKanjiItem> kanjiIndex;
+    kanjiIndex.reserve(kanjiItems.size());
+    for(int i = 0; i < kanjiItems.size(); ++i)
+        if(kanjiIndex.isEmpty() || kanjiIndex.last().unicode != kanjiItems.at(i).unicode
+                || kanjiIndex.last().entry != kanjiItems.at(i).entry)
+            kanjiIndex.append(kanjiItems.at(i));
+
+    quint32 header[9];
+    header[0] = WordStore::magic;
+    header[1] = WordStore::version;
+    header[2] = entries.size();
+    header[3] = strings.size();
+    header[4] = headwordItems.size();
+    header[5] = readingItems.size();
+    header[6] = kanjiIndex.size();
+    header[7] = pool.size();
+    header[8] = auxiliary.size();
+
+    QByteArray blob;
+    blob.reserve(sizeof(header)
+                 + entries.size() * sizeof(WordEntryRecord)
+                 + strings.size() * sizeof(WordStringRef)
+                 + (headwordItems.size() + readingItems.size()) * sizeof(WordIndexItem)
+                 + kanjiIndex.size() * sizeof(WordKanjiItem)
+                 + pool.size() * sizeof(ushort) + 3
+                 + auxiliary.size());
+    blob.append((const char *) header, sizeof(header));
+    blob.append((const char *) entries.constData(), entries.size() * sizeof(WordEntryRecord));
+    blob.append((const char *) strings.constData(), strings.size() * sizeof(WordStringRef));
+    blob.append((const char *) headwordItems.constData(), headwordItems.size() * sizeof(WordIndexItem));
+    blob.append((const char *) readingItems.constData(), readingItems.size() * sizeof(WordIndexItem));
+    blob.append((const char *) kanjiIndex.constData(), kanjiIndex.size() * sizeof(WordKanjiItem));
+    blob.append((const char *) pool.constData(), pool.size() * sizeof(ushort));
+    while(blob.size() % 4 != 0)
+        blob.append('\0');
+    blob.append(auxiliary);
+
+    entries.clear();
+    strings.clear();
+    kanjiItems.clear();
+    pool.clear();
+    auxiliary.clear();
+    return blob;
+}
+
+bool WordStoreBuilder::isIdeograph(Unicode u)
+{
+    return (u >= 0x3400 && u <= 0x4DBF)     // extension A
+            || (u >= 0x4E00 && u <= 0x9FFF)  // unified ideographs
+            || (u >= 0xF900 && u <= 0xFAFF)  // compatibility ideographs
+            || (u >= 0x20000 && u <= 0x2FA1F); // extensions B and later
+}
+
+// removes every parenthesized annotation, ie: '漢字(P)' -> '漢字', sets common if one was (P)
+static QString stripAnnotations(const QString &s, bool &common)
+{
+    QString result;
+    int depth = 0;
+    int start = 0;
+    for(int i = 0; i < s.size(); ++i)
+    {
+        if(s.at(i) == '(')
+        {
+            if(depth++ == 0)
+                start = i;
+        } else if(s.at(i) == ')' && depth > 0)
+        {
+            if(--depth == 0 && s.mid(start, i-start+1) == "(P)")
+                common = true;
+        } else if(depth == 0)
+            result.append(s.at(i));
+    }
+    return result.trimmed();
+}
+
+bool WordStoreBuilder::parseEdictLine(const QString &line, QStringList &headwords, QStringList &readings,
+                                      QStringList &glosses, quint32 &sequence, bool &common)
+{
+    headwords.clear();
+    readings.clear();
+    glosses.clear();
+    sequence = 0;
+    common = false;
+
+    int glossStart = line.indexOf(" /");
+    if(glossStart < 1)
+        return false;
+
+    QString head = line.left(glossStart);
+    int readingStart = head.indexOf(" [");
+    if(readingStart == -1)
+    {
+        // kana only entry, no headword
+        foreach(const QString &s, head.split(';', QString::SkipEmptyParts))
+            readings << stripAnnotations(s, common);
+    } else
+    {
+        int readingEnd = head.indexOf(']', readingStart);
+        if(readingEnd == -1)
+            return false;
+        foreach(const QString &s, head.left(readingStart).split(';', QString::SkipEmptyParts))
+            headwords << stripAnnotations(s, common);
+        foreach(const QString &s, head.mid(readingStart+2, readingEnd-readingStart-2).split(';', QString::SkipEmptyParts))
+            readings << stripAnnotations(s, common);
+    }
+
+    foreach(const QString &s, line.mid(glossStart+2).split('/', QString::SkipEmptyParts))
+    {
+        if(s.startsWith("EntL"))
+        {
+            bool ok;
+            QString number = s.mid(4);
+            if(number.endsWith('X'))
+                number.chop(1);
+            sequence = number.toUInt(&ok, 10);
+        } else if(s == "(P)")
+            common = true;
+        else
+            glosses << s;
+    }
+    return !readings.isEmpty();
+}
@@ -0,0 +1,141 @@
+#ifndef WORDSTORE_H
+#define WORDSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QByteArray>
+#include "kanji.h"
+
+class QIODevice;
+class QFile;
+
+// one dictionary entry, its strings are contiguous in the string table:
+// headwords first, then readings, then glosses
+struct WordEntryRecord
+{
+    quint32 sequence;
+    quint32 firstString;
+    quint16 headwordCount;
+    quint16 readingCount;
+    quint16 glossCount;
+    quint16 flags;
+};
+
+// a string of the pool, offset and length are counted in QChars
+struct WordStringRef
+{
+    quint32 offset;
+    quint32 length;
+};
+
+// headword and reading indexes, sorted by pooled string
+struct WordIndexItem
+{
+    quint32 string;
+    quint32 entry;
+};
+
+// contained kanji index, sorted by unicode then entry
+struct WordKanjiItem
+{
+    quint32 unicode;
+    quint32 entry;
+};
+
+// Immutable word dictionary storage.
+// Everything lives in one flat blob (header, fixed size tables, then the
+// UTF-16 string pool) so the store can be used straight from a memory
+// mapped index file without any decoding.
+class WordStore
+{
+public:
+    WordStore();
+    ~WordStore();
+
+    void clear();
+    bool isEmpty() const;
+
+    // takes a (shared) copy of a blob built by WordStoreBuilder or read from disk
+    bool attach(const QByteArray &blob);
+    bool read(QIODevice *);
+    bool map(const QString &fileName);
+    bool write(QIODevice *) const;
+    // exchanges the contents, mapping included, with the other store
+    void swap(WordStore &);
+
+    quint32 entryCount() const;
+    const WordEntryRecord &entry(quint32) const;
+    quint32 stringCount() const;
+    // no copy: the returned string points inside the pool
+    QString string(quint32) const;
+
+    void findHeadword(const QString &, QVector<quint32> &) const;
+    void findReading(const QString &, bool prefix, QVector<quint32> &) const;
+    void findKanji(Unicode, QVector<quint32> &) const;
+
+    // dictionary specific data stored after the pool, 4 bytes aligned
+    const uchar *auxiliary() const;
+    quint32 auxiliarySize() const;
+
+    const QString errorString() const;
+
+    static const quint32 magic;
+    static const quint32 version;
+
+    // entry flags, the other bits are left to the dictionary using the store
+    static const quint16 commonFlag = 0x0001;
+
+private:
+    bool setup(const uchar *data, qint64 size);
+    bool checkReferences() const;
+    void findString(const WordIndexItem *index, quint32 size, const QString &, bool prefix, QVector<quint32> &) const;
+
+    QByteArray blob;
+    QFile *mappedFile;
+    uchar *mappedData;
+
+    const WordEntryRecord *entries;
+    const WordStringRef *strings;
+    const WordIndexItem *headwordIndex;
+    const WordIndexItem *readingIndex;
+    const WordKanjiItem *kanjiIndex;
+    const ushort *pool;
+    const uchar *auxiliaryData;
+    quint32 entriesSize, stringsSize, headwordIndexSize, readingIndexSize, kanjiIndexSize, poolSize, auxiliaryDataSize;
+
+    mutable QString error;
+};
+
+// Accumulates entries while a dictionary file is streamed,
+// then sorts the indexes and lays everything out as a WordStore blob.
+class WordStoreBuilder
+{
+public:
+    WordStoreBuilder();
+
+    quint32 addEntry(quint32 sequence, quint16 flags, const QStringList &headwords,
+                     const QStringList &readings, const QStringList &glosses);
+    // string stored in the pool but not referenced by any entry
+    quint32 addString(const QString &);
+    const QString string(quint32) const;
+    void setAuxiliary(const QByteArray &);
+    quint32 size() const;
+    QByteArray build();
+
+    // EDICT format line: KANJI1;KANJI2 [KANA1;KANA2] /gloss1/gloss2/EntLnnnnnnn/
+    // annotations such as (P) or (iK) and reading restrictions are stripped,
+    // common is set when a (P) marker is found
+    static bool parseEdictLine(const QString &line, QStringList &headwords, QStringList &readings,
+                               QStringList &glosses, quint32 &sequence, bool &common);
+    static bool isIdeograph(Unicode);
+
+private:
+    QVector<WordEntryRecord> entries;
+    QVector<WordStringRef> strings;
+    QVector<WordKanjiItem> kanjiItems;
+    QVector<ushort> pool;
+    QByteArray auxiliary;
+};
+
+#endif // WORDSTORE_H
@@ -0,0 +1,137 @@
+#include "workstealingpool.h"
+#include <QThread>
+#include <QMutexLocker>
+
+class WorkStealingWorker : public QThread
+{
+public:
+    WorkStealingWorker(WorkStealingPool *p, int i) : pool(p), index(i) {}
+
+protected:
+    void run()
+    {
+        pool->work(index);
+    }
+
+private:
+    WorkStealingPool *pool;
+    int index;
+};
+
+Q_GLOBAL_STATIC(WorkStealingPool, globalPool)
+
+WorkStealingPool::WorkStealingPool(int threadCount) : queued(0), pending(0), stopping(false)
+{
+    if(threadCount < 1)
+        threadCount = qMax(QThread::idealThreadCount(), 1);
+    for(int i = 0; i < threadCount; ++i)
+        queues.append(new TaskQueue);
+    for(int i = 0; i < threadCount; ++i)
+    {
+        WorkStealingWorker *worker = new WorkStealingWorker(this, i);
+        workers.append(worker);
+        worker->start();
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        QMutexLocker locker(&stateMutex);
+        stopping = true;
+        workAvailable.wakeAll();
+    }
+    foreach(WorkStealingWorker *worker, workers)
+    {
+        worker->wait();
+        delete worker;
+    }
+    foreach(TaskQueue *queue, queues)
+        delete queue;
+}
+
+WorkStealingPool *WorkStealingPool::globalInstance()
+{
+    return globalPool();
+}
+
+int WorkStealingPool::getThreadCount() const
+{
+    return workers.size();
+}
+
+void WorkStealingPool::run(const QList<WorkStealingTask *> &tasks)
+{
+    if(tasks.isEmpty())
+        return;
+    QMutexLocker runLocker(&runMutex);
+
+    // counted before being queued, a task may be done before the last one is queued
+    pending.fetchAndAddOrdered(tasks.size());
+    queued.fetchAndAddOrdered(tasks.size());
+    // dealt round robin, stealing evens out the rest
+    int queueCount = queues.size();
+    for(int q = 0; q < queueCount; ++q)
+    {
+        QMutexLocker locker(&queues[q]->mutex);
+        for(int i = q; i < tasks.size(); i += queueCount)
+            queues[q]->tasks.append(tasks.at(i));
+    }
+
+    QMutexLocker locker(&stateMutex);
+    workAvailable.wakeAll();
+    while(pending != 0)
+        allDone.wait(&stateMutex);
+}
+
+bool WorkStealingPool::take(int worker, WorkStealingTask *&task)
+{
+    // own queue first, newest task first
+    TaskQueue *own = queues[worker];
+    {
+        QMutexLocker locker(&own->mutex);
+        if(!own->tasks.isEmpty())
+        {
+            task = own->tasks.takeLast();
+            queued.deref();
+            return true;
+        }
+    }
+    // then the oldest task of another queue
+    for(int i = 1; i < queues.size(); ++i)
+    {
+        TaskQueue *victim = queues[(worker + i) % queues.size()];
+        QMutexLocker locker(&victim->mutex);
+        if(!victim->tasks.isEmpty())
+        {
+            task = victim->tasks.takeFirst();
+            queued.deref();
+            return true;
+        }
+    }
+    return false;
+}
+
+void WorkStealingPool::work(int worker)
+{
+    forever
+    {
+        {
+            QMutexLocker locker(&stateMutex);
+            while(!stopping && queued == 0)
+                workAvailable.wait(&stateMutex);
+            if(stopping)
+                return;
+        }
+        WorkStealingTask *task;
+        while(take(worker, task))
+        {
+            task->run();
+            if(!pending.deref())
+            {
+                QMutexLocker locker(&stateMutex);
+                allDone.wakeAll();
+            }
+        }
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef WORKSTEALINGPOOL_H
+#define WORKSTEALINGPOOL_H
+
+#include <QList>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+class WorkStealingWorker;
+
+class WorkStealingTask
+{
+public:
+    virtual ~WorkStealingTask() {}
+    virtual void run() = 0;
+};
+
+// Fixed set of threads, each owning a task queue.
+// A worker runs its own tasks newest first and, once its queue is empty, steals
+// the oldest tasks of the other queues, so uneven tasks still keep every core busy.
+class WorkStealingPool
+{
+public:
+    WorkStealingPool(int threadCount = 0);
+    ~WorkStealingPool();
+
+    int getThreadCount() const;
+    // runs the tasks and returns once all of them are done
+    // tasks are not deleted, concurrent calls are run one after the other
+    void run(const QList<WorkStealingTask *> &tasks);
+
+    // shared pool sized to the number of cores
+    static WorkStealingPool *globalInstance();
+
+private:
+    friend class WorkStealingWorker;
+
+    struct TaskQueue
+    {
+        QMutex mutex;
+        QList<WorkStealingTask *> tasks;
+    };
+
+    bool take(int worker, WorkStealingTask *&task);
+    void work(int worker);
+
+    QVector<TaskQueue *> queues;
+    QList<WorkStealingWorker *> workers;
+    QMutex runMutex;
+    QMutex stateMutex;
+    QWaitCondition workAvailable;
+    QWaitCondition allDone;
+    // tasks not taken yet, tasks not finished yet
+    QAtomicInt queued;
+    QAtomicInt pending;
+    bool stopping;
+};
+
+#endif // WORKSTEALINGPOOL_H